@@ -0,0 +1,283 @@
+#include "../Engine/Namespace/RootNamespace.h"
+#include "../Engine/Namespace/Expression.h"
+#include "../Engine/Namespace/Variable.h"
+#include "../Engine/Parser/Evaluator.h"
+#include "../Engine/Parser/BoundContext.h"
+#include "../Engine/Parser/FloatContext.h"
+#include "../Utility/Timer.h"
+#include <fstream>
+
+/**
+ * Compiles expressions through OptimizingTree and Evaluator and times their evaluation over a grid of inputs,
+ * once via Evaluator::eval, via BoundContext::eval at full and at draft precision and via FloatContext::eval for
+ * the expressions that support single precision. Expressions can use the
+ * real variables x and y and the complex variable z = x+iy, which are set like the graphs do it: x and z for
+ * every evaluation, y once per row of the grid.
+ */
+
+static const char *default_expressions[] =
+{
+	// arithmetic, one token type each
+	"x+y", "x*y", "x/y", "x^y", "x²+y²", "z*z+z", "z^3", "1/z",
+	// elementary
+	"sin x", "cos x", "exp x", "ln x", "sqrt(x)", "arctan x", "sin z", "exp z", "ln z", "sqrt z",
+	// special functions
+	"gamma x", "gamma z", "erf x", "erf z", "J(2, x)", "J(2, z)", "Y(1, x)", "wp z", "Ai x",
+	// fractals
+	"mandel z", "julia(z, -0.8+0.156i)",
+	// bit hacks
+	"x xor y", "x and y", "bit(x, 3)", "ieee_m(x)",
+	// mixed
+	"sin(x)*cos(y)+exp(-x²-y²)", "sqrt(x²+y²+1)*sin(3x)*cos(3y)", "(z²+1)/(z²-1)*exp(i*abs(z))",
+	NULL
+};
+
+static const char *token_names[] = { "1RR", "1CC", "1CR", "1RC", "2RR", "2RC", "0R", "0C", "2CC", "2CR", "3RR", "3CC", "4CC" };
+
+static void usage(const char *arg0)
+{
+	printf("Usage: %s [--grid N] [--repeat R] [--range A] [--json] [--file FILE] [EXPRESSION ...]\n"
+	       "\n"
+	       "Times the evaluation of every expression (default: a list that covers the ExecToken types and the\n"
+	       "builtin functions) on an NxN grid over [-A,A]² (default 256 and 2), best of R runs (default 5).\n"
+	       "Expressions can use x, y and z = x+iy. FILE has one expression per line, # starts a comment.\n"
+	       "Reports ns/eval for Evaluator::eval, BoundContext::eval (also with draft precision) and FloatContext::eval\n"
+	       "(if the expression can be evaluated in single precision), the number of tokens per evaluation and the\n"
+	       "ExecToken types, as a table or as JSON.\n", arg0);
+}
+
+static std::string json(const std::string &s)
+{
+	std::string r = "\"";
+	for (char c : s)
+	{
+		if (c == '"' || c == '\\') r += '\\';
+		if ((unsigned char)c < 32) r += ' '; else r += c;
+	}
+	return r + "\"";
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Timing
+//----------------------------------------------------------------------------------------------------------------------
+
+struct Inputs
+{
+	int xi, yi, zi; // indexes into the context or -1
+	int n;          // grid size
+	double a;       // range
+	double coord(int i) const{ return -a + 2.0*a*i/(n > 1 ? n-1 : 1); }
+};
+
+template<typename Context, typename Eval> static double run(Context &ec, const Inputs &in, cnum &sum, Eval eval)
+{
+	double t0 = now();
+	for (int i = 0; i < in.n; ++i)
+	{
+		double v = in.coord(i);
+		if (in.yi >= 0) ec.set_input(in.yi, v);
+		for (int j = 0; j < in.n; ++j)
+		{
+			double u = in.coord(j);
+			if (in.xi >= 0) ec.set_input(in.xi, u);
+			if (in.zi >= 0) ec.set_input(in.zi, cnum(u, v));
+			eval();
+			const cnum &r = ec.output(0);
+			if (defined(r)) sum += r;
+		}
+	}
+	return now() - t0;
+}
+
+struct SingleInputs // FloatContext with the interface that run needs
+{
+	FloatContext &fc;
+	void set_input(int i, double v){ fc.set_input(i, v); }
+	void set_input(int i, const cnum &v){ fc.set_input(i, v.real()); }
+	const cnum &output(int i) const{ return fc.outputs()[i]; }
+};
+
+struct Result
+{
+	std::string expression, error;
+	double compile = 0.0;   // seconds
+	double ns_ev = 0.0, ns_bc = 0.0, ns_draft = 0.0, ns_single = -1.0; // negative if not supported
+	size_t tokens = 0, tokens_all = 0;
+	std::vector<size_t> types;
+	bool mismatch = false;
+};
+
+static void bench(Namespace &ns, const std::vector<const Variable*> &vars, const std::string &s, int n, int repeat,
+                  double a, Result &r)
+{
+	r.expression = s;
+
+	Expression *ex = new Expression;
+	ns.add(ex);
+	std::unique_ptr<Expression, std::function<void(Expression*)>> cleanup(ex, [&ns](Expression *x){ ns.remove(x); delete x; });
+
+	double t0 = now();
+	ex->strings(s);
+	Evaluator *e = ex->valid() ? ex->evaluator(vars) : NULL;
+	r.compile = now() - t0;
+	if (!e)
+	{
+		r.error = ex->result().ok ? "no evaluator" : ex->result().info;
+		return;
+	}
+	e->set_parameters(ex->usedParameters());
+
+	Inputs in{e->var_index(vars[0]), e->var_index(vars[2]), e->var_index(vars[1]), n, a};
+	int changed = std::max(in.xi, in.zi); // what changes on every evaluation
+	r.tokens     = e->tokens(changed, &r.types);
+	r.tokens_all = e->tokens(e->context().n_inputs()-1);
+	if (e->image_dimension() < 1){ r.error = "no outputs"; return; }
+
+	bool single = FloatContext::supports(*e);
+	double best_ev = 1e100, best_bc = 1e100, best_draft = 1e100, best_single = 1e100;
+	cnum sum_ev, sum_bc, sum_draft, sum_single;
+	for (int k = 0; k < repeat; ++k)
+	{
+		EvalContext ec(e->context());
+		sum_ev = 0.0;
+		best_ev = std::min(best_ev, run(ec, in, sum_ev, [&]{ e->eval(ec); }));
+
+		BoundContext bc(*e);
+		sum_bc = 0.0;
+		best_bc = std::min(best_bc, run(bc, in, sum_bc, [&]{ bc.eval(); }));
+
+		BoundContext dc(*e, true);
+		sum_draft = 0.0;
+		best_draft = std::min(best_draft, run(dc, in, sum_draft, [&]{ dc.eval(); }));
+		
+		if (!single) continue;
+		FloatContext fc(*e);
+		SingleInputs si{fc};
+		sum_single = 0.0;
+		best_single = std::min(best_single, run(si, in, sum_single, [&]{ fc.eval(); }));
+	}
+	double N = (double)n*n;
+	r.ns_ev = best_ev / N * 1e9;
+	r.ns_bc = best_bc / N * 1e9;
+	r.ns_draft = best_draft / N * 1e9;
+	if (single) r.ns_single = best_single / N * 1e9;
+	r.mismatch = !(sum_ev == sum_bc) && (defined(sum_ev) || defined(sum_bc));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// main
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+	const char *arg0 = argv[0];
+	for (const char *s = arg0; *s; ++s) if (*s == '/') arg0 = s+1;
+
+	int n = 256, repeat = 5;
+	double a = 2.0;
+	bool as_json = false;
+	std::vector<std::string> exprs;
+	for (int i = 1; i < argc; ++i)
+	{
+		const char *s = argv[i];
+		bool arg = (i+1 < argc), ok = true;
+		if      (arg && !strcmp(s, "--grid"))   ok = (n = atoi(argv[++i])) > 0;
+		else if (arg && !strcmp(s, "--repeat")) ok = (repeat = atoi(argv[++i])) > 0;
+		else if (arg && !strcmp(s, "--range"))  ok = (a = atof(argv[++i])) > 0.0;
+		else if (!strcmp(s, "--json")) as_json = true;
+		else if (arg && !strcmp(s, "--file"))
+		{
+			std::ifstream f(argv[++i]);
+			ok = f.good();
+			std::string line;
+			while (std::getline(f, line))
+			{
+				size_t c = line.find('#');
+				if (c != std::string::npos) line.erase(c);
+				if (line.find_first_not_of(" \t\r") != std::string::npos) exprs.push_back(line);
+			}
+		}
+		else if (!strcmp(s, "--help") || !strcmp(s, "-h")){ usage(arg0); return 0; }
+		else if (strncmp(s, "--", 2)) exprs.push_back(s);
+		else ok = false;
+		if (!ok)
+		{
+			fprintf(stderr, "%s: invalid argument: %s\n", arg0, s);
+			usage(arg0);
+			return 1;
+		}
+	}
+	if (exprs.empty()) for (const char **s = default_expressions; *s; ++s) exprs.push_back(*s);
+
+	RootNamespace rns;
+	Namespace *ns = new Namespace;
+	ns->link(&rns);
+	Variable *x = new Variable("x", true);  ns->add(x);
+	Variable *z = new Variable("z", false); ns->add(z);
+	Variable *y = new Variable("y", true);  ns->add(y);
+	std::vector<const Variable*> vars{x, z, y}; // fastest changing first
+
+	std::vector<Result> results(exprs.size());
+	for (size_t i = 0; i < exprs.size(); ++i)
+	{
+		bench(*ns, vars, exprs[i], n, repeat, a, results[i]);
+		if (!as_json) fprintf(stderr, "\r[%zu/%zu]", i+1, exprs.size());
+	}
+	if (!as_json) fprintf(stderr, "\r");
+	delete ns;
+
+	//------------------------------------------------------------------------------------------------------------------
+	// output
+	//------------------------------------------------------------------------------------------------------------------
+
+	if (as_json)
+	{
+		printf("{\"grid\": %d, \"range\": %g, \"repeat\": %d, \"results\": [", n, a, repeat);
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const Result &r = results[i];
+			printf("%s\n  {\"expression\": %s", i ? "," : "", json(r.expression).c_str());
+			if (!r.error.empty())
+			{
+				printf(", \"error\": %s}", json(r.error).c_str());
+				continue;
+			}
+			printf(", \"compile_us\": %.1f, \"evaluator_ns\": %.2f, \"bound_ns\": %.2f, \"draft_ns\": %.2f, "
+			       "\"single_ns\": %s, \"tokens\": %zu, \"tokens_all\": %zu, \"mismatch\": %s, \"types\": {",
+			       r.compile*1e6, r.ns_ev, r.ns_bc, r.ns_draft, r.ns_single < 0.0 ? "null" : format("%.2f", r.ns_single).c_str(),
+			       r.tokens, r.tokens_all, r.mismatch ? "true" : "false");
+			bool first = true;
+			for (size_t t = 0; t < r.types.size(); ++t)
+			{
+				if (!r.types[t]) continue;
+				printf("%s\"%s\": %zu", first ? "" : ", ", token_names[t], r.types[t]);
+				first = false;
+			}
+			printf("}}");
+		}
+		printf("\n]}\n");
+		return 0;
+	}
+
+	printf("%-36s %10s %10s %10s %10s %10s %7s %9s  %s\n", "expression", "compile/µs", "eval/ns", "bound/ns", "draft/ns",
+	       "single/ns", "tokens", "ns/token", "token types");
+	for (const Result &r : results)
+	{
+		std::string e = r.expression.length() > 36 ? r.expression.substr(0, 33) + "..." : r.expression;
+		if (!r.error.empty())
+		{
+			printf("%-36s %s\n", e.c_str(), r.error.c_str());
+			continue;
+		}
+		std::string types;
+		for (size_t t = 0; t < r.types.size(); ++t)
+		{
+			if (r.types[t]) types += format("%s%s×%zu", types.empty() ? "" : " ", token_names[t], r.types[t]);
+		}
+		std::string single = r.ns_single < 0.0 ? "-" : format("%.2f", r.ns_single);
+		printf("%-36s %10.1f %10.2f %10.2f %10.2f %10s %7zu %9.2f  %s%s\n", e.c_str(), r.compile*1e6, r.ns_ev, r.ns_bc,
+		       r.ns_draft, single.c_str(), r.tokens, r.tokens ? r.ns_bc / r.tokens : 0.0, types.c_str(),
+		       r.mismatch ? " (results differ!)" : "");
+	}
+	return 0;
+}
@@ -0,0 +1,115 @@
+#include "../Engine/Namespace/RootNamespace.h"
+#include "../Engine/Namespace/Expression.h"
+#include "../Engine/Namespace/Variable.h"
+#include "../Engine/Parser/Evaluator.h"
+#include "../Engine/Parser/BoundContext.h"
+
+/**
+ * Compiles expressions like the graphs do (including the simplification by WorkingTree::saturate) and checks
+ * their values through Evaluator::eval and BoundContext::eval. Mostly about inputs where the expression is
+ * undefined: a rewrite that is only true where both sides are defined (x/x = 1) must not make them finite.
+ * Exits with 1 if anything fails.
+ */
+
+static const double U = NAN; // expected result is nan or inf
+
+struct Check
+{
+	const char *expression;
+	cnum x, z;    // inputs, x is real
+	cnum expected; // U for undefined
+};
+
+static const Check checks[] =
+{
+	// cancellation
+	{ "x/x",           0.0,      0.0,            U },
+	{ "x/x",           INFINITY, 0.0,            U },
+	{ "x/x",           2.0,      0.0,            1.0 },
+	{ "x/x*3",         0.0,      0.0,            U },
+	{ "x*(1/x)",       0.0,      0.0,            U },
+	{ "x-x",           INFINITY, 0.0,            U },
+	{ "x-x",           NAN,      0.0,            U },
+	{ "x-x",           2.0,      0.0,            0.0 },
+	{ "exp(x)/exp(x)", 800.0,    0.0,            U },
+	{ "exp(x)/exp(x)", -800.0,   0.0,            U },
+	{ "exp(x)-exp(x)", 800.0,    0.0,            U },
+	{ "ln(x)-ln(x)",   0.0,      0.0,            U },
+	{ "z/z",           0.0,      0.0,            U },
+	{ "z/z",           0.0,      cnum(INFINITY), U },
+	{ "z/z",           0.0,      cnum(1, 1),     1.0 },
+	{ "pi/pi",         0.0,      0.0,            1.0 },
+
+	// trig
+	{ "sin(x)/tan(x)", 0.0,      0.0,            U },
+	{ "sin(x)/tan(x)", 1.0,      0.0,            cos(1.0) },
+	{ "sin(z)/cos(z)", 0.0,      cnum(1, 800),   U },
+	{ "sin(z)/cos(z)", 0.0,      cnum(1, 1),     tan(cnum(1, 1)) },
+	{ "tan(z)*cos(z)", 0.0,      cnum(0, 800),   U },
+	{ "tan(z)*cos(z)", 0.0,      cnum(1, 1),     sin(cnum(1, 1)) },
+	{ "cos(x)*tan(x)*3", 1.0,    0.0,            3.0*sin(1.0) },
+
+	// re, im
+	{ "re(i*z)",       0.0,      cnum(INFINITY), U },
+	{ "re(i*z)",       0.0,      cnum(1, 2),     -2.0 },
+	{ "im(i*z)",       0.0,      cnum(1, 2),     1.0 },
+	{ "re(z)+i*im(z)", 0.0,      cnum(1, 2),     cnum(1, 2) },
+
+	{ NULL, 0.0, 0.0, 0.0 }
+};
+
+static bool same(const cnum &r, const cnum &expected)
+{
+	if (!defined(expected)) return !defined(r);
+	return defined(r) && abs(r - expected) <= 1e-12 * (1.0 + abs(expected));
+}
+
+int main()
+{
+	RootNamespace rns;
+	Namespace *ns = new Namespace;
+	ns->link(&rns);
+	Variable *x = new Variable("x", true);  ns->add(x);
+	Variable *z = new Variable("z", false); ns->add(z);
+	std::vector<const Variable*> vars{x, z};
+
+	int n = 0, failed = 0;
+	for (const Check *c = checks; c->expression; ++c, ++n)
+	{
+		Expression *ex = new Expression;
+		ns->add(ex);
+		ex->strings(c->expression);
+		Evaluator *e = ex->valid() ? ex->evaluator(vars) : NULL;
+		if (!e)
+		{
+			printf("%s: %s\n", c->expression, ex->result().ok ? "no evaluator" : ex->result().info.c_str());
+			++failed;
+			continue;
+		}
+		e->set_parameters(ex->usedParameters());
+		int xi = e->var_index(x), zi = e->var_index(z);
+
+		EvalContext ec(e->context());
+		if (xi >= 0) ec.set_input(xi, c->x.real());
+		if (zi >= 0) ec.set_input(zi, c->z);
+		e->eval(ec);
+		cnum r_ev = ec.output(0);
+
+		BoundContext bc(*e);
+		if (xi >= 0) bc.set_input(xi, c->x.real());
+		if (zi >= 0) bc.set_input(zi, c->z);
+		bc.eval();
+		cnum r_bc = bc.output(0);
+
+		if (same(r_ev, c->expected) && same(r_bc, c->expected)) continue;
+		++failed;
+		printf("%s at x = %s, z = %s: %s (Evaluator), %s (BoundContext), expected %s\n", c->expression,
+		       to_string(c->x, rns).c_str(), to_string(c->z, rns).c_str(),
+		       to_string(r_ev, rns).c_str(), to_string(r_bc, rns).c_str(),
+		       defined(c->expected) ? to_string(c->expected, rns).c_str() : "nan or inf");
+	}
+	delete ns;
+
+	printf("%d of %d checks failed\n", failed, n);
+	return failed ? 1 : 0;
+}
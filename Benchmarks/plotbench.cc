@@ -0,0 +1,316 @@
+#include "../Linux/Document.h"
+#include "../Graphs/Graph.h"
+#include "../Graphs/Graphics/GL_Graph.h"
+#include "../Graphs/OpenGL/GL_Export.h"
+#include "../Graphs/Threading/ThreadMap.h"
+#include "../Engine/Parser/BoundContext.h"
+#include "../Utility/Preferences.h"
+#include "../Utility/Timer.h"
+#include <filesystem>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+/**
+ * Updates all graphs of some .cplot files (the "Plot Examples" by default) at fixed quality levels and thread
+ * counts and writes the timings as JSON. Every file runs in a child process of its own, so the peak memory is
+ * its own and a crash only loses that file's results.
+ */
+
+const char *
+	#include "../version.h"
+;
+
+static void usage(const char *arg0)
+{
+	printf("Usage: %s [--quality Q1,Q2,...] [--threads N1,N2,...] [--repeat R] [--size WxH] [--out FILE] [FILE|DIR ...]\n"
+	       "\n"
+	       "Loads every .cplot file (default: the \"Plot Examples\" directory), recalculates all of its\n"
+	       "visible graphs R times for every combination of quality and thread count and writes the\n"
+	       "results as JSON to stdout or FILE:\n"
+	       "  time (best of R) and median, evaluations/second, time per WorkLayer, peak memory and\n"
+	       "  the number of vertexes, triangles and line segments of the results.\n"
+	       "  --quality   default 0.25,0.5,1\n"
+	       "  --threads   default 1 and the number of cores\n"
+	       "  --repeat    default 3\n"
+	       "  --size      size of the virtual window in pixels (default 1280x720)\n", arg0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Options
+//----------------------------------------------------------------------------------------------------------------------
+
+struct Options
+{
+	std::vector<double> qualities{0.25, 0.5, 1.0};
+	std::vector<int>    threads;
+	int                 repeat = 3, W = 1280, H = 720;
+};
+
+template<typename T> static bool parse_list(const char *s, std::vector<T> &dst)
+{
+	dst.clear();
+	while (*s)
+	{
+		char *e;
+		double v = strtod(s, &e);
+		if (e == s || !(v > 0.0)) return false;
+		dst.push_back((T)v);
+		s = e;
+		if (*s == ',') ++s; else if (*s) return false;
+	}
+	return !dst.empty();
+}
+
+static std::string json(const std::string &s)
+{
+	std::string r = "\"";
+	for (char c : s)
+	{
+		if (c == '"' || c == '\\') r += '\\';
+		if ((unsigned char)c < 32) r += ' '; else r += c;
+	}
+	return r + "\"";
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// WorkLayer timing
+//----------------------------------------------------------------------------------------------------------------------
+
+struct LayerSum
+{
+	std::string name;
+	size_t units;
+	double wall, busy;
+};
+static std::vector<LayerSum> layers; // summed by name, in order of first appearance
+
+static void profiler(const LayerTiming &t)
+{
+	for (LayerSum &l : layers)
+	{
+		if (l.name != t.name) continue;
+		l.units += t.units;
+		l.wall  += t.wall;
+		l.busy  += t.busy;
+		return;
+	}
+	layers.push_back(LayerSum{t.name, t.units, t.wall, t.busy});
+}
+
+static long peak_memory() // in KB
+{
+	rusage r;
+	return getrusage(RUSAGE_SELF, &r) == 0 ? r.ru_maxrss : -1;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Running one file (in the child process)
+//----------------------------------------------------------------------------------------------------------------------
+
+static void run(const std::string &file, const Options &opt, FILE *out)
+{
+	BoundContext::count_evaluations(true);
+
+	Document doc;
+	Plot &plot = doc.plot;
+	doc.load(file);
+	plot.camera.viewport(opt.W, opt.H, plot.axis);
+	plot.update_axis();
+
+	int ng = 0;
+	for (int i = 0, n = plot.number_of_graphs(); i < n; ++i) if (!plot.graph(i)->options.hidden) ++ng;
+
+	fprintf(out, "{\"file\": %s, \"graphs\": %d, \"memory_loaded\": %ld, \"runs\": [", json(file).c_str(), ng, peak_memory());
+
+	bool first = true;
+	for (double q : opt.qualities) for (int nt : opt.threads)
+	{
+		std::vector<double> times;
+		uint64_t evals = 0;
+		layers.clear();
+		for (int r = 0; r < opt.repeat; ++r)
+		{
+			plot.recalc();
+			uint64_t e0 = BoundContext::evaluations();
+			double t0 = now();
+			plot.update_graphs(nt, q);
+			times.push_back(now() - t0);
+			evals += BoundContext::evaluations() - e0;
+		}
+		std::sort(times.begin(), times.end());
+		double best = times[0], median = times[times.size()/2];
+		evals /= opt.repeat;
+
+		GL_Export e;
+		for (int i = 0, n = plot.number_of_graphs(); i < n; ++i)
+		{
+			const Graph *g = plot.graph(i);
+			if (g->options.hidden) continue;
+			const GL_Graph *gl = g->gl_graph();
+			if (gl) gl->export_geometry(e);
+		}
+
+		fprintf(out, "%s\n  {\"quality\": %g, \"threads\": %d, \"time\": %.6f, \"time_median\": %.6f, "
+		        "\"evaluations\": %llu, \"evals_per_second\": %.0f, "
+		        "\"vertexes\": %zu, \"triangles\": %zu, \"segments\": %zu, \"images\": %zu, \"layers\": [",
+		        first ? "" : ",", q, nt, best, median,
+		        (unsigned long long)evals, best > 0.0 ? evals / best : 0.0,
+		        e.num_vertexes(), e.num_triangles(), e.num_segments(), e.num_images());
+		first = false;
+
+		for (size_t i = 0; i < layers.size(); ++i)
+		{
+			const LayerSum &l = layers[i];
+			fprintf(out, "%s{\"name\": %s, \"units\": %zu, \"wall\": %.6f, \"busy\": %.6f}", i ? ", " : "",
+			        json(l.name).c_str(), l.units / opt.repeat, l.wall / opt.repeat, l.busy / opt.repeat);
+		}
+		fprintf(out, "]}");
+	}
+	fprintf(out, "\n], \"memory_peak\": %ld}", peak_memory());
+}
+
+static bool run_child(const std::string &file, const Options &opt, std::string &result, std::string &error)
+{
+	int fd[2];
+	if (pipe(fd) != 0){ error = "pipe failed"; return false; }
+	fflush(NULL);
+	pid_t pid = fork();
+	if (pid < 0){ close(fd[0]); close(fd[1]); error = "fork failed"; return false; }
+	if (pid == 0)
+	{
+		close(fd[0]);
+		FILE *out = fdopen(fd[1], "w");
+		int ret = 0;
+		try
+		{
+			run(file, opt, out);
+		}
+		catch (std::exception &e)
+		{
+			fprintf(stderr, "%s: %s\n", file.c_str(), e.what());
+			ret = 1;
+		}
+		fclose(out);
+		_exit(ret);
+	}
+
+	close(fd[1]);
+	char buf[4096];
+	ssize_t n;
+	while ((n = read(fd[0], buf, sizeof(buf))) > 0) result.append(buf, n);
+	close(fd[0]);
+
+	int status;
+	if (waitpid(pid, &status, 0) != pid){ error = "waitpid failed"; return false; }
+	if (WIFSIGNALED(status)){ error = std::string("killed by signal ") + std::to_string(WTERMSIG(status)); return false; }
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0){ error = "failed"; return false; }
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// main
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+	namespace fs = std::filesystem;
+
+	const char *arg0 = argv[0];
+	for (const char *s = arg0; *s; ++s) if (*s == '/') arg0 = s+1;
+
+	Options opt;
+	const char *out_path = NULL;
+	std::vector<std::string> files;
+	for (int i = 1; i < argc; ++i)
+	{
+		const char *a = argv[i];
+		bool arg = (i+1 < argc), ok = true;
+		if      (arg && !strcmp(a, "--quality")) ok = parse_list(argv[++i], opt.qualities);
+		else if (arg && !strcmp(a, "--threads")) ok = parse_list(argv[++i], opt.threads);
+		else if (arg && !strcmp(a, "--repeat"))  ok = (opt.repeat = atoi(argv[++i])) > 0;
+		else if (arg && !strcmp(a, "--size"))    ok = sscanf(argv[++i], "%dx%d", &opt.W, &opt.H) == 2 && opt.W > 0 && opt.H > 0;
+		else if (arg && !strcmp(a, "--out"))     out_path = argv[++i];
+		else if (!strcmp(a, "--help") || !strcmp(a, "-h")){ usage(arg0); return 0; }
+		else if (*a != '-') files.push_back(a);
+		else ok = false;
+		if (!ok)
+		{
+			fprintf(stderr, "%s: invalid argument: %s\n", arg0, a);
+			usage(arg0);
+			return 1;
+		}
+	}
+	if (opt.threads.empty())
+	{
+		opt.threads.push_back(1);
+		if (n_cores > 1) opt.threads.push_back(n_cores);
+	}
+	if (files.empty()) files.push_back("Plot Examples");
+
+	// expand directories, sorted for reproducible output
+	std::vector<std::string> paths;
+	for (const std::string &f : files)
+	{
+		std::error_code ec;
+		if (!fs::is_directory(f, ec)){ paths.push_back(f); continue; }
+		std::vector<std::string> tmp;
+		for (auto &e : fs::directory_iterator(f, ec))
+		{
+			if (e.path().extension() == ".cplot") tmp.push_back(e.path().string());
+		}
+		std::sort(tmp.begin(), tmp.end());
+		paths.insert(paths.end(), tmp.begin(), tmp.end());
+	}
+	if (paths.empty())
+	{
+		fprintf(stderr, "%s: no files\n", arg0);
+		return 1;
+	}
+
+	FILE *out = out_path ? fopen(out_path, "w") : stdout;
+	if (!out)
+	{
+		fprintf(stderr, "%s: can't open %s\n", arg0, out_path);
+		return 1;
+	}
+
+	// pin everything that affects the timed paths to the built-in defaults (Preferences::reset would load the
+	// user's cplot.ini) and write it into the results. The children inherit them and nothing is flushed.
+	Preferences::dynamic(true);
+	Preferences::draftPrecision(false);
+	Preferences::drawNormals(false);
+	Preferences::depthSort(true);
+	Preferences::textureFiltering(false);
+	Preferences::colorSamples(1);
+	Preferences::fuseGraphs(true);
+	Preferences::profileExpressions(false);
+	Preferences::threads(-1);
+	Task::profiler = profiler;
+
+	#define B(x) ((x) ? "true" : "false")
+	fprintf(out, "{\"version\": %s, \"cores\": %d, \"size\": [%d, %d], \"repeat\": %d, \"preferences\": "
+	        "{\"dynamic\": %s, \"draftPrecision\": %s, \"drawNormals\": %s, \"depthSort\": %s, "
+	        "\"textureFiltering\": %s, \"colorSamples\": %d, \"fuseGraphs\": %s}, \"files\": [\n",
+	        json(VERSION).c_str(), n_cores, opt.W, opt.H, opt.repeat,
+	        B(Preferences::dynamic()), B(Preferences::draftPrecision()), B(Preferences::drawNormals()),
+	        B(Preferences::depthSort()), B(Preferences::textureFiltering()), Preferences::colorSamples(),
+	        B(Preferences::fuseGraphs()));
+	#undef B
+
+	int failed = 0;
+	for (size_t i = 0; i < paths.size(); ++i)
+	{
+		fprintf(stderr, "[%zu/%zu] %s\n", i+1, paths.size(), paths[i].c_str());
+		std::string result, error;
+		if (!run_child(paths[i], opt, result, error))
+		{
+			fprintf(stderr, "%s: %s: %s\n", arg0, paths[i].c_str(), error.c_str());
+			result = "{\"file\": " + json(paths[i]) + ", \"error\": " + json(error) + "}";
+			++failed;
+		}
+		fprintf(out, "%s%s", i ? ",\n" : "", result.c_str());
+	}
+	fprintf(out, "\n]}\n");
+	if (out != stdout) fclose(out);
+	return failed ? 2 : 0;
+}
@@ -241,10 +241,84 @@ void acoth(const cnum &z, cnum &r);
 void acsch(const cnum &z, cnum &r);
 void asech(const cnum &z, cnum &r);
 
+//--- fastmath.cc ------------------------------------------------------------------------------------------------------
+// approximations for draft precision (@see BaseFunction::draft), error bounds are in fastmath.cc
+
+double fast_exp(double x);
+double fast_log(double x);
+double fast_sin(double x);
+double fast_cos(double x);
+double fast_atan2(double y, double x);
+void   fast_exp(const cnum &z, cnum &r);
+void   fast_log(const cnum &z, cnum &r);
+void   fast_sin(const cnum &z, cnum &r);
+void   fast_cos(const cnum &z, cnum &r);
+void   fast_cpow(const cnum &x, const cnum &y, cnum &r);
+
+//--- single.cc --------------------------------------------------------------------------------------------------------
+// single precision variants of the real functions (@see BaseFunction::single)
+
+float flt_add(float z, float w);
+float flt_sub(float z, float w);
+float flt_mul(float z, float w);
+float flt_div(float z, float w);
+float flt_mod(float z, float w);
+float flt_negate(float z);
+float flt_invert(float z);
+float flt_is_gt(float x, float y);
+float flt_is_sm(float x, float y);
+float flt_min(float z, float w);
+float flt_max(float z, float w);
+float flt_identity(float z);
+float flt_zero(float);
+float flt_zero(float, float);
+float flt_sqrt(float x); // NAN for x < 0
+float  flt_sqr(float z);
+float flt_cube(float z);
+float flt_pow4(float z);
+float flt_pow5(float z);
+float flt_pow6(float z);
+float flt_pow7(float z);
+float flt_pow8(float z);
+float flt_pow9(float z);
+float   flt_abs(float z);
+float   flt_sgn(float z);
+float  flt_arg2(float x, float y);
+float flt_round(float z);
+float flt_floor(float z);
+float  flt_ceil(float z);
+float flt_hypot(float x, float y);
+float  flt_mida(float x, float y);
+float flt_clamp (float x);
+float flt_clamps(float x, float a, float b);
+float  flt_exp(float x);
+float  flt_pow(float x, float y); // NAN where rcpow is complex
+float flt_spow(float x, float y);
+float  flt_sin(float v);
+float  flt_cos(float v);
+float  flt_tan(float v);
+float  flt_cot(float v);
+float  flt_sec(float v);
+float  flt_csc(float v);
+float flt_atan(float v);
+float flt_sinh(float v);
+float flt_cosh(float v);
+float flt_tanh(float v);
+float flt_coth(float v);
+float flt_sech(float v);
+float flt_csch(float v);
+float flt_erf (float x);
+float flt_erfc(float x);
+
 //--- fractals.cc ------------------------------------------------------------------------------------------------------
 
 void mandel(const cnum &c, cnum &r);
 void julia(const cnum &z0, const cnum &c, cnum &r);
+void mandel(const cnum &c, const cnum &n, cnum &r); // with iteration limit n
+void julia(const cnum &z0, const cnum &c, const cnum &n, cnum &r);
+int    escape_limit();              // default iteration limit
+int    escape_limit(const cnum &n); // iteration limit argument n, 0 if invalid
+double escape_value(int i, int N);  // result for i iterations out of N (@see DeepZoom)
 
 //--- gamma.cc ---------------------------------------------------------------------------------------------------------
 
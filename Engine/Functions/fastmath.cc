@@ -0,0 +1,211 @@
+#include "Functions.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Approximations of the elementary functions for evaluating at draft precision. They are plain polynomials after a
+// range reduction, without tables or data dependent loops, so the compiler can inline and vectorize them.
+// Bounds are for the approximation on the reduced range (rounding adds a few double ulp). Arguments outside of
+// the ranges given below go to libm. For comparison: float has a relative precision of 6e-8, which is what all
+// results are finally converted to for drawing.
+//
+//   fast_exp      relative error < 3e-10                 |x| < 700
+//   fast_log      absolute error < 8e-10                 DBL_MIN <= x < inf
+//   fast_sin/cos  absolute error < 2e-9                  |x| < 1e5
+//   fast_atan2    absolute error < 5e-10                 finite, not both zero
+//   complex       combinations of the above, the error of cpow grows with |y log x|
+//
+// The real exp and pow of glibc are already as fast as these, so BaseFunction::draft keeps them and fast_exp and
+// fast_log are only used inside the complex functions.
+
+//----------------------------------------------------------------------------------------------------------------------
+// constants and helpers
+//----------------------------------------------------------------------------------------------------------------------
+
+// ln(2) and pi/2 split into a part with trailing zeros (so k*HI is exact) and the rest (from fdlibm)
+static const double LN2_HI  = 6.93147180369123816490e-01;
+static const double LN2_LO  = 1.90821492927058770002e-10;
+static const double PIO2_HI = 1.57079632673412561417e+00;
+static const double PIO2_LO = 6.07710050650619224932e-11;
+
+static inline double   bits2d(uint64_t u){ double d; memcpy(&d, &u, sizeof(d)); return d; }
+static inline double   nearest(double x){ const double r = 6755399441055744.0; return (x + r) - r; } // |x| < 2^51
+static inline uint64_t d2bits(double d){ uint64_t u; memcpy(&u, &d, sizeof(u)); return u; }
+
+// sin and cos for |r| <= pi/4 (Taylor to degree 9 and 10)
+static inline double sin_poly(double r)
+{
+	double r2 = r*r;
+	return r + r*r2*(-1.0/6 + r2*(1.0/120 + r2*(-1.0/5040 + r2*(1.0/362880))));
+}
+static inline double cos_poly(double r)
+{
+	double r2 = r*r;
+	return 1.0 + r2*(-0.5 + r2*(1.0/24 + r2*(-1.0/720 + r2*(1.0/40320 + r2*(-1.0/3628800)))));
+}
+
+// x = q*pi/2 + r with |r| <= pi/4, q in 0..3
+static inline double reduce_pio2(double x, int &q)
+{
+	double k = nearest(x * M_2_PI);
+	q = (int)((int64_t)k & 3);
+	return (x - k*PIO2_HI) - k*PIO2_LO;
+}
+
+static inline void fast_sincos(double x, double &s, double &c)
+{
+	if (!(fabs(x) < 1e5)){ s = sin(x); c = cos(x); return; }
+	int q; double r = reduce_pio2(x, q);
+	double sr = sin_poly(r), cr = cos_poly(r);
+	switch (q)
+	{
+		case 0: s =  sr; c =  cr; break;
+		case 1: s =  cr; c = -sr; break;
+		case 2: s = -sr; c = -cr; break;
+		default:s = -cr; c =  sr; break;
+	}
+}
+
+// sinh and cosh of x, using a series for small |x| where (e^x - e^-x)/2 would cancel
+static inline void fast_sinhcosh(double x, double &sh, double &ch)
+{
+	double e = fast_exp(x), ei = 1.0 / e;
+	ch = 0.5 * (e + ei);
+	if (fabs(x) < 0.5)
+	{
+		double x2 = x*x; // error < x^11/11! < 3e-11 relative
+		sh = x + x*x2*(1.0/6 + x2*(1.0/120 + x2*(1.0/5040 + x2*(1.0/362880))));
+	}
+	else
+	{
+		sh = 0.5 * (e - ei);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// real
+//----------------------------------------------------------------------------------------------------------------------
+
+double fast_exp(double x)
+{
+	if (!(fabs(x) < 700.0)) return exp(x); // overflow, denormals, inf, nan
+
+	// x = k*ln2 + r, |r| <= ln2/2, exp(r) by Taylor to degree 8
+	double k = nearest(x * M_LOG2E);
+	double r = (x - k*LN2_HI) - k*LN2_LO;
+	double p = 1.0 + r*(1.0 + r*(1.0/2 + r*(1.0/6 + r*(1.0/24 + r*(1.0/120 + r*(1.0/720 + r*(1.0/5040 + r*(1.0/40320))))))));
+	return p * bits2d((uint64_t)((int64_t)k + 1023) << 52);
+}
+
+double fast_log(double x)
+{
+	if (!(x >= 2.2250738585072014e-308 && x < INFINITY)) return log(x); // <= 0, denormals, inf, nan
+
+	// x = m*2^e with m in [sqrt(1/2), sqrt(2)), log(m) = 2 artanh(s) for s = (m-1)/(m+1), |s| < 0.1716
+	uint64_t u = d2bits(x);
+	int      e = (int)((u >> 52) & 0x7ff) - 1023;
+	double   m = bits2d((u & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL);
+	if (m > M_SQRT2){ m *= 0.5; ++e; }
+	double s = (m - 1.0) / (m + 1.0), s2 = s*s;
+	double l = 2.0*s*(1.0 + s2*(1.0/3 + s2*(1.0/5 + s2*(1.0/7 + s2*(1.0/9)))));
+	return e*LN2_HI + (l + e*LN2_LO);
+}
+
+double fast_sin(double x)
+{
+	if (!(fabs(x) < 1e5)) return sin(x);
+	int q; double r = reduce_pio2(x, q);
+	switch (q)
+	{
+		case 0:  return  sin_poly(r);
+		case 1:  return  cos_poly(r);
+		case 2:  return -sin_poly(r);
+		default: return -cos_poly(r);
+	}
+}
+
+double fast_cos(double x)
+{
+	if (!(fabs(x) < 1e5)) return cos(x);
+	int q; double r = reduce_pio2(x, q);
+	switch (q)
+	{
+		case 0:  return  cos_poly(r);
+		case 1:  return -sin_poly(r);
+		case 2:  return -cos_poly(r);
+		default: return  sin_poly(r);
+	}
+}
+
+double fast_atan2(double y, double x)
+{
+	double ax = fabs(x), ay = fabs(y);
+	if (!(ax + ay > 0.0 && ax + ay < INFINITY)) return atan2(y, x);
+
+	// t in [0,1], then atan(t) = pi/4 + atan((t-1)/(t+1)) for t > tan(pi/8), Taylor to degree 19
+	bool   swap = ay > ax;
+	double t = swap ? ax / ay : ay / ax, a = 0.0;
+	if (t > 0.41421356237309503){ t = (t - 1.0) / (t + 1.0); a = M_PI_4; }
+	double t2 = t*t;
+	a += t*(1.0 + t2*(-1.0/3 + t2*(1.0/5 + t2*(-1.0/7 + t2*(1.0/9 + t2*(-1.0/11
+	   + t2*(1.0/13 + t2*(-1.0/15 + t2*(1.0/17 + t2*(-1.0/19))))))))));
+
+	if (swap)  a = M_PI_2 - a;
+	if (x < 0) a = M_PI - a;
+	return std::signbit(y) ? -a : a;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// complex
+//----------------------------------------------------------------------------------------------------------------------
+
+void fast_exp(const cnum &z, cnum &r)
+{
+	double e = fast_exp(z.real());
+	if (z.imag() == 0.0){ r = e; return; }
+	double s, c; fast_sincos(z.imag(), s, c);
+	r.real(e*c);
+	r.imag(e*s);
+}
+
+void fast_log(const cnum &z, cnum &r)
+{
+	double a = fabs(z.real()), b = fabs(z.imag()), m = a > b ? a : b;
+	if (!(m > 1e-150 && m < 1e150)){ log_(z, r); return; } // |z|² would under- or overflow
+	r.real(0.5 * fast_log(z.real()*z.real() + z.imag()*z.imag()));
+	r.imag(fast_atan2(z.imag(), z.real()));
+}
+
+void fast_sin(const cnum &z, cnum &r)
+{
+	// sin(a+ib) = sin(a)cosh(b) + i cos(a)sinh(b)
+	double s, c, sh, ch;
+	fast_sincos(z.real(), s, c);
+	if (z.imag() == 0.0){ r = s; return; }
+	fast_sinhcosh(z.imag(), sh, ch);
+	r.real(s*ch);
+	r.imag(c*sh);
+}
+
+void fast_cos(const cnum &z, cnum &r)
+{
+	// cos(a+ib) = cos(a)cosh(b) - i sin(a)sinh(b)
+	double s, c, sh, ch;
+	fast_sincos(z.real(), s, c);
+	if (z.imag() == 0.0){ r = c; return; }
+	fast_sinhcosh(z.imag(), sh, ch);
+	r.real(c*ch);
+	r.imag(-s*sh);
+}
+
+void fast_cpow(const cnum &x, const cnum &y, cnum &r)
+{
+	if (x == 0.0 || !std::isfinite(x.real()) || !std::isfinite(x.imag())){ cpow(x, y, r); return; }
+	if (x.imag() == 0.0 && x.real() > 0.0 && y.imag() == 0.0)
+	{
+		r = fast_exp(y.real() * fast_log(x.real()));
+		return;
+	}
+	cnum l; fast_log(x, l);
+	fast_exp(y*l, r);
+}
@@ -1,26 +1,74 @@
 #include "Functions.h"
 
-#define M 150 /* iteration limit */
+#define M 150 /* default iteration limit */
+#define MAX_ITERATIONS 1000000
 using std::log;
 
-const static double scale = 1.0/log(1.0+M);
+// Escape time of z -> z² + c starting at z = (x,y): the number of iterations until |z| >= 2, or n if the orbit
+// stays bounded that long. Interior points run into a cycle, which is detected by comparing with an orbit point
+// that is saved at every power of two (Brent's algorithm), so they can stop early as well.
+static inline int escape(double x, double y, const double cx, const double cy, const int n)
+{
+	double sx = x, sy = y; // saved orbit point
+	double x2 = x*x, y2 = y*y;
+	int i = 0, next = 8;
+	do
+	{
+		y = (x+x)*y + cy;
+		x = x2 - y2 + cx;
+		x2 = x*x; y2 = y*y;
+		if (++i >= n || !(x2 + y2 < 4.0)) break;
+
+		if (fabs(x - sx) + fabs(y - sy) < 1e-13) return n;
+		if (i == next){ sx = x; sy = y; next *= 2; }
+	}while (true);
+	return i;
+}
+
+// main cardioid and period-2 bulb, where escape would run until n
+static inline bool interior(double x, double y)
+{
+	double y2 = y*y, xq = x - 0.25, q = xq*xq + y2;
+	if (q*(q + xq) <= 0.25*y2) return true;
+	return (x+1.0)*(x+1.0) + y2 <= 0.0625;
+}
+
+int escape_limit(){ return M; }
+
+int escape_limit(const cnum &n)
+{
+	double d = n.real();
+	if (!(d >= 1.0) || n.imag() != 0.0) return 0;
+	return d < MAX_ITERATIONS ? (int)d : MAX_ITERATIONS;
+}
+
+double escape_value(int i, int N)
+{
+	return log(i) / log(1.0+N);
+}
 
 void mandel(const cnum &c, cnum &ret)
 {
-	cnum z = c;
-	int  i = 0;
-	
-	do{ z *= z; z += c; }while (++i < M && absq(z) < 4.0);
-	
-	ret = log(i) * scale;
+	int i = interior(c.real(), c.imag()) ? M : escape(c.real(), c.imag(), c.real(), c.imag(), M);
+	ret = escape_value(i, M);
 }
 
 void julia(const cnum &z0, const cnum &c, cnum &ret)
 {
-	cnum z = z0;
-	int  i = 0;
-	
-	do{ z *= z; z += c; }while (++i < M && absq(z) < 4.0);
-	
-	ret = log(i) * scale;
+	int i = escape(z0.real(), z0.imag(), c.real(), c.imag(), M);
+	ret = escape_value(i, M);
+}
+
+void mandel(const cnum &c, const cnum &n, cnum &ret)
+{
+	int N = escape_limit(n); if (!N){ ret = UNDEFINED; return; }
+	int i = interior(c.real(), c.imag()) ? N : escape(c.real(), c.imag(), c.real(), c.imag(), N);
+	ret = escape_value(i, N);
+}
+
+void julia(const cnum &z0, const cnum &c, const cnum &n, cnum &ret)
+{
+	int N = escape_limit(n); if (!N){ ret = UNDEFINED; return; }
+	int i = escape(z0.real(), z0.imag(), c.real(), c.imag(), N);
+	ret = escape_value(i, N);
 }
@@ -0,0 +1,80 @@
+#include "Functions.h"
+#include <cmath>
+
+// Single precision variants of the real functions for FloatContext (@see BaseFunction::single). They must agree
+// with their double counterparts up to rounding, including where they are undefined (NAN).
+
+//--- wrappers.cc ------------------------------------------------------------------------------------------------------
+
+float flt_add(float z, float w){ return z + w; }
+float flt_sub(float z, float w){ return z - w; }
+float flt_mul(float z, float w){ return z * w; }
+float flt_div(float z, float w){ return z / w; }
+float flt_mod(float z, float w){ return z - w*floorf(z/w); }
+float flt_negate(float z){ return -z; }
+float flt_invert(float z){ return 1.0f / z; }
+
+//--- comparison.cc ----------------------------------------------------------------------------------------------------
+
+float flt_is_gt(float x, float y){ return x > y ? 1.0f : 0.0f; }
+float flt_is_sm(float x, float y){ return x < y ? 1.0f : 0.0f; }
+float flt_min(float z, float w){ return std::min(z, w); }
+float flt_max(float z, float w){ return std::max(z, w); }
+
+//--- basic.cc ---------------------------------------------------------------------------------------------------------
+
+float flt_identity(float z){ return z; }
+float flt_zero(float){ return 0.0f; }
+float flt_zero(float, float){ return 0.0f; }
+float flt_sqrt(float x){ return x >= 0.0f ? sqrtf(x) : NAN; }
+
+float  flt_sqr(float z){ return z * z; }
+float flt_cube(float z){ return z * z * z; }
+float flt_pow4(float z){ return flt_sqr(flt_sqr(z)); }
+float flt_pow5(float z){ return z * flt_sqr(flt_sqr(z)); }
+float flt_pow6(float z){ return z * z * flt_sqr(flt_sqr(z)); }
+float flt_pow7(float z){ return z * z * z * flt_sqr(flt_sqr(z)); }
+float flt_pow8(float z){ return flt_sqr(flt_sqr(flt_sqr(z))); }
+float flt_pow9(float z){ return z * flt_sqr(flt_sqr(flt_sqr(z))); }
+
+float  flt_abs(float z){ return fabsf(z); }
+float  flt_sgn(float z){ return z < 0.0f ? -1.0f : z > 0.0f ? 1.0f : 0.0f; }
+float flt_arg2(float x, float y){ return atan2f(y, x); }
+float flt_round(float z){ return roundf(z); }
+float flt_floor(float z){ return floorf(z); }
+float  flt_ceil(float z){ return ceilf(z); }
+float flt_hypot(float x, float y){ return hypotf(x, y); }
+float  flt_mida(float x, float y){ return 0.5f * (x+y); }
+
+float flt_clamp (float x){ return x < 0.0f ? 0.0f : x > 1.0f ? 1.0f : x; }
+float flt_clamps(float x, float a, float b)
+{
+	if (a < b) return x <= a ? a : x >= b ? b : x;
+	return x <= b ? b : x >= a ? a : x;
+}
+
+//--- exp.cc -----------------------------------------------------------------------------------------------------------
+
+float flt_exp(float x){ return expf(x); }
+float flt_pow(float x, float y){ return powf(x, y); } // NAN for x < 0 and fractional y, where rcpow is complex
+float flt_spow(float x, float y){ return copysignf(powf(fabsf(x), y), x); }
+
+float flt_sin(float v){ return sinf(v); }
+float flt_cos(float v){ return cosf(v); }
+float flt_tan(float v){ return tanf(v); }
+float flt_cot(float v){ return 1.0f / tanf(v); }
+float flt_sec(float v){ return 1.0f / cosf(v); }
+float flt_csc(float v){ return 1.0f / sinf(v); }
+float flt_atan(float v){ return atanf(v); }
+
+float flt_sinh(float v){ return sinhf(v); }
+float flt_cosh(float v){ return coshf(v); }
+float flt_tanh(float v){ return tanhf(v); }
+float flt_coth(float v){ return 1.0f / tanhf(v); }
+float flt_sech(float v){ return 1.0f / coshf(v); }
+float flt_csch(float v){ return 1.0f / sinhf(v); }
+
+//--- statistics.cc ----------------------------------------------------------------------------------------------------
+
+float flt_erf (float x){ return erff(x); }
+float flt_erfc(float x){ return erfcf(x); }
@@ -1,6 +1,9 @@
 #include "BaseFunction.h"
+#include "../Functions/Functions.h"
 
 #include <stdexcept>
+#include <cmath>
+#include <map>
 
 //---------------------------------------------------------------------------------------------------------------------
 //  Constructors
@@ -26,6 +29,80 @@ BaseFunction::BaseFunction(const std::string &n, qfunc *fcc, bool d)
 : Function(n), qfcc(fcc), ufrr(NULL), ufrc(NULL), ufcr(NULL), m_deterministic(d), m_arity(4)
 { }
 
+//---------------------------------------------------------------------------------------------------------------------
+//  Draft and single precision
+//---------------------------------------------------------------------------------------------------------------------
+
+FPTR BaseFunction::draft(FPTR f)
+{
+	#define D(T, a, b) { (FPTR)(T*)a, (FPTR)(T*)b }
+	static const std::map<FPTR, FPTR> table =
+	{
+		D(ufuncRR, sin, fast_sin), D(ufunc, sin,  fast_sin),
+		D(ufuncRR, cos, fast_cos), D(ufunc, cos,  fast_cos),
+		                           D(ufunc, exp_, fast_exp),
+		                           D(ufunc, log_, fast_log),
+		                           D(bfunc, cpow, fast_cpow),
+	};
+	#undef D
+	auto i = table.find(f);
+	return i == table.end() ? f : i->second;
+}
+
+FPTR BaseFunction::single(FPTR f)
+{
+	#define U(a, b) { (FPTR)(ufuncRR*)a, (FPTR)(ufuncFF*)b }
+	#define B(a, b) { (FPTR)(bfuncRR*)a, (FPTR)(bfuncFF*)b }
+	#define T(a, b) { (FPTR)(tfuncRR*)a, (FPTR)(tfuncFF*)b }
+	static const std::map<FPTR, FPTR> table =
+	{
+		B(::add, flt_add), B(sub, flt_sub), B(::mul, flt_mul), B(div, flt_div), B(mod, flt_mod),
+		U(negate, flt_negate), U(invert, flt_invert), U(identity, flt_identity),
+		B(is_gt, flt_is_gt), B(is_sm, flt_is_sm), B(r_min, flt_min), B(r_max, flt_max),
+		U(zero, flt_zero), B(zero, flt_zero),
+		U(rsqrt, flt_sqrt), { (FPTR)(ufuncRC*)sqrt_, (FPTR)(ufuncFF*)flt_sqrt },
+		U(sqr, flt_sqr), U(cube, flt_cube), U(pow4, flt_pow4), U(pow5, flt_pow5), U(pow6, flt_pow6),
+		U(pow7, flt_pow7), U(pow8, flt_pow8), U(pow9, flt_pow9),
+		U(abs, flt_abs), U(sgn, flt_sgn), B(arg2, flt_arg2),
+		U(round, flt_round), U(floor, flt_floor), U(ceil, flt_ceil),
+		B(hypot, flt_hypot), B(mida, flt_mida), U(clamp, flt_clamp), T(clamps, flt_clamps),
+		U(exp, flt_exp), B(spow, flt_spow), { (FPTR)(bfuncRC*)rcpow, (FPTR)(bfuncFF*)flt_pow },
+		U(sin, flt_sin), U(cos, flt_cos), U(tan, flt_tan), U(cot, flt_cot), U(sec, flt_sec), U(csc, flt_csc),
+		U(atan, flt_atan),
+		U(sinh, flt_sinh), U(cosh, flt_cosh), U(tanh, flt_tanh), U(coth, flt_coth), U(sech, flt_sech),
+		U(csch, flt_csch),
+		U(erf_, flt_erf), U(erfc_, flt_erfc),
+	};
+	#undef U
+	#undef B
+	#undef T
+	auto i = table.find(f);
+	return i == table.end() ? NULL : i->second;
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+//  Evaluation cost
+//---------------------------------------------------------------------------------------------------------------------
+
+int BaseFunction::cost() const
+{
+	// complex variants, the real ones are cheaper for all of them
+	static const std::map<std::string, int> table =
+	{
+		{"(U+)", 1}, {"(id)", 1}, {"¹", 1}, {"+", 1}, {"-", 1}, {"(U-)", 1}, {"~", 1}, {"conj", 1}, {"re", 1}, {"im", 1}, {"complex", 1},
+		{"*", 3}, {"²", 3}, {"sqr", 3}, {"absq", 3}, {"³", 5}, {"⁴", 6}, {"⁵", 8}, {"⁶", 8}, {"⁷", 10},
+		{"⁸", 9}, {"⁹", 11}, {"/", 8}, {"(⁻¹)", 6}, {"abs", 8}, {"hypot", 8}, {"sgn", 8},
+		{"sqrt", 15}, {"√", 15}, {"__rsqrt__", 8}, {"arg", 20},
+		{"exp", 20}, {"ln", 25}, {"log", 25}, {"log2", 25}, {"log10", 25},
+		{"sin", 25}, {"cos", 25}, {"tan", 35}, {"cot", 35}, {"sec", 30}, {"csc", 30},
+		{"sinh", 30}, {"cosh", 30}, {"tanh", 35}, {"coth", 35}, {"sech", 30}, {"csch", 30},
+		{"^", 60}, {"**", 60}, {"spow", 35},
+	};
+	auto i = table.find(name());
+	if (i != table.end()) return i->second;
+	return 50; // arcus functions, special functions, etc
+}
+
 //---------------------------------------------------------------------------------------------------------------------
 //  Operator (...) for the various arities
 //---------------------------------------------------------------------------------------------------------------------
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Function.h"
+#include "../Parser/FPTR.h"
 
 #include <string>
 #include <map>
@@ -27,6 +28,10 @@ typedef void   tfunc  (const cnum &, const cnum &, const cnum &, cnum &);
 typedef double tfuncRR(double, double, double);
 typedef void qfunc(const cnum &, const cnum &, const cnum &, const cnum &, cnum &);
 
+typedef float ufuncFF(float); // single precision variants (@see BaseFunction::single)
+typedef float bfuncFF(float, float);
+typedef float tfuncFF(float, float, float);
+
 /**
  * BaseFunction is mostly just a function pointer in possibly several (R->R, C->C, R->C, C->R) variants.
  */
@@ -48,6 +53,24 @@ public:
 	virtual Range range(Range input) const;
 	void range(Range input, Range output){ m_range.insert(std::make_pair(input, output)); }
 
+	/**
+	 * Faster, less precise variant of one of the function pointers for evaluating at draft precision
+	 * (@see fastmath.cc), or f itself if there is none.
+	 */
+	static FPTR draft(FPTR f);
+
+	/**
+	 * Single precision variant (ufuncFF, bfuncFF or tfuncFF) of one of the real function pointers (RR, or RC where
+	 * the complex results become NAN) for FloatContext, or NULL if there is none.
+	 */
+	static FPTR single(FPTR f);
+
+	/**
+	 * Rough cost of one evaluation, measured in additions, for picking the cheapest of several equivalent
+	 * expressions (@see EGraph.cc).
+	 */
+	int cost() const;
+
 	cnum operator()() const;
 	cnum operator()(const cnum &z1) const;
 	cnum operator()(const cnum &z1, const cnum &z2) const;
@@ -6,11 +6,14 @@
 #include "../Parser/WorkingTree.h"
 #include "../Parser/OptimizingTree.h"
 #include "../Parser/Evaluator.h"
+#include "../Parser/EvaluatorCache.h"
 #include "Namespace.h"
+#include "Variable.h"
 #include "../Parser/utf8/utf8.h"
 
 #include <iostream>
 #include <stack>
+#include <list>
 #include <memory>
 
 void Expression::save(Serializer &ser) const
@@ -79,6 +82,8 @@ cnum Expression::parse(const std::string &s, const Namespace *ns_, ParsingResult
 
 Expression::~Expression()
 {
+	clear(m_parts);
+	delete m_jet;
 	delete m_ev;
 	delete m_ot;
 	delete m_wt;
@@ -86,6 +91,14 @@ Expression::~Expression()
 
 void Expression::redefinition(const std::set<std::string> &affected_names)
 {
+	// parts can be stale while dirty is set, so check them all
+	for (Part &p : m_parts)
+	{
+		for (auto &s : affected_names)
+		{
+			if (p.source.find(s) != std::string::npos){ p.stale = true; dirty = true; break; }
+		}
+	}
 	if (dirty) return;
 	
 	bool match = false;
@@ -102,6 +115,12 @@ void Expression::redefinition(const std::set<std::string> &affected_names)
 	}
 }
 
+void Expression::clear(std::vector<Part> &parts)
+{
+	for (Part &p : parts) for (auto &d : p.d) delete d.second;
+	parts.clear();
+}
+
 WorkingTree *Expression::wt0() const
 {
 	WorkingTree *t = wt();
@@ -119,45 +138,78 @@ void Expression::parse() const
 {
 	if (!dirty) return;
 	dirty = false;
+	WorkingTreeArena::Pause pause; // m_wt is kept, even if this is called from within a derivative
 
-	// reset state
-	delete m_ev; m_ev = NULL;
-	delete m_ot; m_ot = NULL;
-	delete m_wt; m_wt = NULL;
+	// reset state, but keep the old tree to reuse its unchanged parts
+	WorkingTree *old = m_wt; m_wt = NULL;
+	std::vector<Part> old_parts; old_parts.swap(m_parts);
+	if (!old) clear(old_parts);
+	assert(!old || (size_t)old->num_children() == old_parts.size());
+	std::unique_ptr<WorkingTree> cleanup(old);
 	m_result.reset(true);
+	bool same = old && old_parts.size() == m_strings.size(); // is the new tree equal to old?
 
-	if (!container()){ m_result.error("No namespace", 0, 0); return; }
-	RootNamespace *rns = root_container();
-	if (!rns){ m_result.error("No root namespace", 0, 0); return; }
-	if (container()->empty()){ m_result.error("Empty namespace", 0, 0); return; }
-	if (m_strings.size() == 0){ m_result.error("Empty list of expressions", 0, 0); return; }
-	
-	m_wt = new WorkingTree(*rns);
-	
-	for (auto &s : m_strings)
+	if (!container()){ m_result.error("No namespace", 0, 0); same = false; }
+	else if (!root_container()){ m_result.error("No root namespace", 0, 0); same = false; }
+	else if (container()->empty()){ m_result.error("Empty namespace", 0, 0); same = false; }
+	else if (m_strings.size() == 0){ m_result.error("Empty list of expressions", 0, 0); same = false; }
+	else
 	{
-		ParsingTree *c = ParsingTree::parse(s, *container(), m_result);
-		if (!c)
+		RootNamespace *rns = root_container();
+		m_wt = new WorkingTree(*rns);
+		
+		for (size_t i = 0; i < m_strings.size(); ++i)
 		{
-			assert(!m_result.ok);
-			delete m_wt; m_wt = NULL;
-			return;
-		}
+			const std::string &s = m_strings[i];
+			
+			// (a) same string as before, possibly at another index
+			size_t j = i < old_parts.size() ? i : 0;
+			for (size_t k = 0; k < old_parts.size(); ++k, ++j)
+			{
+				if (j == old_parts.size()) j = 0;
+				if (!old_parts[j].stale && old_parts[j].source == s) break;
+			}
+			if (j < old_parts.size() && !old_parts[j].stale && old_parts[j].source == s)
+			{
+				m_wt->add_subtree(std::move(old->child((int)j)));
+				m_parts.push_back(std::move(old_parts[j]));
+				old_parts[j].d.clear();
+				old_parts[j].stale = true; // moved from
+				if (j != i) same = false;
+				++m_result.index;
+				continue;
+			}
+			
+			// (b) parse it
+			ParsingTree *c = ParsingTree::parse(s, *container(), m_result);
+			if (!c)
+			{
+				assert(!m_result.ok);
+				delete m_wt; m_wt = NULL;
+				clear(m_parts);
+				break;
+			}
 
-		m_wt->add_subtree(WorkingTree(*c, *rns));
-		delete c;
-		++m_result.index;
-		
-		#ifdef PARSER_DEBUG
-		std::cerr << "After wtree conversion: " << m_wt->child(m_wt->num_children()-1) << std::endl << std::endl;
-		#endif
+			m_wt->add_subtree(WorkingTree(*c, *rns));
+			delete c;
+			m_parts.push_back(Part{s, false, {}});
+			if (same && (old_parts[i].stale || !(m_wt->child(m_wt->num_children()-1) == old->child((int)i)))) same = false;
+			++m_result.index;
+			
+			#ifdef PARSER_DEBUG
+			std::cerr << "After wtree conversion: " << m_wt->child(m_wt->num_children()-1) << std::endl << std::endl;
+			#endif
+		}
+		if (!m_wt) same = false;
 	}
+	clear(old_parts);
 
-	if (!m_result.ok)
+	// keep the compiled code if nothing changed (like after whitespace edits), otherwise it is rebuilt on demand
+	if (!same)
 	{
-		assert(false); // should already have returned
-		delete m_wt;
-		m_wt = NULL;
+		delete m_jet; m_jet = NULL; m_jet_wrt.clear();
+		delete m_ev; m_ev = NULL;
+		delete m_ot; m_ot = NULL;
 	}
 }
 
@@ -187,10 +239,16 @@ Evaluator *Expression::evaluator(const std::vector<const Variable *> &var_order)
 	if (m_ev) return m_ev;
 	assert(!m_ot); delete m_ot; m_ot = NULL;
 
-	// (1) WorkingTree --> OptimizingTree
+	// (0) reuse the code of an identical expression
+	EvaluatorCache cache(*m_wt, var_order);
+	if (cache.valid() && (m_ev = cache.find())) return m_ev;
+
+	// (1) WorkingTree --> cheapest equivalent WorkingTree --> OptimizingTree
 	try
 	{
-		m_ot = new OptimizingTree(m_wt, m_result);
+		WorkingTree wt(*m_wt);
+		wt.saturate();
+		m_ot = new OptimizingTree(&wt, m_result);
 	}
 	catch(ParsingResult &)
 	{
@@ -202,9 +260,11 @@ Evaluator *Expression::evaluator(const std::vector<const Variable *> &var_order)
 	#endif
 	
 	// (2) optimize
+	RootNamespace *rns = root_container();
+	assert(rns); // otherwise !valid()
 	try
 	{
-		m_ot->optimize();
+		m_ot->optimize(*rns);
 	}
 	catch(...)
 	{
@@ -219,10 +279,8 @@ Evaluator *Expression::evaluator(const std::vector<const Variable *> &var_order)
 	// (3) create the Evaluator
 	try
 	{
-		RootNamespace *rns = root_container();
-		assert(rns); // otherwise !valid()
-		
 		m_ev = new Evaluator(m_ot, var_order, *rns);
+		if (cache.valid()) cache.insert(*m_ev);
 		
 		#ifdef PARSER_DEBUG
 		std::cerr << "After flattening: " << endl;
@@ -239,6 +297,145 @@ Evaluator *Expression::evaluator(const std::vector<const Variable *> &var_order)
 	return m_ev;
 }
 
+Evaluator *Expression::fused_evaluator(const std::vector<Expression*> &exs,
+                                       const std::vector<std::vector<const Variable *>> &vars,
+                                       std::vector<int> &offsets, std::vector<bool> &jets)
+{
+	assert(exs.size() == vars.size() && exs.size() == jets.size());
+	offsets.clear();
+	if (exs.empty()) return NULL;
+	
+	RootNamespace *rns = exs[0]->root_container();
+	for (Expression *x : exs) if (!x->valid() || x->root_container() != rns) return NULL;
+	
+	// (0) reuse the code of an identical group (from the last update, usually)
+	std::vector<const WorkingTree*> wts;
+	std::list<WorkingTree> jet_trees; // stable addresses for wts
+	for (size_t k = 0; k < exs.size(); ++k)
+	{
+		if (jets[k] && !vars[k].empty())
+		{
+			jet_trees.emplace_back(*exs[k]->m_wt);
+			if (exs[k]->jet_tree(vars[k], jet_trees.back())){ wts.push_back(&jet_trees.back()); continue; }
+			jet_trees.pop_back();
+		}
+		jets[k] = false;
+		wts.push_back(exs[k]->m_wt);
+	}
+	EvaluatorCache cache(wts, vars);
+	if (cache.valid())
+	{
+		if (Evaluator *ev = cache.find())
+		{
+			int n = 0;
+			for (auto *wt : wts){ offsets.push_back(n); n += wt->num_children(); }
+			if (n == ev->image_dimension()) return ev;
+			delete ev;
+			offsets.clear();
+		}
+	}
+	
+	// (1) WorkingTrees --> OptimizingTrees, with everyone's variables replaced by those of exs[0]
+	std::vector<OptimizingTree*> ots;
+	int no = 0;
+	try
+	{
+		for (size_t k = 0; k < exs.size(); ++k)
+		{
+			ParsingResult result;
+			WorkingTree wt(*wts[k]);
+			wt.saturate();
+			ots.push_back(new OptimizingTree(&wt, result));
+			offsets.push_back(no);
+			no += ots.back()->num_children();
+			
+			if (k == 0) continue;
+			if (vars[k].size() != vars[0].size()) throw result;
+			std::map<const Element *, const Element *> m;
+			for (size_t i = 0; i < vars[k].size(); ++i) m[vars[k][i]] = vars[0][i];
+			ots.back()->substitute(m);
+		}
+	}
+	catch(ParsingResult &)
+	{
+		for (auto *ot : ots) delete ot;
+		offsets.clear();
+		return NULL;
+	}
+	
+	// (2) optimize all of them together, which merges their common subtrees
+	OptimizingTree *ot = OptimizingTree::fuse(ots);
+	Evaluator *ev = NULL;
+	try
+	{
+		ot->optimize(*rns);
+		ev = new Evaluator(ot, vars[0], *rns);
+		assert(ev->image_dimension() == no);
+		if (cache.valid()) cache.insert(*ev);
+	}
+	catch(...)
+	{
+		ev = NULL;
+	}
+	delete ot;
+	
+	if (!ev) offsets.clear();
+	return ev;
+}
+
+bool Expression::jet_tree(const std::vector<const Variable *> &wrt, WorkingTree &wt) const
+{
+	// wt is a copy of m_wt, the derivatives of unchanged parts are kept from before
+	assert((size_t)m_wt->num_children() == m_parts.size());
+	for (const Variable *x : wrt)
+	{
+		for (int i = 0; i < m_wt->num_children(); ++i)
+		{
+			WorkingTree *&d = m_parts[i].d[x];
+			if (!d)
+			{
+				std::string error;
+				d = m_wt->child(i).derivative(*x, error);
+				if (!d){ m_parts[i].d.erase(x); return false; }
+			}
+			wt.add_subtree(WorkingTree(*d));
+		}
+	}
+	return true;
+}
+
+Evaluator *Expression::jet_evaluator(const std::vector<const Variable *> &var_order,
+                                     const std::vector<const Variable *> &wrt)
+{
+	assert(!wrt.empty());
+	if (!valid()) return NULL;
+	if (m_jet_wrt == wrt) return m_jet;
+	delete m_jet; m_jet = NULL;
+	m_jet_wrt = wrt;
+	
+	// (1) append the derivatives to a copy of the expression
+	WorkingTree wt(*m_wt);
+	if (!jet_tree(wrt, wt)) return NULL;
+	
+	// (2) optimize and flatten it like evaluator does
+	OptimizingTree *ot = NULL;
+	try
+	{
+		ParsingResult result;
+		wt.saturate();
+		ot = new OptimizingTree(&wt, result);
+		ot->optimize(*root_container());
+		m_jet = new Evaluator(ot, var_order, *root_container());
+		assert(m_jet->image_dimension() == wt.num_children());
+	}
+	catch(...)
+	{
+		m_jet = NULL;
+	}
+	delete ot;
+	return m_jet;
+}
+
 std::set<Parameter*> Expression::usedParameters() const
 {
 	std::set<Parameter*> ps;
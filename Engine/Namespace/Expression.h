@@ -25,7 +25,7 @@ class OptimizingTree;
 class Expression : public Element
 {
 public:
-	Expression() : Element(""), m_ot(NULL), m_ev(NULL), m_wt(NULL), dirty(false){ }
+	Expression() : Element(""), m_ot(NULL), m_ev(NULL), m_jet(NULL), m_wt(NULL), dirty(false){ }
 	~Expression();
 
 	virtual void save(Serializer   &s) const;
@@ -53,6 +53,30 @@ public:
 	cnum evaluate(const std::map<const Variable*, cnum> &values) const;
 	Evaluator *evaluator(const std::vector<const Variable *> &var_order); ///< For fast multi-evaluations
 
+	/**
+	 * Compiles several expressions into one Evaluator, so that their common subexpressions are only
+	 * calculated once. Its outputs are those of exs[0], followed by those of exs[1], etc.
+	 * @param vars vars[k] are the variables of exs[k]. They are identified by position with vars[0],
+	 * which is also used as var_order.
+	 * @param offsets Receives the index of the first output of every expression.
+	 * @param jets If jets[k] is set, the outputs of exs[k] are followed by their derivatives by vars[k], like
+	 * those of jet_evaluator(vars[k], vars[k]). Cleared for the expressions that are not differentiable.
+	 * The code is cached like that of evaluator(), so a group that was compiled before only needs its parameters
+	 * set again.
+	 * @return NULL on error, otherwise a new Evaluator which the caller must delete.
+	 */
+	static Evaluator *fused_evaluator(const std::vector<Expression*> &exs,
+	                                  const std::vector<std::vector<const Variable *>> &vars,
+	                                  std::vector<int> &offsets, std::vector<bool> &jets);
+
+	/**
+	 * Like evaluator, but the outputs are followed by their partial derivatives: first those by wrt[0], then
+	 * those by wrt[1], etc. Values and derivatives are optimized together, so they share their subexpressions.
+	 * @return NULL if the expression is not differentiable.
+	 */
+	Evaluator *jet_evaluator(const std::vector<const Variable *> &var_order,
+	                         const std::vector<const Variable *> &wrt);
+
 	static cnum parse(const std::string &s, const Namespace *ns, ParsingResult &result); ///< Convenience function
 
 	WorkingTree *derivative(const Variable &x, std::string &error) const;
@@ -63,6 +87,7 @@ public:
 
 protected:
 	virtual Element *copy() const{ return NULL; }
+	virtual void added_to_namespace(){ for (Part &p : m_parts) p.stale = true; }
 
 private:
 	std::vector<std::string>    m_strings;
@@ -70,6 +95,22 @@ private:
 	mutable WorkingTree        *m_wt;
 	mutable OptimizingTree     *m_ot;
 	mutable Evaluator          *m_ev;
+	mutable Evaluator          *m_jet;     ///< @see jet_evaluator
+	mutable std::vector<const Variable *> m_jet_wrt; ///< what m_jet was made for, empty if not tried yet
+
+	/**
+	 * Where the children of m_wt came from. When only some of the strings change (or move), parse()
+	 * keeps the subtrees of the others, unless a redefinition of some name in them made them stale.
+	 */
+	struct Part
+	{
+		std::string source;
+		bool        stale;
+		std::map<const Variable*, WorkingTree*> d; ///< derivatives, owned, @see jet_evaluator
+	};
+	mutable std::vector<Part> m_parts;
+	static void clear(std::vector<Part> &parts);
+	bool jet_tree(const std::vector<const Variable *> &wrt, WorkingTree &wt) const; ///< m_wt and its derivatives
 
 	mutable bool dirty;
 	void parse() const; ///< Create or update m_pt, etc and clear dirty flag.
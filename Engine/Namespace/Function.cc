@@ -27,6 +27,7 @@ bool Function::parse_gradient() const
 {
 	if (grd) return true;
 	if (grds.empty()) return false;
+	WorkingTreeArena::Pause pause; // grd is kept, but this is called from within derivative
 
 	RootNamespace *rns = root_container(); if (!rns){ assert(false); return false; }
 	grdns = new Namespace;
@@ -83,7 +84,7 @@ bool Function::parse_gradient() const
 }
 
 // (df/dz1, df/dz2, ..., df/dzn)(x1, ..., xn)
-WorkingTree *Function::complex_gradient(const std::vector<WorkingTree> &x) const
+WorkingTree *Function::complex_gradient(const WorkingTrees &x) const
 {
 	int n = arity();
 	if ((int)x.size() != n){ assert(false); return NULL; }
@@ -98,7 +99,7 @@ WorkingTree *Function::complex_gradient(const std::vector<WorkingTree> &x) const
 
 // (df/dx1, df/dy1, df/dx2, ..., df/dyn)(x1, ..., xn), where f = f(x1+iy1, x2+iy2, ..., xn+iyn)
 // if cdiff, we use df/dxi = df/dzi, df/dyi = i*df/dzi (Cauchy-Riemann)
-WorkingTree *Function::real_gradient(const std::vector<WorkingTree> &x) const
+WorkingTree *Function::real_gradient(const WorkingTrees &x) const
 {
 	int n = arity();
 	if ((int)x.size() != n){ assert(false); return NULL; }
@@ -1,5 +1,6 @@
 #pragma once
 #include "Element.h"
+#include "../Parser/WorkingTreeArena.h" // WorkingTrees
 #include <vector>
 class WorkingTree;
 
@@ -38,8 +39,8 @@ public:
 	void multiplicative(bool f){ assert(!f || arity() == 1); mul  = f; }
 	void linear        (bool f){ assert(!f || arity() == 1); lin  = f; if (f) add = f; }
 	
-	WorkingTree *   real_gradient(const std::vector<WorkingTree> &x) const;
-	WorkingTree *complex_gradient(const std::vector<WorkingTree> &x) const;
+	WorkingTree *   real_gradient(const WorkingTrees &x) const;
+	WorkingTree *complex_gradient(const WorkingTrees &x) const;
 
 	void gradient(const std::vector<std::string> &grad, bool complex)
 	{
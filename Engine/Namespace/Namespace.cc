@@ -8,6 +8,7 @@
 #include <cctype>
 #include <vector>
 #include <map>
+#include <algorithm>
 #include <cassert>
 #include "../Parser/utf8/utf8.h"
 
@@ -223,6 +224,7 @@ void Namespace::add(Element *object)
 	if (valid_name(object->nm))
 	{
 		named[std::make_pair(object->nm, object->arity())] = object;
+		index(object);
 		redefine(object);
 	}
 	else
@@ -238,6 +240,7 @@ void Namespace::add_builtin(Element *object)
 	assert(object && !object->ns);
 	assert(named.find(std::make_pair(object->nm, object->arity())) == named.end());
 	named[std::make_pair(object->nm, object->arity())] = object;
+	index(object);
 	object->ns = this;
 }
 
@@ -265,6 +268,7 @@ void Namespace::remove(Element *object)
 			if (i.second == object)
 			{
 				found = true;
+				unindex(object->nm, object);
 				named.erase(i.first);
 				break;
 			}
@@ -282,6 +286,8 @@ void Namespace::clear()
 	
 	named.clear();
 	nameless.clear();
+	by_name.clear();
+	name_lengths.clear();
 	// leave linked as is
 }
 
@@ -320,6 +326,7 @@ bool Namespace::rename(Element *object, int old_arity, const std::string &new_na
 		object->nm = new_name;
 		if (fromDict)
 		{
+			unindex(old_name, object);
 			named.erase(key0);
 			nameless.insert(object);
 			assert(n0 == named.size() + nameless.size());
@@ -343,10 +350,12 @@ bool Namespace::rename(Element *object, int old_arity, const std::string &new_na
 	else // renaming an element
 	{
 		redefs.insert(old_name);
+		unindex(old_name, object);
 		named.erase(key0);
 	}
 	named[key1] = object;
 	object->nm = new_name;
+	index(object);
 
 	assert(n0 == named.size() + nameless.size());
 	redefs.insert(new_name);
@@ -355,32 +364,47 @@ bool Namespace::rename(Element *object, int old_arity, const std::string &new_na
 	return true;
 }
 
-Element *Namespace::find(const std::string &name, int arity, bool recursive) const
+void Namespace::index(Element *x)
 {
-	auto p = named.find(std::make_pair(name, arity));
-	if (p != named.end()) return p->second;
-	return (recursive && ns) ? ns->find(name, arity, true) : NULL;
-	
+	auto &v = by_name[x->nm];
+	if (v.empty()) ++name_lengths[x->nm.length()];
+	auto e = std::make_pair(x->arity(), x);
+	v.insert(std::upper_bound(v.begin(), v.end(), e), e);
 }
 
-static inline bool hasPrefix(const std::string &s, size_t pos, const std::string &prefix)
+void Namespace::unindex(const std::string &name, Element *x)
 {
-	return s.size() >= pos+prefix.length() && std::equal(prefix.begin(), prefix.end(), s.begin()+pos);
+	auto p = by_name.find(name);
+	if (p == by_name.end()){ assert(false); return; }
+	auto &v = p->second;
+	v.erase(std::remove_if(v.begin(), v.end(), [x](const std::pair<int, Element*> &e){ return e.second == x; }), v.end());
+	if (!v.empty()) return;
+	by_name.erase(p);
+	auto l = name_lengths.find(name.length());
+	assert(l != name_lengths.end());
+	if (--l->second == 0) name_lengths.erase(l);
 }
-static inline bool hasSuffix(const std::string &s, size_t pos, size_t n, const std::string &suffix)
+
+Element *Namespace::find(const std::string &name, int arity, bool recursive) const
 {
-	return n >= suffix.length() && std::equal(suffix.begin(), suffix.end(), s.begin()+pos+n-suffix.length());
+	auto p = by_name.find(name);
+	if (p != by_name.end())
+	{
+		for (auto &e : p->second) if (e.first == arity) return e.second;
+	}
+	return (recursive && ns) ? ns->find(name, arity, true) : NULL;
+	
 }
 
-
 void Namespace::candidates(const std::string &s, size_t pos, std::vector<Element*> &ret) const
 {
 	if (pos >= s.length()) return;
 
-	for (auto &x : named)
+	for (auto &l : name_lengths)
 	{
-		const std::string &xn = x.second->name();
-		if (!xn.empty() && hasPrefix(s, pos, xn)) ret.push_back(x.second);
+		if (pos + l.first > s.length()) break;
+		auto p = by_name.find(s.substr(pos, l.first));
+		if (p != by_name.end()) for (auto &e : p->second) ret.push_back(e.second);
 	}
 	
 	if (container()) container()->candidates(s, pos, ret);
@@ -389,10 +413,11 @@ void Namespace::rcandidates(const std::string &s, size_t pos, size_t n, std::vec
 {
 	if (pos >= s.length() || n == 0) return;
 	
-	for (auto &x : named)
+	for (auto &l : name_lengths)
 	{
-		const std::string &xn = x.second->name();
-		if (!xn.empty() && hasSuffix(s, pos, n, xn)) ret.push_back(x.second);
+		if (l.first > n) break;
+		auto p = by_name.find(s.substr(pos + n - l.first, l.first));
+		if (p != by_name.end()) for (auto &e : p->second) ret.push_back(e.second);
 	}
 	
 	if (container()) container()->rcandidates(s, pos, n, ret);
@@ -4,6 +4,7 @@
 #include <vector>
 #include <map>
 #include <set>
+#include <unordered_map>
 
 #include "../../Persistence/Serializer.h"
 #include "ObjectDB.h"
@@ -171,6 +172,13 @@ protected:
 	std::set<Element*>   nameless; ///< elements without a valid, nonempty name
 	std::set<Namespace*> linked;   ///< not iterated, owned or saved, but notified of redefinitions
 	
+	// named by name alone, for find and candidates, which then only need one hash lookup per name length
+	// instead of comparing against every name. Everything that changes named must call index or unindex.
+	std::unordered_map<std::string, std::vector<std::pair<int, Element*>>> by_name; ///< (arity, x), sorted
+	std::map<size_t, int> name_lengths; ///< length -> number of names in by_name with that length
+	void   index(Element *x);
+	void unindex(const std::string &name, Element *x);
+	
 	std::set<std::string> redefinition_queue; // recursion breaker during redefinition runs
 	bool                  redefining;
 	
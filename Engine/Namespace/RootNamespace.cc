@@ -10,6 +10,7 @@
 #include <string>
 #include <algorithm>
 #include <iostream>
+#include <sstream>
 #include <cassert>
 
 #define ADDF(name, ...) add_builtin(e = new BaseFunction(name, __VA_ARGS__))
@@ -42,7 +43,7 @@
 #define UU EF->range(R_Unit, R_Unit)
 #define II EF->range(R_Real|R_Unit, R_Real|R_Unit)
 
-RootNamespace::RootNamespace()
+RootNamespace::RootNamespace() : m_all_rules_loaded(false)
 {
 	Element *e = NULL;
 
@@ -154,7 +155,7 @@ RootNamespace::RootNamespace()
 	ADDF("sqr", sqr, sqr); DIFF(true, "2*z"); POWER(2); MUL;
 	
 	ADDF("sqrt", sqrt_, NULL, NULL, sqrt_); DNAME("√"); DIFF(true, "1/(2*sqrt(z))"); POWER(0.5); STORE(Sqrt); MUL;
-	ADDF("__rsqrt__", sqrt_, rsqrt);        DNAME("√"); DIFF(true, "1/(2*sqrt(z))"); POWER(0.5);// with √-1 = Undefined
+	ADDF("__rsqrt__", sqrt_, rsqrt);        DNAME("√"); DIFF(true, "1/(2*sqrt(z))"); POWER(0.5); STORE(RSqrt); // with √-1 = Undefined
 	ADDF("√",   sqrt_, NULL, NULL, sqrt_);              DIFF(true, "1/(2*sqrt(z))"); POWER(0.5); MUL;
 
 	ADDF("clamp", clamp,  clamp); DIFF(false, "(0<x)*(x<1)", "i*(0<y)*(y<1)"); PROJ; COMMUTES(Re); COMMUTES(Im);
@@ -167,7 +168,7 @@ RootNamespace::RootNamespace()
 	ADDF("det",   c_det, zero, det); DIFF(false, "y2", "x2", "y1", "x1"); REAL;
 	ADDF("sp",    c_sp,  mul,  sp);  DIFF(false, "x2", "y2", "x1", "y2"); REAL;
 	ADDF("spow",  spow,  spow);      DIFF(false, "spow(z1,z2-2)*(z2*x1-i*y1)", "spow(z1,z2-2)*(z2*y1+i*x1)",
-	                                             "spow(z1,z2)*ln(abs(z1))", "i*spow(z1,z2)*ln(abs(z1))");
+	                                             "spow(z1,z2)*ln(abs(z1))", "i*spow(z1,z2)*ln(abs(z1))"); STORE(SPow);
 	ADDF("hypot", hypot, hypot); STORE(Hypot);
 	DIFF(false, "x1/hypot(x1,x2)", "y1/hypot(x1,x2)", "x2/hypot(x1,x2)", "y2/hypot(x1,x2)");
 
@@ -268,8 +269,10 @@ RootNamespace::RootNamespace()
 	// Functions - Other
 	//------------------------------------------------------------------------------------------------------------------
 	
-	ADDF("mandel", mandel); DIFF(true, "0"); combines(EF, Conj, First); REAL;
-	ADDF("julia", julia); DIFF(true, "0", "0"); REAL;
+	ADDF("mandel", (ufunc*)mandel); DIFF(true, "0"); combines(EF, Conj, First); REAL;
+	ADDF("julia", (bfunc*)julia); DIFF(true, "0", "0"); REAL;
+	ADDF("mandel", (bfunc*)mandel); DIFF(true, "0", "0"); REAL;
+	ADDF("julia", (tfunc*)julia); DIFF(true, "0", "0", "0"); REAL;
 	ADDF("fowler", fowler_angle, fowler_angle, fowler_angle); REAL;
 	ADDF("wp",weierp);
 
@@ -347,6 +350,7 @@ void RootNamespace::clear()
 		Element *x = it->second;
 		if (!x->builtin())
 		{
+			unindex(x->nm, x);
 			x->ns = NULL;
 			delete x;
 			named.erase(it++);
@@ -385,3 +389,16 @@ const std::vector<Rule> &RootNamespace::rules(const Element *head) const
 	static std::vector<Rule> nothing;
 	return nothing;
 }
+
+extern const char *simplifier_rules; // Rules.txt, compiled in by the build
+
+const std::vector<Rule> &RootNamespace::all_rules() const
+{
+	if (!m_all_rules_loaded)
+	{
+		m_all_rules_loaded = true;
+		std::istringstream in(simplifier_rules);
+		::load(in, m_all_rules, *const_cast<RootNamespace*>(this));
+	}
+	return m_all_rules;
+}
@@ -38,6 +38,7 @@ public:
 	BaseFunction   *Identity;
 	BaseFunction   *Combine; // x+iy
 	BaseFunction   *Abs, *Sqrt, *Re, *Im, *Conj, *Hypot, *Exp, *Log, *Log_;
+	BaseFunction   *RSqrt, *SPow; // real variants of sqrt and pow for nonnegative arguments
 	UnaryOperator  *UPlus, *UMinus, *Invert; // unary + - 1/
 	UnaryOperator  *ConjOp;
 	UnaryOperator  *PowOps[10];
@@ -58,6 +59,7 @@ public:
 	Combination combine(const Element *f, const Element *g) const; // f(g) = ?
 	
 	const std::vector<Rule> &rules(const Element *head) const;
+	const std::vector<Rule> &all_rules() const; ///< Everything in Rules.txt, for WorkingTree::saturate
 
 private:
 	std::map<std::pair<const Element*, const Element*>, Combination> combinations;
@@ -83,6 +85,8 @@ private:
 	}
 
 	mutable std::map<const Element *, std::vector<Rule>> m_rules;
+	mutable std::vector<Rule> m_all_rules;
+	mutable bool m_all_rules_loaded;
 };
 
 /** @} */
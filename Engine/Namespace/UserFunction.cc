@@ -100,7 +100,7 @@ WorkingTree *UserFunction::apply(const std::vector<WorkingTree*> &xargs) const
 	
 	return new WorkingTree(std::move(ret));
 }
-WorkingTree *UserFunction::apply(const std::vector<WorkingTree> &xargs) const
+WorkingTree *UserFunction::apply(const WorkingTrees &xargs) const
 {
 	if (dirty) parse();
 	if (!valid()) return NULL;
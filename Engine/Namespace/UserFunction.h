@@ -49,7 +49,7 @@ public:
 	const std::vector<Variable*> &arguments() const{ if (dirty) parse(); return args; }
 
 	WorkingTree *apply(const std::vector<WorkingTree*> &args) const;
-	WorkingTree *apply(const std::vector<WorkingTree>  &args) const;
+	WorkingTree *apply(const WorkingTrees &args) const;
 
 	virtual void redefinition(const std::set<std::string> &affected_names);
 #ifdef DEBUG
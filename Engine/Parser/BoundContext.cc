@@ -1,9 +1,13 @@
 #include "BoundContext.h"
 #include <cstring>
 
-BoundContext::BoundContext(const Evaluator &e)
+std::atomic<uint64_t> BoundContext::total_evals(0);
+std::atomic<bool>     BoundContext::counting(false);
+
+BoundContext::BoundContext(const Evaluator &e, bool draft)
 : stack(new cnum[e.ctx->size]), last_change(e.ctx->last_change)
-, nin(e.ctx->nin), nout(e.ctx->nout)
+, nin(e.ctx->nin), nout(e.ctx->nout), counted(counting), n_evals(0)
+, prof(NULL), prof_data(NULL)
 , start(new int[e.ctx->nin+1])
 {
 	memcpy(stack, e.ctx->stack, e.ctx->size*sizeof(cnum));
@@ -32,7 +36,7 @@ BoundContext::BoundContext(const Evaluator &e)
 		f.param[1] = F.param_index[1] < 0 ? NULL : stack + F.param_index[1]; assert(F.param_index[1] < e.ctx->size);
 		f.param[2] = F.param_index[2] < 0 ? NULL : stack + F.param_index[2]; assert(F.param_index[2] < e.ctx->size);
 		f.param[3] = F.param_index[3] < 0 ? NULL : stack + F.param_index[3]; assert(F.param_index[3] < e.ctx->size);
-		f.function = F.function();
+		f.function = draft ? BaseFunction::draft(F.function()) : F.function();
 		f.type     = F.type();
 		assert(f.function);
 		
@@ -55,3 +59,45 @@ BoundContext::BoundContext(const Evaluator &e)
 		#undef R
 	}
 }
+
+//----------------------------------------------------------------------------------------------------------------------
+// profiling
+//----------------------------------------------------------------------------------------------------------------------
+
+void BoundContext::profile(EvalProfile *p)
+{
+	if (prof) prof->add(prof_data, n_evals);
+	delete [] prof_data; prof_data = NULL;
+	total_evals += n_evals; n_evals = 0;
+	
+	prof = p;
+	counted = p || counting;
+	if (!p) return;
+	size_t nf = 0; while (funcs[nf].function) ++nf;
+	assert(nf == p->size());
+	prof_data = new EvalProfile::Entry[nf];
+	for (size_t i = 0; i < nf; ++i) prof_data[i].count = prof_data[i].ticks = 0;
+}
+
+void BoundContext::eval_counted() const
+{
+	++n_evals;
+	if (!prof)
+	{
+		for (FCall *F = funcs + start[last_change+1]; F->function; ++F) call(*F);
+		last_change = -1;
+		return;
+	}
+	
+	uint64_t t0 = EvalProfile::clock();
+	for (FCall *F = funcs + start[last_change+1]; F->function; ++F)
+	{
+		call(*F);
+		uint64_t t1 = EvalProfile::clock();
+		EvalProfile::Entry &e = prof_data[F - funcs];
+		++e.count;
+		e.ticks += t1 - t0;
+		t0 = t1;
+	}
+	last_change = -1;
+}
@@ -2,19 +2,27 @@
 
 #include "Evaluator.h"
 #include "EvalContext.h"
+#include "EvalProfile.h"
 #include "FPTR.h"
+#include <atomic>
+#include <cstdint>
 
 /**
  * This combines an Evaluator and an EvalContext into a single faster entity.
+ * Every thread has its own, aligned to cache lines so they do not share one.
  */
 
-class BoundContext
+class alignas(64) BoundContext
 {
 public:
-	BoundContext(const Evaluator &e);
+	/// @param draft Use the fast approximations of the elementary functions (@see BaseFunction::draft)
+	BoundContext(const Evaluator &e, bool draft = false);
 
 	~BoundContext()
 	{
+		total_evals += n_evals;
+		if (prof) prof->add(prof_data, n_evals);
+		delete [] prof_data;
 		delete [] funcs;
 		delete [] start;
 		delete stack;
@@ -25,43 +33,8 @@ public:
 	
 	inline void eval() const
 	{
-		using CP_PARSER::ExecToken;
-		for (FCall *F = funcs + start[last_change+1]; F->function; ++F)
-		{
-			#define RZ (*F->result)
-			#define RR assert(RZ.imag() == 0.0); (*(double*)F->result)
-			#define R(i) (*(double*)F->param[i])
-			#define Z(i) (*F->param[i])
-			#define f(T) ((T*)F->function)
-			#define CHK1 assert(Z(0).imag() == 0.0)
-			#define CHK2 assert(Z(0).imag() == 0.0 && Z(1).imag() == 0.0)
-			#define CHK3 CHK2; assert(Z(2).imag() == 0.0)
-			
-			switch (F->type)
-			{
-				case ExecToken::Exec_1RR: CHK1; RR = f(ufuncRR)(R(0));    break;
-				case ExecToken::Exec_1CC:            f(ufunc)  (Z(0), RZ); break;
-				case ExecToken::Exec_1CR:       RR = f(ufuncCR)(Z(0));    break;
-				case ExecToken::Exec_1RC: CHK1;      f(ufuncRC)(R(0), RZ); break;
-				case ExecToken::Exec_2RR: CHK2; RR = f(bfuncRR)(R(0), R(1));    break;
-				case ExecToken::Exec_2RC: CHK2;      f(bfuncRC)(R(0), R(1), RZ); break;
-				case ExecToken::Exec_0R:        RR = f(vfuncR) ();  break;
-				case ExecToken::Exec_0C:             f(vfunc)  (RZ); break;
-				case ExecToken::Exec_2CC:            f(bfunc)  (Z(0), Z(1), RZ); break;
-				case ExecToken::Exec_2CR:       RR = f(bfuncCR)(Z(0), Z(1));    break;
-				case ExecToken::Exec_3RR: CHK3; RR = f(tfuncRR)(R(0), R(1), R(2));    break;
-				case ExecToken::Exec_3CC:            f(tfunc)  (Z(0), Z(1), Z(2), RZ); break;
-				case ExecToken::Exec_4CC:            f(qfunc)  (Z(0), Z(1), Z(2), Z(3), RZ); break;
-			}
-			
-			#undef RZ
-			#undef RR
-			#undef R
-			#undef Z
-			#undef f
-			#undef CHK1
-			#undef CHK2
-		}
+		if (counted){ eval_counted(); return; }
+		for (FCall *F = funcs + start[last_change+1]; F->function; ++F) call(*F);
 		last_change = -1;
 	}
 
@@ -86,6 +59,16 @@ public:
 	
 	void print(std::ostream &o, const Namespace *ns) const;
 	
+	/**
+	 * Count the calls and ticks of every ExecToken from now on and add them to p when this is deleted.
+	 * p must have been created for the Evaluator of this context and must outlive it. NULL turns it off again.
+	 */
+	void profile(EvalProfile *p);
+	
+	/// Number of eval calls of all BoundContexts that were deleted so far, if counting was on when they were created
+	static uint64_t evaluations(){ return total_evals; }
+	static void count_evaluations(bool on){ counting = on; } ///< for benchmarking, off by default
+
 private:
 	//--- Evaluator equivalents ----------------------------------------------------------------------------------------
 
@@ -99,12 +82,59 @@ private:
 	FCall        *funcs; // terminated by an FCall with function == NULL
 	int          *start; // from Evaluator
 	
+	static inline void call(const FCall &F)
+	{
+		using CP_PARSER::ExecToken;
+		#define RZ (*F.result)
+		#define RR assert(RZ.imag() == 0.0); (*(double*)F.result)
+		#define R(i) (*(double*)F.param[i])
+		#define Z(i) (*F.param[i])
+		#define f(T) ((T*)F.function)
+		#define CHK1 assert(Z(0).imag() == 0.0)
+		#define CHK2 assert(Z(0).imag() == 0.0 && Z(1).imag() == 0.0)
+		#define CHK3 CHK2; assert(Z(2).imag() == 0.0)
+		
+		switch (F.type)
+		{
+			case ExecToken::Exec_1RR: CHK1; RR = f(ufuncRR)(R(0));    break;
+			case ExecToken::Exec_1CC:            f(ufunc)  (Z(0), RZ); break;
+			case ExecToken::Exec_1CR:       RR = f(ufuncCR)(Z(0));    break;
+			case ExecToken::Exec_1RC: CHK1;      f(ufuncRC)(R(0), RZ); break;
+			case ExecToken::Exec_2RR: CHK2; RR = f(bfuncRR)(R(0), R(1));    break;
+			case ExecToken::Exec_2RC: CHK2;      f(bfuncRC)(R(0), R(1), RZ); break;
+			case ExecToken::Exec_0R:        RR = f(vfuncR) ();  break;
+			case ExecToken::Exec_0C:             f(vfunc)  (RZ); break;
+			case ExecToken::Exec_2CC:            f(bfunc)  (Z(0), Z(1), RZ); break;
+			case ExecToken::Exec_2CR:       RR = f(bfuncCR)(Z(0), Z(1));    break;
+			case ExecToken::Exec_3RR: CHK3; RR = f(tfuncRR)(R(0), R(1), R(2));    break;
+			case ExecToken::Exec_3CC:            f(tfunc)  (Z(0), Z(1), Z(2), RZ); break;
+			case ExecToken::Exec_4CC:            f(qfunc)  (Z(0), Z(1), Z(2), Z(3), RZ); break;
+		}
+		
+		#undef RZ
+		#undef RR
+		#undef R
+		#undef Z
+		#undef f
+		#undef CHK1
+		#undef CHK2
+		#undef CHK3
+	}
+	void eval_counted() const; // and profiled, if prof is set
+	
 	//--- EvalContext equivalents --------------------------------------------------------------------------------------
 	
 	mutable cnum *stack;
 	mutable int   last_change;
 	int           nin, nout;
 	
-	char padding[64-3*sizeof(void*)-3*sizeof(int)];
-
+	bool             counted; // counting or profiling
+	mutable uint64_t n_evals;
+	static std::atomic<uint64_t> total_evals;
+	static std::atomic<bool>     counting;
+	
+	//--- profiling ----------------------------------------------------------------------------------------------------
+	
+	EvalProfile        *prof;      // or NULL
+	EvalProfile::Entry *prof_data; // one per FCall
 };
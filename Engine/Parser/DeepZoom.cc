@@ -0,0 +1,194 @@
+#include "DeepZoom.h"
+#include "ExecToken.h"
+#include "../Functions/Functions.h"
+#include <cmath>
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------------------------
+// double-double arithmetic for the reference orbit
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace
+{
+	struct dd
+	{
+		dd(double hi = 0.0, double lo = 0.0) : hi(hi), lo(lo){ }
+		double hi, lo;
+	};
+
+	inline dd normalize(double s, double e)
+	{
+		double h = s + e;
+		return dd(h, e - (h - s));
+	}
+	inline dd operator+(const dd &a, const dd &b)
+	{
+		double s = a.hi + b.hi, v = s - a.hi, e = (a.hi - (s - v)) + (b.hi - v);
+		return normalize(s, e + a.lo + b.lo);
+	}
+	inline dd operator-(const dd &a, const dd &b)
+	{
+		return a + dd(-b.hi, -b.lo);
+	}
+	inline dd operator*(const dd &a, const dd &b)
+	{
+		double p = a.hi * b.hi, e = std::fma(a.hi, b.hi, -p);
+		return normalize(p, e + a.hi*b.lo + a.lo*b.hi);
+	}
+}
+
+// iterates z -> z² + c from z = (x,y) until |z| >= 2 or for max steps, returns the number of steps
+static int iterate(dd x, dd y, const dd &cx, const dd &cy, int max, std::vector<double> *X, std::vector<double> *Y)
+{
+	if (X){ X->clear(); Y->clear(); X->push_back(x.hi); Y->push_back(y.hi); }
+	int m = 0;
+	while (m < max)
+	{
+		dd xy = x*y;
+		x = x*x - y*y + cx;
+		y = dd(2.0*xy.hi, 2.0*xy.lo) + cy;
+		++m;
+		if (X){ X->push_back(x.hi); Y->push_back(y.hi); }
+		if (!(x.hi*x.hi + y.hi*y.hi < 4.0)) break;
+	}
+	return m;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// setup
+//----------------------------------------------------------------------------------------------------------------------
+
+DeepZoom *DeepZoom::create(const Evaluator &e, int x)
+{
+	using CP_PARSER::ExecToken;
+	if (!e.ctx || !e.funcs || !e.funcs[0] || x < 0 || e.ctx->nout != 1) return NULL;
+
+	int nf = 0; // everything before the last token computes the other arguments
+	while (e.funcs[nf+1]) ++nf;
+	const ExecToken &F = *e.funcs[nf];
+
+	FPTR f = F.function();
+	bool m = (f == (FPTR)(ufunc*)mandel || f == (FPTR)(bfunc*)mandel);
+	int np = f == (FPTR)(ufunc*)mandel ? 1 :
+	         f == (FPTR)(bfunc*)mandel || f == (FPTR)(bfunc*)julia ? 2 :
+	         f == (FPTR)(tfunc*)julia  ? 3 : 0;
+	if (!np || F.result_index != e.ctx->nin || F.param_index[0] != x) return NULL;
+
+	for (int k = 1; k < np; ++k) if (F.param_index[k] == x) return NULL;
+	for (int i = 0; i < nf; ++i)
+	{
+		for (int k = 0; k < 4; ++k) if (e.funcs[i]->param_index[k] == x) return NULL;
+	}
+
+	EvalContext ctx(*e.ctx);
+	for (int i = 0; i < nf; ++i) e.funcs[i]->eval(ctx);
+
+	cnum c = m ? cnum(0.0) : ctx.stack[F.param_index[1]];
+	int  N = np == (m ? 2 : 3) ? escape_limit(ctx.stack[F.param_index[np-1]]) : escape_limit();
+	if (!N || !defined(c)) return NULL;
+
+	return new DeepZoom(m, N, c);
+}
+
+int DeepZoom::orbit(double x0, double x1, double y0, double y1, int max, Orbit *o) const
+{
+	dd px(x0, x1), py(y0, y1);
+	if (mandelbrot) return iterate(dd(), dd(), px, py, max, o ? &o->x : NULL, o ? &o->y : NULL);
+	return iterate(px, py, dd(c.real()), dd(c.imag()), max, o ? &o->x : NULL, o ? &o->y : NULL);
+}
+
+void DeepZoom::set_view(double x0, double x1, double y0, double y1, double rx, double ry, double pixel)
+{
+	const int o = mandelbrot ? 1 : 0, max = N + o;
+	tol = std::min(1e-13, 1e-3*pixel);
+
+	// the reference should stay bounded as long as possible: take the center or the best point on a grid
+	ox = oy = 0.0;
+	int best = orbit(x0, x1, y0, y1, max, NULL);
+	const int K = 4;
+	for (int i = -K; i <= K && best < max; ++i)
+	{
+		for (int j = -K; j <= K && best < max; ++j)
+		{
+			double dx = rx*i/K, dy = ry*j/K;
+			int n = orbit(x0, x1+dx, y0, y1+dy, max, NULL);
+			if (n > best){ best = n; ox = dx; oy = dy; }
+		}
+	}
+	orbit(x0, x1+ox, y0, y1+oy, max, &ref);
+	if (!mandelbrot) iterate(dd(), dd(), dd(c.real()), dd(c.imag()), N+1, &crit.x, &crit.y);
+
+	// series approximation: the difference to the reference after m iterations is A d + B d² + C d³ for the
+	// initial difference d. Use it as long as the cubic term stays negligible and no pixel can escape or
+	// needs rebasing.
+	const double r = std::hypot(rx + fabs(ox), ry + fabs(oy)), r2 = r*r, r3 = r2*r;
+	double a[2] = {1.0, 0.0}, b[2] = {0.0, 0.0}, d[2] = {0.0, 0.0};
+	skip = o;
+	A[0] = 1.0; A[1] = B[0] = B[1] = C[0] = C[1] = 0.0;
+	for (int m = o, L = ref.length(); m+1 < L && m+1-o < N; ++m)
+	{
+		// A' = 2WA (+ 1 for mandel), B' = 2WB + A², C' = 2WC + 2AB
+		double wr = 2.0*ref.x[m], wi = 2.0*ref.y[m];
+		double dr = wr*d[0] - wi*d[1] + 2.0*(a[0]*b[0] - a[1]*b[1]);
+		double di = wr*d[1] + wi*d[0] + 2.0*(a[0]*b[1] + a[1]*b[0]);
+		double br = wr*b[0] - wi*b[1] + a[0]*a[0] - a[1]*a[1];
+		double bi = wr*b[1] + wi*b[0] + 2.0*a[0]*a[1];
+		double ar = wr*a[0] - wi*a[1] + o;
+		double ai = wr*a[1] + wi*a[0];
+		a[0] = ar; a[1] = ai; b[0] = br; b[1] = bi; d[0] = dr; d[1] = di;
+
+		double ta = std::hypot(ar, ai)*r, tb = std::hypot(br, bi)*r2, tc = std::hypot(dr, di)*r3;
+		double t = ta + tb + tc, w = std::hypot(ref.x[m+1], ref.y[m+1]);
+		if (!(tc <= 1e-12*ta && w + t < 2.0 && w > 2.0*t)) break;
+
+		skip = m+1;
+		A[0] = ar; A[1] = ai; B[0] = br; B[1] = bi; C[0] = dr; C[1] = di;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// evaluation
+//----------------------------------------------------------------------------------------------------------------------
+
+cnum DeepZoom::eval(double dx, double dy) const
+{
+	dx -= ox; dy -= oy;
+	const double ar = mandelbrot ? dx : 0.0, ai = mandelbrot ? dy : 0.0;
+	const Orbit *z0 = mandelbrot ? &ref : &crit;
+
+	double d2r = dx*dx - dy*dy, d2i = 2.0*dx*dy;
+	double d3r = d2r*dx - d2i*dy, d3i = d2r*dy + d2i*dx;
+	double dr = A[0]*dx - A[1]*dy + B[0]*d2r - B[1]*d2i + C[0]*d3r - C[1]*d3i;
+	double di = A[0]*dy + A[1]*dx + B[0]*d2i + B[1]*d2r + C[0]*d3i + C[1]*d3r;
+
+	const double *X = ref.x.data(), *Y = ref.y.data();
+	int L = ref.length(), m = skip, i = skip - (mandelbrot ? 1 : 0);
+	double zr = X[m] + dr, zi = Y[m] + di, z2 = zr*zr + zi*zi;
+
+	// cycle detection as in fractals.cc, with the saved point split into orbit point and difference
+	double sx = X[m], sy = Y[m], sr = dr, si = di;
+	int next = 8;
+	while (next <= i) next *= 2;
+
+	while (true)
+	{
+		if (m == L || z2 < dr*dr + di*di)
+		{
+			// rebase onto the orbit of 0
+			X = z0->x.data(); Y = z0->y.data(); L = z0->length();
+			m = 0; dr = zr; di = zi;
+		}
+
+		// z² + c - (W² + C) = (2W + d) d + (c - C)
+		double tr = 2.0*X[m] + dr, ti = 2.0*Y[m] + di, t = tr*dr - ti*di + ar;
+		di = tr*di + ti*dr + ai;
+		dr = t;
+		++m;
+		zr = X[m] + dr; zi = Y[m] + di; z2 = zr*zr + zi*zi;
+		if (++i >= N || !(z2 < 4.0)) break;
+
+		if (fabs((X[m] - sx) + (dr - sr)) + fabs((Y[m] - sy) + (di - si)) < tol){ i = N; break; }
+		if (i == next){ sx = X[m]; sy = Y[m]; sr = dr; si = di; next *= 2; }
+	}
+	return escape_value(i, N);
+}
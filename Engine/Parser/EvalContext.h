@@ -25,6 +25,8 @@ namespace CP_PARSER
 }
 
 class BoundContext;
+class FloatContext;
+class DeepZoom;
 
 /**
  * EvalContext stores input, temporary and output values for evaluations of an expression via Evaluator.
@@ -134,4 +136,6 @@ private:
 	// and so does Evaluator::Evaluator
 	friend class Evaluator;
 	friend class BoundContext;
+	friend class FloatContext;
+	friend class DeepZoom;
 };
@@ -0,0 +1,70 @@
+#include "EvalProfile.h"
+#include <algorithm>
+
+EvalProfile::EvalProfile(const Evaluator &e, const Namespace *ns)
+: code(e.code), n_evals(0)
+{
+	for (size_t i = 0; e.funcs && e.funcs[i]; ++i) text.push_back(e.subexpression(i, ns));
+	data.resize(text.size(), Entry{0, 0});
+}
+
+void EvalProfile::add(const Entry *d, uint64_t evals)
+{
+	Lock _(lock);
+	for (size_t i = 0, n = data.size(); i < n; ++i)
+	{
+		data[i].count += d[i].count;
+		data[i].ticks += d[i].ticks;
+	}
+	n_evals += evals;
+}
+
+void EvalProfile::clear()
+{
+	Lock _(lock);
+	std::fill(data.begin(), data.end(), Entry{0, 0});
+	n_evals = 0;
+}
+
+std::vector<EvalProfile::Row> EvalProfile::rows() const
+{
+	std::vector<Row> r;
+	{
+		Lock _(lock);
+		for (size_t i = 0, n = data.size(); i < n; ++i)
+		{
+			if (data[i].count) r.push_back(Row{text[i], data[i].count, data[i].ticks});
+		}
+	}
+	std::stable_sort(r.begin(), r.end(), [](const Row &a, const Row &b){ return a.ticks > b.ticks; });
+	return r;
+}
+
+uint64_t EvalProfile::ticks() const
+{
+	Lock _(lock);
+	uint64_t t = 0;
+	for (const Entry &e : data) t += e.ticks;
+	return t;
+}
+
+uint64_t EvalProfile::evaluations() const
+{
+	Lock _(lock);
+	return n_evals;
+}
+
+void EvalProfile::print(std::ostream &o) const
+{
+	std::vector<Row> r = rows();
+	uint64_t total = ticks(), evals = evaluations();
+
+	o << format("%llu evaluations, %llu ticks", (unsigned long long)evals, (unsigned long long)total);
+	if (evals) o << format(" (%.1f per evaluation)", (double)total / evals);
+	o << "\n" << format("%7s %12s %10s  %s\n", "time", "calls", "ticks/call", "subexpression");
+	for (const Row &x : r)
+	{
+		o << format("%6.2f%% %12llu %10.1f  %s\n", total ? 100.0 * x.ticks / total : 0.0,
+		            (unsigned long long)x.count, (double)x.ticks / x.count, x.text.c_str());
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Evaluator.h"
+#include "../../Utility/Mutex.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+/**
+ * Sampling profile of an Evaluator's ExecTokens.
+ *
+ * BoundContexts that have a profile set (@see BoundContext::profile) count the calls and the clock ticks that each of
+ * their ExecTokens takes and merge them in here when they are deleted. Every token is mapped back to the subexpression
+ * it calculates, so the report shows which part of a formula is expensive.
+ *
+ * Ticks are TSC cycles on x86 and nanoseconds elsewhere, so only the ratios are meaningful.
+ */
+
+class EvalProfile
+{
+public:
+	EvalProfile(const Evaluator &e, const Namespace *ns);
+
+	EvalProfile(const EvalProfile &) = delete;
+	EvalProfile &operator= (const EvalProfile &) = delete;
+
+	struct Entry
+	{
+		uint64_t count, ticks;
+	};
+
+	/// Was this created for e or for an Evaluator that shares its code?
+	bool matches(const Evaluator &e) const{ return e.code == code; }
+
+	size_t size() const{ return text.size(); } ///< number of ExecTokens
+
+	/// Add the counters of one BoundContext (size() entries), thread safe
+	void add(const Entry *data, uint64_t evals);
+	void clear();
+
+	struct Row
+	{
+		std::string text;      ///< the subexpression
+		uint64_t    count, ticks;
+	};
+
+	/// All tokens that were called at least once, most expensive first
+	std::vector<Row> rows() const;
+
+	uint64_t ticks() const;       ///< total over all tokens
+	uint64_t evaluations() const; ///< number of BoundContext::eval calls
+
+	void print(std::ostream &o) const;
+
+	/// Current value of the clock that is used for the profile
+	static inline uint64_t clock()
+	{
+		#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+		#else
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+		#endif
+	}
+
+private:
+	std::shared_ptr<const Evaluator::Code> code;
+	std::vector<std::string> text;    ///< per token
+	std::vector<Entry>       data;    ///< per token
+	uint64_t                 n_evals;
+	mutable Mutex            lock;
+};
@@ -35,6 +35,20 @@ void Evaluator::set_parameters(const std::set<Parameter*> &params)
 	}
 }
 
+size_t Evaluator::tokens(int changed, std::vector<size_t> *by_type) const
+{
+	if (!funcs || !ctx) return 0;
+	assert(changed >= -1 && changed < ctx->n_inputs());
+	if (by_type && by_type->size() <= ExecToken::Exec_4CC) by_type->resize(ExecToken::Exec_4CC+1, 0);
+	
+	size_t n = 0;
+	for (ExecToken **F = funcs + start[changed+1]; *F; ++F, ++n)
+	{
+		if (by_type) ++(*by_type)[(*F)->type()];
+	}
+	return n;
+}
+
 typedef const OptimizingTree *PCOT; // "Pointer to Constant Optimizing Tree"
 
 static void collect(PCOT tree, set<PCOT> &constants, set<PCOT> &variables, set<PCOT> &parameters, set<PCOT> &functions)
@@ -50,20 +64,31 @@ static void collect(PCOT tree, set<PCOT> &constants, set<PCOT> &variables, set<P
 			break;
 			
 		case OptimizingTree::OT_Function:
-			if(!tree->root()) functions.insert(tree);
+			if(!tree->root() && !functions.insert(tree).second) break; // shared subtree, already collected
 			for(auto *c : *tree) collect(c, constants, variables, parameters, functions);
 			break;
 	}
 }
 
+static bool depends(PCOT tree, PCOT item, map<PCOT, bool> &memo)
+{
+	if (tree == item) return true;
+	auto it = memo.find(tree);
+	if (it != memo.end()) return it->second;
+	
+	bool d = false;
+	for (auto *c : *tree) if (depends(c, item, memo)) d = true; // no shortcut, so memo gets filled
+	return memo[tree] = d;
+}
+
 // how many nodes are dependent on item
 static size_t get_usage(PCOT tree, PCOT item)
 {
-	if (tree == item) return 1;
+	map<PCOT, bool> memo;
+	depends(tree, item, memo);
 	
-	size_t n = 0;
-	for (auto *c : *tree) n += get_usage(c, item);
-	if (n && !tree->root()) ++n; // add 1 for tree as well
+	size_t n = 1; // item itself
+	for (auto &m : memo) if (m.second && !m.first->root()) ++n;
 	return n;
 }
 
@@ -83,6 +108,7 @@ struct POOL
 	std::list<PCOT> list; // contents of the pool, ordered by PoolCmp
 	std::set <PCOT> set;  // the same objects in a set for faster membership testing
 	std::set <PCOT> done; // these are already converted to ExecTokens
+	std::set <PCOT> seen; // for not visiting shared subtrees repeatedly in initialize and update
 	std::map <PCOT, std::set<PCOT> > deps; // tree -> vars (as PCOTs) that it depends on
 
 #ifdef DEBUG
@@ -112,8 +138,7 @@ struct POOL
 
 	void initialize(PCOT tree)
 	{
-		
-		if (set.count(tree) || tree->type != OptimizingTree::OT_Function) return;
+		if (tree->type != OptimizingTree::OT_Function || !seen.insert(tree).second) return;
 		
 		bool leaf = true;
 		for (auto c : *tree)
@@ -182,10 +207,17 @@ public:
 	// Step (3) / (1'): Add new nodes into the pool when all their children are converted
 	//------------------------------------------------------------------------------------------------------------------
 
-	void update(OptimizingTree *tree)
+	void update(OptimizingTree *root)
+	{
+		seen.clear();
+		update_(root);
+	}
+	
+private:
+	void update_(OptimizingTree *tree)
 	{
 		assert(tree->type == OptimizingTree::OT_Function);
-		if (done.count(tree) || set.count(tree)) return;
+		if (done.count(tree) || set.count(tree) || !seen.insert(tree).second) return;
 		
 		bool collect = !tree->root(); // root is never put into the pool
 		
@@ -193,7 +225,7 @@ public:
 		for (auto c : *tree)
 		{
 			if (c->type != OptimizingTree::OT_Function) continue;
-			update(c);
+			update_(c);
 			if (!done.count(c)) collect = false; // unconverted child
 		}
 		if (!collect) return;
@@ -225,11 +257,21 @@ public:
 // Evaluator: Destructor, Constructor
 //----------------------------------------------------------------------------------------------------------------------
 
-Evaluator::~Evaluator()
+Evaluator::Code::Code(size_t nf, size_t nin)
+: funcs(new ExecToken* [nf+1]), start(new int[nin+1])
+{
+	std::fill(funcs, funcs+nf+1, nullptr);
+}
+
+Evaluator::Code::~Code()
 {
-	if (funcs) for(ExecToken **t = funcs; *t; ++t) delete *t;
+	for(ExecToken **t = funcs; *t; ++t) delete *t;
 	delete [] funcs;
 	delete [] start;
+}
+
+Evaluator::~Evaluator()
+{
 	delete ctx;
 }
 
@@ -337,14 +379,15 @@ Evaluator::Evaluator(OptimizingTree *root, const std::vector<const Variable *> &
 	// 3 - keep track of the first function that needs to be evaluated when some var changes
 
 	size_t nf = functions.size();
-	funcs = new ExecToken* [nf+1];
-	funcs[nf] = NULL; // terminator
+	Code *c = new Code(nf, nv + np); // funcs are NULL-terminated
+	code.reset(c);
+	funcs = c->funcs;
 
 	// start[i+1] is the index of the first ExecToken that must be recalculated when var_i and possibly var_i-1,
 	// var_i-2, ... var_0 have changed.
 	// start[0] is where calculation must restart when nothing has changed (this can be less than nf if there are
 	// nondeterministic functions in the mix).
-	start = new int[nv + np + 1];
+	start = c->start;
 	for(size_t i = 0; i <= nv + np; ++i) start[i] = (int)nf; // set all to "do nothing no matter which var changed"
 
 	// Fill a pool with all Nodes we can convert. New nodes get added to the pool
@@ -405,6 +448,58 @@ Evaluator::Evaluator(OptimizingTree *root, const std::vector<const Variable *> &
 // Printing
 //----------------------------------------------------------------------------------------------------------------------
 
+std::string Evaluator::subexpression(size_t i, const Namespace *ns) const
+{
+	if (!ctx || !funcs) return std::string();
+	for (size_t n = 0; n <= i; ++n) if (!funcs[n]) return std::string();
+	
+	const EvalContext &ec = *ctx;
+	const size_t max_len = 160;
+	
+	std::map<long, std::string> inputs;
+	for (auto &v : var_indexes) inputs[v.second] = v.first->name();
+	
+	// build the formulas of all tokens up to i, in evaluation order
+	std::vector<std::string> text(i+1);
+	std::vector<bool> op(i+1, false); // needs brackets when used as an argument?
+	std::map<long, size_t> producer;  // stack index -> last token that wrote it
+	auto arg = [&](long k, bool bracket) -> std::string
+	{
+		auto p = producer.find(k);
+		if (p != producer.end()) return bracket && op[p->second] ? "(" + text[p->second] + ")" : text[p->second];
+		if (k >= ec.n_inputs()) return to_string(ec.stack[k]);
+		auto v = inputs.find(k);
+		return v == inputs.end() ? format("X%d", (int)k+1) : v->second;
+	};
+	for (size_t j = 0; j <= i; ++j)
+	{
+		const ExecToken &t = *funcs[j];
+		int narg = 0; while (narg < 4 && t.param_index[narg] >= 0) ++narg;
+		Function *f = ns ? ns->find(t.function(), narg) : NULL;
+		std::string name = f ? f->displayName(PS_Console) : "<no symbol>", &m = text[j];
+		
+		if (f && f->isOperator() && narg == 2)
+		{
+			m = arg(t.param_index[0], true) + name + arg(t.param_index[1], true);
+			op[j] = true;
+		}
+		else if (f && f->isOperator() && narg == 1 && !name.empty() && !isalpha((unsigned char)name[0]))
+		{
+			m = (name == "-" || name == "+") ? name + arg(t.param_index[0], true) : arg(t.param_index[0], true) + name;
+			op[j] = true;
+		}
+		else
+		{
+			m = name + "(";
+			for (int a = 0; a < narg; ++a) m += (a ? ", " : "") + arg(t.param_index[a], false);
+			m += ")";
+		}
+		if (m.length() > max_len) m = m.substr(0, max_len-3) + "...";
+		producer[t.result_index] = j;
+	}
+	return text[i];
+}
+
 void Evaluator::print(std::ostream &out, const Namespace *ns) const
 {
 	using std::vector;
@@ -6,10 +6,12 @@
 
 #include <vector>
 #include <set>
+#include <memory>
 
 class Variable;
 class Parameter;
 class BoundContext;
+class EvaluatorCache;
 
 /**
  * For evaluating an expression a large number of times, possibly in parallel in several threads.
@@ -74,13 +76,38 @@ public:
 	void set_parameters(const std::set<Parameter*> &params);
 	
 	void print(std::ostream &o, const Namespace *ns) const;
+	
+	/**
+	 * Number of ExecTokens that eval runs if the inputs up to index changed were set (-1 for none).
+	 * @param by_type If not NULL, receives the counts per ExecToken::Type.
+	 */
+	size_t tokens(int changed, std::vector<size_t> *by_type = NULL) const;
+	
+	/// The formula that ExecToken i calculates, with all its arguments expanded (shortened if it gets too long)
+	std::string subexpression(size_t i, const Namespace *ns) const;
 
 private:
-	CP_PARSER::ExecToken         **funcs; /// NULL-terminated
-	int                           *start; /// Maps EvalContext::lastChanged to the first func that needs evaluation
+	/// The compiled ExecTokens, which are immutable and can be shared between Evaluators (@see EvaluatorCache)
+	struct Code
+	{
+		Code(size_t nf, size_t nin);
+		~Code();
+		CP_PARSER::ExecToken **funcs;
+		int                   *start;
+	};
+	
+	Evaluator() : funcs(NULL), start(NULL), ctx(NULL){ } ///< For EvaluatorCache
+	
+	std::shared_ptr<const Code>    code;
+	CP_PARSER::ExecToken         **funcs; /// NULL-terminated, = code->funcs
+	int                           *start; /// Maps EvalContext::lastChanged to the first func that needs evaluation, = code->start
 	EvalContext                   *ctx;   /// template context, has all constants and space for all intermediate results
 	std::map<const Element *, int> var_indexes; /// @see var_index
 	
 	friend class BoundContext;
+	friend class FloatContext;
+	friend class DeepZoom;
+	friend class EvaluatorCache;
+	friend class EvalProfile;
 };
 
@@ -0,0 +1,196 @@
+#include "EvaluatorCache.h"
+#include "WorkingTree.h"
+#include "../Namespace/Expression.h"
+#include "../Namespace/UserFunction.h"
+#include "../Namespace/Parameter.h"
+#include "../Namespace/Variable.h"
+#include "../Namespace/Constant.h"
+#include "../../Utility/Mutex.h"
+
+#include <list>
+#include <unordered_map>
+#include <algorithm>
+
+#define MAX_ENTRIES 256
+
+struct EvaluatorCache::Entry
+{
+	Entry(const Evaluator &ev) : code(ev.code), ctx(*ev.ctx){ }
+
+	std::shared_ptr<const Evaluator::Code> code;
+	EvalContext      ctx;    ///< template context (constants, zeroed intermediates)
+	std::vector<int> vars;   ///< var_order[i] --> its index in ctx or -1 if unused
+	std::vector<int> params; ///< parameters (in order of appearance) --> their index in ctx or -1
+};
+
+// most recently used entries at the front
+typedef std::list<std::pair<std::string, EvaluatorCache::Entry>> EntryList;
+static EntryList entries;
+static std::unordered_map<std::string, EntryList::iterator> key_index;
+static Mutex lock;
+
+//----------------------------------------------------------------------------------------------------------------------
+// key generation
+//----------------------------------------------------------------------------------------------------------------------
+
+EvaluatorCache::EvaluatorCache(const WorkingTree &wt, const std::vector<const Variable *> &var_order)
+: var_order(var_order), tree_vars(&var_order), ok(false)
+{
+	key.reserve(256);
+	ok = add(wt, NULL);
+}
+
+EvaluatorCache::EvaluatorCache(const std::vector<const WorkingTree *> &wts,
+                               const std::vector<std::vector<const Variable *>> &vars)
+: var_order(vars[0]), tree_vars(NULL), ok(false)
+{
+	assert(!wts.empty() && wts.size() == vars.size());
+	key.reserve(256*wts.size());
+	key += 'G'; // parameters are numbered across all trees
+	for (size_t k = 0; k < wts.size(); ++k)
+	{
+		if (vars[k].size() != var_order.size()) return;
+		key += '|';
+		tree_vars = &vars[k];
+		if (!add(*wts[k], NULL)) return;
+	}
+	ok = true;
+}
+
+static void add_number(std::string &key, char tag, const cnum &z)
+{
+	char buf[64]; // %a is exact
+	snprintf(buf, 63, "%c%a,%a", tag, z.real(), z.imag());
+	key += buf;
+}
+
+bool EvaluatorCache::add(const WorkingTree &t, const std::vector<Variable *> *args)
+{
+	switch (t.type)
+	{
+		case WorkingTree::TT_Root:     key += 'R'; break;
+		case WorkingTree::TT_Sum:      key += 'S'; break;
+		case WorkingTree::TT_Product:  key += 'M'; break;
+		case WorkingTree::TT_Number:   add_number(key, '#', (cnum)t); break;
+		case WorkingTree::TT_Constant: add_number(key, 'C', t.constant->value()); break;
+
+		case WorkingTree::TT_Variable:
+		{
+			// arguments of UserFunctions are numbered, everything else by its position in var_order
+			if (args)
+			{
+				auto i = std::find(args->begin(), args->end(), t.variable);
+				if (i == args->end()) return false;
+				key += format("A%d", (int)(i - args->begin()));
+			}
+			else
+			{
+				auto i = std::find(tree_vars->begin(), tree_vars->end(), t.variable);
+				if (i == tree_vars->end()) return false;
+				key += format("X%d%c", (int)(i - tree_vars->begin()), t.variable->real() ? 'r' : 'c');
+			}
+			break;
+		}
+
+		case WorkingTree::TT_Parameter:
+		{
+			auto i = std::find(params.begin(), params.end(), t.parameter);
+			if (i == params.end()) i = params.insert(i, t.parameter);
+			key += format("P%d%c", (int)(i - params.begin()), t.parameter->is_real() ? 'r' : 'c');
+			break;
+		}
+
+		case WorkingTree::TT_Function:
+		case WorkingTree::TT_Operator:
+		{
+			const Function *f = t.function;
+			if (f->base())
+			{
+				// the ExecTokens only store the function pointers, which are the same in every RootNamespace
+				key += format("F%s/%d", f->name().c_str(), f->arity());
+			}
+			else
+			{
+				// the applied definition is inlined by OptimizingTree, so it must be part of the key
+				const UserFunction *uf = (const UserFunction*)f;
+				const Expression *fx = uf->expression();
+				if (!fx || !fx->valid() || !fx->wt()) return false;
+				std::vector<Variable*> uf_args = uf->arguments();
+				key += "U{";
+				if (!add(*fx->wt(), &uf_args)) return false;
+				key += '}';
+			}
+			break;
+		}
+	}
+
+	if (t.num_children() > 0)
+	{
+		char sep = '(';
+		for (auto &c : t)
+		{
+			key += sep; sep = ',';
+			if (!add(c, args)) return false;
+		}
+		key += ')';
+	}
+	return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// lookup and storage
+//----------------------------------------------------------------------------------------------------------------------
+
+Evaluator *EvaluatorCache::find() const
+{
+	if (!ok) return NULL;
+	Lock guard(lock);
+
+	auto it = key_index.find(key);
+	if (it == key_index.end()) return NULL;
+	entries.splice(entries.begin(), entries, it->second);
+	const Entry &e = it->second->second;
+	assert(e.vars.size() == var_order.size() && e.params.size() == params.size());
+
+	Evaluator *ev = new Evaluator;
+	ev->code  = e.code;
+	ev->funcs = e.code->funcs;
+	ev->start = e.code->start;
+	ev->ctx   = new EvalContext(e.ctx);
+	for (size_t i = 0; i < var_order.size(); ++i) if (e.vars[i] >= 0) ev->var_indexes[var_order[i]] = e.vars[i];
+	for (size_t i = 0; i < params.size(); ++i) if (e.params[i] >= 0) ev->var_indexes[params[i]] = e.params[i];
+	return ev;
+}
+
+void EvaluatorCache::insert(const Evaluator &ev) const
+{
+	if (!ok || !ev.ctx) return;
+
+	Entry e(ev);
+	for (auto *v : var_order) e.vars.push_back(ev.var_index(v));
+	for (auto *p : params) e.params.push_back(ev.var_index(p)); // can be -1 too, as in 0*a
+
+	Lock guard(lock);
+
+	auto it = key_index.find(key);
+	if (it != key_index.end())
+	{
+		entries.erase(it->second);
+		key_index.erase(it);
+	}
+	entries.emplace_front(key, std::move(e));
+	key_index[key] = entries.begin();
+
+	while (entries.size() > MAX_ENTRIES)
+	{
+		key_index.erase(entries.back().first);
+		entries.pop_back();
+	}
+}
+
+void EvaluatorCache::clear()
+{
+	Lock guard(lock);
+	key_index.clear();
+	entries.clear();
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Evaluator.h"
+
+#include <string>
+#include <vector>
+
+class WorkingTree;
+
+/**
+ * Process-wide cache of compiled Evaluators.
+ *
+ * Building an Evaluator (OptimizingTree, optimize() and the scheduling of the ExecTokens) is by far the most expensive
+ * part of the parsing ladder. Identical expressions in different graphs and expressions that are edited back to an
+ * earlier state (undo/redo) can share the compiled code instead.
+ *
+ * The key is a canonical form of the WorkingTree where variables are replaced by their position in var_order,
+ * parameters by their order of appearance and UserFunctions by their current definition, so it does not depend on
+ * the addresses of the (per-graph) Variable objects.
+ *
+ * Usage:
+ * @code
+ * EvaluatorCache cache(wt, var_order);
+ * Evaluator *ev = cache.find();
+ * if (!ev){ ev = new Evaluator(...); cache.insert(*ev); }
+ * @endcode
+ */
+
+class EvaluatorCache
+{
+public:
+	/// Computes the key for wt. Does not modify the cache.
+	EvaluatorCache(const WorkingTree &wt, const std::vector<const Variable *> &var_order);
+
+	/// Key for several trees that are compiled into one Evaluator (@see Expression::fused_evaluator). The variables
+	/// of wts[k] are numbered by their position in vars[k], the Evaluator uses vars[0] as var_order.
+	EvaluatorCache(const std::vector<const WorkingTree *> &wts, const std::vector<std::vector<const Variable *>> &vars);
+
+	/// @return false if wt can not be cached (uses variables that are not in var_order, invalid UserFunctions, ...)
+	bool valid() const{ return ok; }
+
+	/// @return A new Evaluator that shares its code with the cached one (caller takes ownership) or NULL on a miss.
+	Evaluator *find() const;
+
+	/// Store the code of ev, which must have been created for the tree and var_order that were passed to the constructor.
+	void insert(const Evaluator &ev) const;
+
+	static void clear(); ///< Drop all cached code (Evaluators that share it stay valid)
+
+	struct Entry; ///< Only used internally
+
+private:
+
+	const std::vector<const Variable *> &var_order;
+	const std::vector<const Variable *> *tree_vars;   ///< var_order of the tree that add() is working on
+	std::vector<const Element *>         params; ///< Parameters in order of appearance
+	std::string                          key;
+	bool                                 ok;
+
+	bool add(const WorkingTree &t, const std::vector<Variable *> *args);
+};
+
@@ -8,6 +8,8 @@
 
 class Evaluator;
 class BoundContext;
+class FloatContext;
+class DeepZoom;
 class OptimizingTree;
 
 namespace CP_PARSER
@@ -67,6 +69,8 @@ namespace CP_PARSER
 
 		friend class ::Evaluator;    // its print(...) method
 		friend class ::BoundContext; // its constructor
+		friend class ::FloatContext; // same
+		friend class ::DeepZoom;     // finds mandel and julia
 	};
 	
 	#define P0 ctx.stack[param_index[0]]
@@ -0,0 +1,82 @@
+#include "FloatContext.h"
+#include <cfloat>
+#include <cstring>
+
+// can v be stored as a float without overflowing or flushing to zero?
+static inline bool fits(const cnum &v)
+{
+	if (v.imag() != 0.0) return false;
+	double a = fabs(v.real());
+	return a == 0.0 || (a >= FLT_MIN && a <= FLT_MAX) || std::isnan(a);
+}
+
+bool FloatContext::supports(const Evaluator &e)
+{
+	if (!e.ctx || !e.funcs) return false;
+	const EvalContext &c = *e.ctx;
+	for (int i = 0; i < c.size; ++i) if (!fits(c.stack[i])) return false;
+
+	using CP_PARSER::ExecToken;
+	for (ExecToken **F = e.funcs; *F; ++F)
+	{
+		switch ((*F)->type())
+		{
+			case ExecToken::Exec_1RR: case ExecToken::Exec_2RR: case ExecToken::Exec_3RR: break;
+
+			case ExecToken::Exec_1RC:
+			case ExecToken::Exec_2RC:
+			{
+				// the float variants return NAN instead of complex values, which is only equivalent
+				// for the outputs (everything else would not have been compiled to real tokens anyway)
+				long r = (*F)->result_index;
+				if (r < c.nin || r >= c.nin + c.nout) return false;
+				for (ExecToken **G = e.funcs; *G; ++G)
+				{
+					for (int k = 0; k < 4; ++k) if ((*G)->param_index[k] == r) return false;
+				}
+				break;
+			}
+
+			default: return false;
+		}
+		if (!BaseFunction::single((*F)->function())) return false;
+	}
+	return true;
+}
+
+FloatContext::FloatContext(const Evaluator &e)
+: funcs(NULL), start(new int[e.ctx->nin+1]), stack(new float[e.ctx->size]), out(new cnum[e.ctx->nout])
+, last_change(e.ctx->last_change), bad(-1), nin(e.ctx->nin), nout(e.ctx->nout)
+{
+	assert(supports(e));
+	const EvalContext &c = *e.ctx;
+	for (int i = 0; i < c.size; ++i) stack[i] = (float)c.stack[i].real();
+	for (int i = 0; i < nout; ++i) out[i] = UNDEFINED;
+	memcpy(start, e.start, (nin+1)*sizeof(int));
+
+	int nf = 0;
+	for (CP_PARSER::ExecToken **F = e.funcs; *F; ++F) ++nf;
+
+	funcs = new FCall[nf+1];
+	funcs[nf].function = NULL;
+
+	for (int i = 0; i < nf; ++i)
+	{
+		CP_PARSER::ExecToken &F = *e.funcs[i];
+		FCall &f = funcs[i];
+
+		assert(F.result_index >= nin && F.result_index < c.size);
+		f.result   = stack + F.result_index;
+		f.arity    = 0;
+		for (int k = 0; k < 3; ++k)
+		{
+			assert(F.param_index[k] < c.size);
+			if (F.param_index[k] < 0){ f.param[k] = NULL; continue; }
+			f.param[k] = stack + F.param_index[k];
+			++f.arity;
+		}
+		assert(F.param_index[3] < 0);
+		f.function = BaseFunction::single(F.function());
+		assert(f.function && f.arity >= 1);
+	}
+}
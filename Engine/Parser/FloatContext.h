@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Evaluator.h"
+#include "FPTR.h"
+#include <cfloat>
+#include <cmath>
+
+/**
+ * Single precision variant of BoundContext for real expressions.
+ * Works only if every ExecToken of the Evaluator takes and returns real values and has a float variant (@see
+ * BaseFunction::single). That is the case for most R->R and R2->R graphs and for parametric curves and surfaces,
+ * whose results end up as floats anyway. The outputs are converted back to cnum, so FloatContext can take the
+ * place of a BoundContext (@see DI_Calc::single, ThreadInfo).
+ * eval reports values that float can not hold (overflow, underflow, NAN), and the caller should then evaluate that
+ * point in double precision.
+ */
+
+class FloatContext
+{
+public:
+	/// Can e be evaluated in single precision?
+	static bool supports(const Evaluator &e);
+
+	explicit FloatContext(const Evaluator &e); ///< supports(e) must be true
+
+	~FloatContext()
+	{
+		delete [] funcs;
+		delete [] start;
+		delete [] stack;
+		delete [] out;
+	}
+
+	FloatContext(const FloatContext &) = delete;
+	FloatContext &operator= (const FloatContext &) = delete;
+
+	/// @return false if any value on the way was out of range for float
+	inline bool eval() const
+	{
+		int i0 = start[last_change+1];
+		if (bad >= i0) bad = -1; // gets recalculated
+		for (FCall *F = funcs + i0; F->function; ++F)
+		{
+			call(*F);
+			if (bad < 0 && !in_range(*F->result)) bad = (int)(F - funcs);
+		}
+		last_change = -1;
+		for (int i = 0; i < nout; ++i) out[i] = stack[nin+i];
+		return bad < 0;
+	}
+
+	inline void set_input(int i, double value)
+	{
+		assert(i >= 0 && i < nin);
+		stack[i] = (float)value;
+		if(i > last_change) last_change = i;
+	}
+
+	inline float input(int i) const{ assert(i < nin); return stack[i]; }
+
+	/// All outputs of the last eval as complex numbers (NAN where undefined)
+	inline const cnum *outputs() const{ return out; }
+
+	inline int n_inputs   () const{ return nin; }
+	inline int n_outputs  () const{ return nout; }
+
+private:
+	struct FCall
+	{
+		float       *result;
+		const float *param[3];
+		FPTR         function;
+		int          arity;
+	};
+	FCall *funcs; // terminated by an FCall with function == NULL
+	int   *start; // from Evaluator
+
+	// far enough from FLT_MAX that the next operation does not overflow silently, and not denormalized
+	static inline bool in_range(float x)
+	{
+		float a = fabsf(x);
+		return a == 0.0f || (a >= FLT_MIN && a <= 1e30f); // false for NAN
+	}
+
+	static inline void call(const FCall &F)
+	{
+		#define P(i) (*F.param[i])
+		#define f(T) ((T*)F.function)
+		switch (F.arity)
+		{
+			case 1: *F.result = f(ufuncFF)(P(0)); break;
+			case 2: *F.result = f(bfuncFF)(P(0), P(1)); break;
+			case 3: *F.result = f(tfuncFF)(P(0), P(1), P(2)); break;
+		}
+		#undef P
+		#undef f
+	}
+
+	mutable float *stack;
+	mutable cnum  *out;
+	mutable int    last_change;
+	mutable int    bad; // index of the first FCall with an out of range result or -1
+	int            nin, nout;
+};
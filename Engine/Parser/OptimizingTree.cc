@@ -6,6 +6,7 @@
 #include "../Namespace/Variable.h"
 #include "../Namespace/Function.h"
 #include "../Namespace/UserFunction.h"
+#include "../Namespace/Expression.h"
 #include "../Namespace/Parameter.h"
 #include <assert.h>
 #include <string>
@@ -74,7 +75,79 @@ std::ostream &operator<<(std::ostream &out, const OptimizingTree &tree)
 //  Constructor, Destructor
 //----------------------------------------------------------------------------------------------------------------------
 
+OptimizingTree *OptimizingTree::build(const WorkingTree *wt, ParsingResult &result, const Bindings *b)
+{
+	assert(wt);
+	
+	// skip trivial sums and products, so their only child can be bound or expanded
+	while ((wt->type == WorkingTree::TT_Sum || wt->type == WorkingTree::TT_Product) && wt->num_children() == 1)
+	{
+		wt = &wt->child(0);
+	}
+	
+	if (b && wt->type == WorkingTree::TT_Variable)
+	{
+		auto i = b->find(wt->variable);
+		if (i != b->end()) return i->second;
+	}
+	
+	if (wt->is_function() && !wt->function->base())
+	{
+		return expand(*(const UserFunction*)wt->function, *wt, result, b);
+	}
+	
+	return new OptimizingTree(wt, result, b);
+}
+
+OptimizingTree *OptimizingTree::expand(const UserFunction &f, const WorkingTree &call, ParsingResult &result,
+                                       const Bindings *b)
+{
+	// Every argument is converted once and shared by all its uses in the definition. Substituting them into
+	// the WorkingTree (as UserFunction::apply does) would copy them for every use, which grows exponentially
+	// for nested helper functions like f(f(f(x))), and it would evaluate nondeterministic arguments repeatedly.
+	// Constant arguments are folded into the definition by calculate() and repeated calls with the same
+	// arguments are merged into one by merge().
+	
+	const Expression *fx = f.valid() ? f.expression() : NULL;
+	const WorkingTree *def = fx ? fx->wt() : NULL;
+	if (def && def->type == WorkingTree::TT_Root) def = (def->num_children() == 1 ? &def->child(0) : NULL);
+	
+	const std::vector<Variable*> &vars = f.arguments();
+	if (!def || (int)vars.size() != call.num_children())
+	{
+		result.error("Invalid subexpression", 0, 0);
+		throw result;
+	}
+	
+	Bindings args;
+	std::vector<OptimizingTree*> retained;
+	try
+	{
+		for (int i = 0; i < call.num_children(); ++i)
+		{
+			OptimizingTree *a = build(&call.child(i), result, b)->retain();
+			retained.push_back(a);
+			args[vars[i]] = a;
+		}
+		
+		OptimizingTree *ret = build(def, result, &args)->retain();
+		for (auto *a : retained) a->release(); // deletes unused arguments
+		ret->release_dont_delete(false);       // might be one of the arguments or a new tree
+		return ret;
+	}
+	catch(...)
+	{
+		for (auto *a : retained) a->release();
+		throw;
+	}
+}
+
 OptimizingTree::OptimizingTree(const WorkingTree *wt, ParsingResult &result)
+: OptimizingTree(wt, result, NULL)
+{
+}
+
+OptimizingTree::OptimizingTree(const WorkingTree *wt, ParsingResult &result, const Bindings *b)
 {
 	assert(wt);
 	std::vector<WorkingTree *> tmpTrees; // for applied UserFunctions
@@ -85,7 +158,7 @@ Restart:
 		case WorkingTree::TT_Root:
 			type = OT_Function;
 			function = NULL;
-			for (auto &c : *wt) add_child(new OptimizingTree(&c, result));
+			for (auto &c : *wt) add_child(build(&c, result, b));
 			return;
 			
 		case WorkingTree::TT_Variable:
@@ -118,11 +191,13 @@ Restart:
 			if (f->base())
 			{
 				function = (BaseFunction*)f;
-				for(auto &c : *wt) add_child(new OptimizingTree(&c, result));
+				for(auto &c : *wt) add_child(build(&c, result, b));
 				assert(function);
 			}
 			else
 			{
+				// only reached from the public constructor, build() calls expand() instead
+				assert(!b);
 				const UserFunction *uf = (const UserFunction*)f;
 				WorkingTree *r = uf->apply(wt->children);
 				if (!r)
@@ -167,14 +242,14 @@ Restart:
 			const BinaryOperator *sub = (sum ? wt->ns().Minus  : wt->ns().Div);
 			const UnaryOperator  *neg = (sum ? wt->ns().UMinus : wt->ns().Invert);
 			
-			add_child(new OptimizingTree(&wt->child(0), result));
+			// a0 + a1 - a2 + a3 = ((a0 + a1) - a2) + a3
 			OptimizingTree *dst = this;
 			for (int i = wt->num_children()-1; i >= 1; --i)
 			{
 				OptimizingTree *c1;
 				if (i == 1)
 				{
-					c1 = new OptimizingTree(&wt->child(0), result);
+					c1 = build(&wt->child(0), result, b);
 				}
 				else
 				{
@@ -187,12 +262,12 @@ Restart:
 				if (c.is_operator(neg))
 				{
 					dst->function = sub;
-					dst->add_child(new OptimizingTree(&c.child(0), result));
+					dst->add_child(build(&c.child(0), result, b));
 				}
 				else
 				{
 					dst->function = add;
-					dst->add_child(new OptimizingTree(&c, result));
+					dst->add_child(build(&c, result, b));
 				}
 				
 				dst = c1;
@@ -230,20 +305,48 @@ OptimizingTree *OptimizingTree::copier(OptimizingTree *tree_to_copy, const RootN
 	return ret;
 }
 
+OptimizingTree *OptimizingTree::fuse(const std::vector<OptimizingTree*> &roots)
+{
+	// outputs of roots[k] are appended to those of roots[0], so the following merge() can share their subtrees
+	assert(!roots.empty());
+	OptimizingTree *ret = roots[0];
+	for (size_t k = 1; k < roots.size(); ++k)
+	{
+		OptimizingTree *r = roots[k];
+		assert(r->root() && r != ret);
+		for (auto *c : r->children) ret->add_child(c);
+		delete r;
+	}
+	return ret;
+}
+
+void OptimizingTree::substitute(const std::map<const Element *, const Element *> &vars, std::set<OptimizingTree*> &visited)
+{
+	if (!visited.insert(this).second) return;
+	if (type == OT_Variable)
+	{
+		auto i = vars.find(variable);
+		if (i != vars.end()) variable = i->second;
+		return;
+	}
+	for (auto *c : children) c->substitute(vars, visited);
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 //  Updating methods for deterministic and real flags
 //----------------------------------------------------------------------------------------------------------------------
 
-void OptimizingTree::update_deterministic()
+void OptimizingTree::update_deterministic(std::set<OptimizingTree*> &visited)
 {
 	if (type != OT_Function)
 	{
 		deterministic = true;
 		return;
 	}
+	if (!visited.insert(this).second) return;
 	for (auto x : children)
 	{
-		x->update_deterministic();
+		x->update_deterministic(visited);
 	}
 	for (auto x : children)
 	{
@@ -252,9 +355,10 @@ void OptimizingTree::update_deterministic()
 	deterministic = (!function || function->deterministic());
 }
 
-void OptimizingTree::update_real()
+void OptimizingTree::update_real(std::set<OptimizingTree*> &visited)
 {
-	for (auto c : children) c->update_real();
+	if (!visited.insert(this).second) return;
+	for (auto c : children) c->update_real(visited);
 	switch(type)
 	{
 		case OT_Variable:
@@ -284,11 +388,11 @@ void OptimizingTree::update_real()
 //  Calculate as much as possible
 //----------------------------------------------------------------------------------------------------------------------
 
-void OptimizingTree::calculate()
+void OptimizingTree::calculate(std::set<OptimizingTree*> &visited)
 {
-	if(type != OT_Function) return;
+	if(type != OT_Function || !visited.insert(this).second) return;
 	size_t nc = children.size();
-	for(auto x : children) x->calculate();
+	for(auto x : children) x->calculate(visited);
 	
 	if(root() || !deterministic) return;
 	
@@ -304,7 +408,8 @@ void OptimizingTree::calculate()
 	}
 	type = OT_Constant;
 	value = new cnum(z);
-	Super::reset();
+	for (auto x : children) x->release(); // not Super::reset() because this can be shared
+	children.clear();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -317,15 +422,18 @@ void OptimizingTree::merge()
 	// first we merge all constants and vars - afterwards we can compare them by pointer
 	std::unordered_map<cnum,OptimizingTree*,cnum_hash> nums;
 	std::map<const Element *, OptimizingTree *> vars;
-	merge_const(nums, vars);
-	
 	std::set<OptimizingTree*> visited;
-	merge_funcs(this, visited);
+	merge_const(nums, vars, visited);
+	
+	visited.clear();
+	FuncIndex index;
+	merge_funcs(this, visited, index);
 }
 
 void OptimizingTree::merge_const(std::unordered_map<cnum,OptimizingTree*,cnum_hash> &nums,
-								 std::map<const Element *, OptimizingTree *> &vars)
+								 std::map<const Element *, OptimizingTree *> &vars, std::set<OptimizingTree*> &visited)
 {
+	if (!visited.insert(this).second) return;
 	size_t nc = children.size();
 	for(size_t i = 0; i < nc; ++i)
 	{
@@ -363,53 +471,52 @@ void OptimizingTree::merge_const(std::unordered_map<cnum,OptimizingTree*,cnum_ha
 		}
 		else
 		{
-			c->merge_const(nums, vars);
+			c->merge_const(nums, vars, visited);
 		}
 	}
 }
 
-static bool can_merge_funcs(const OptimizingTree &a, const OptimizingTree &b)
+static bool can_merge_funcs(const OptimizingTree &a)
 {
 	// never merge non-deterministic nodes (random()+random() != 2random())
-	if (!a.deterministic || !b.deterministic) return false;
-	
-	// merge only functions, the rest is done by MergeConst
-	if (a.type != OptimizingTree::OT_Function || b.type != OptimizingTree::OT_Function) return false;
-	
-	if (a.root() || b.root() || a.function != b.function) return false;
-	int nc = a.num_children(); if (nc != b.num_children()) return false;
-	
-	// return true if all children are already merged
-	for (int i = 0; i < nc; ++i) if (a.child(i) != b.child(i)) return false;
-	return true;
+	// and merge only functions, the rest is done by MergeConst
+	return a.deterministic && a.type == OptimizingTree::OT_Function && !a.root();
 }
 
-void merge_funcs(OptimizingTree *tree, std::set<OptimizingTree*> &visited)
+void merge_funcs(OptimizingTree *tree, std::set<OptimizingTree*> &visited, OptimizingTree::FuncIndex &index)
 {
-	// visited contains all unique subtrees we have seen so far
+	// visited contains all unique subtrees we have seen so far, index all of those that can be merged,
+	// keyed by their function and (already merged) children.
 	size_t nc = tree->children.size();
 	for(size_t i = 0; i < nc; ++i)
 	{
-		merge_funcs(tree->children[i], visited);
+		OptimizingTree *c = tree->children[i];
+		if (!visited.count(c)) merge_funcs(c, visited, index);
 	}
 	for(size_t i = 0; i < nc; ++i)
 	{
 		OptimizingTree *c = tree->children[i];
-		if(c->type != OptimizingTree::OT_Function) continue;
-		for(std::set<OptimizingTree*>::iterator it = visited.begin(); it != visited.end(); ++it)
+		if(c->type != OptimizingTree::OT_Function || visited.count(c)) continue;
+		if (can_merge_funcs(*c))
 		{
-			if(can_merge_funcs(*c, **it))
+			std::vector<const void *> key;
+			key.reserve(c->children.size()+1);
+			key.push_back(c->function);
+			for (auto *cc : c->children) key.push_back(cc);
+			
+			auto it = index.find(key);
+			if (it != index.end())
 			{
 #ifdef PARSER_DEBUG
 				std::cerr << "Merging " << *c << std::endl;
 #endif
-				assert(!visited.count(c));
-				tree->children[i] = *it;
+				tree->children[i] = it->second;
 				tree->children[i]->retain();
-				c->release(); c = NULL;
-				break;
+				c->release();
+				continue;
 			}
+			index[key] = c;
 		}
-		if(c) visited.insert(c);
+		visited.insert(c);
 	}
 }
@@ -12,9 +12,13 @@
 #include <cassert>
 
 class WorkingTree;
+class UserFunction;
+class Variable;
 
 /**
  * A simplified version of ParsingTree which can be optimized more easily.
+ * UserFunctions are expanded while building it. Their arguments are converted only once and then shared by
+ * every use in the definition, so it is a DAG rather than a tree and all traversals must be able to handle that.
  */
 class OptimizingTree : public RetainTree<OptimizingTree>
 {
@@ -23,9 +27,10 @@ public:
 	
 	explicit OptimizingTree(const WorkingTree *wt, ParsingResult &result);
 	static OptimizingTree *copier(OptimizingTree *tree_to_copy, const RootNamespace &rns);
+	static OptimizingTree *fuse(const std::vector<OptimizingTree*> &roots); ///< Moves all outputs into roots[0]
 	~OptimizingTree(); // only ever delete the root!
 	
-	void optimize()
+	void optimize(const RootNamespace &rns)
 	{
 		/// @todo support associativity and commutativity while merging
 		/// @todo support associativity in calculate optimization
@@ -33,11 +38,20 @@ public:
 		update_deterministic();
 		calculate();
 		merge();
+		
+		reduce(rns);
+		update_deterministic(); // for the new nodes
+		calculate();
+		merge();
 	}
 	
 	bool root() const{ return type == OT_Function && function == NULL; }
+	void substitute(const std::map<const Element *, const Element *> &vars) ///< Replace variables, before optimize()
+	{
+		std::set<OptimizingTree*> visited; substitute(vars, visited);
+	}
 	bool has_real_children() const{ for (auto c : children) if (!c->real) return false; return true; }
-	void update_real(); /// Figure out which nodes are real and which are complex.
+	void update_real(){ std::set<OptimizingTree*> visited; update_real(visited); } /// Figure out which nodes are real and which are complex.
 	
 	enum OTType
 	{
@@ -64,10 +78,31 @@ public:
 	}
 	
 private:
-	void update_deterministic();
-	void calculate();
+	typedef std::map<const Variable *, OptimizingTree *> Bindings; // UserFunction arguments
+	
+	static OptimizingTree *build(const WorkingTree *wt, ParsingResult &result, const Bindings *b);
+	static OptimizingTree *expand(const UserFunction &f, const WorkingTree &call, ParsingResult &result, const Bindings *b);
+	OptimizingTree(const WorkingTree *wt, ParsingResult &result, const Bindings *b);
+	
+	void substitute(const std::map<const Element *, const Element *> &vars, std::set<OptimizingTree*> &visited);
+	void update_deterministic(std::set<OptimizingTree*> &visited);
+	void update_real(std::set<OptimizingTree*> &visited);
+	void calculate(std::set<OptimizingTree*> &visited);
 	void merge();
 	
+	/// Strength reduction: replaces expensive functions with cheaper equivalents (integer powers with
+	/// multiplications, polynomials with Horner's scheme, complex functions with real ones where the ranges of
+	/// their arguments allow it, etc). Nodes are only rewritten in place and unshared ones dropped, so nothing
+	/// is calculated twice. @see OptimizingTreeReduce.cc
+	void reduce(const RootNamespace &rns);
+	void become(OptimizingTree *t); ///< Take the function and children of a new node t, which is deleted
+	static OptimizingTree *node(const BaseFunction *f, OptimizingTree *a, OptimizingTree *b = NULL);
+	static OptimizingTree *constant(const cnum &z);
+	friend class Reducer;
+	
+	void update_deterministic(){ std::set<OptimizingTree*> visited; update_deterministic(visited); }
+	void calculate(){ std::set<OptimizingTree*> visited; calculate(visited); }
+	
 	OptimizingTree();
 	
 	bool equals(OptimizingTree *other);
@@ -77,9 +112,10 @@ private:
 		return std::hash<double>()(z.real()) ^ std::hash<double>()(z.imag()); }
 	};
 	void merge_const(std::unordered_map<cnum,OptimizingTree*,cnum_hash> &nums,
-					 std::map<const Element *, OptimizingTree *> &vars);
+					 std::map<const Element *, OptimizingTree *> &vars, std::set<OptimizingTree*> &visited);
 	
-	friend void merge_funcs(OptimizingTree *tree, std::set<OptimizingTree*> &visited);
+	typedef std::map<std::vector<const void *>, OptimizingTree *> FuncIndex; // (function, children) -> node
+	friend void merge_funcs(OptimizingTree *tree, std::set<OptimizingTree*> &visited, FuncIndex &index);
 };
 
 std::ostream &operator<<(std::ostream &out, const OptimizingTree &tree);
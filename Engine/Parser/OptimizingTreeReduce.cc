@@ -0,0 +1,394 @@
+#include "OptimizingTree.h"
+#include "../Namespace/RootNamespace.h"
+#include "../Namespace/BaseFunction.h"
+#include "../Namespace/Operator.h"
+#include "../Namespace/Variable.h"
+#include "../Namespace/Parameter.h"
+#include "../Functions/Functions.h"
+#include <cmath>
+
+// Cost model: one ExecToken for a cheap real function (+, *, x², ...) takes a few ns, while pow, exp and the
+// complex variants take tens of ns. So x^n (n <= MAX_POWER) is cheaper as a chain of at most 2log2(n) tokens,
+// and wherever an argument is known to be real, the whole subtree after it can stay real.
+#define MAX_POWER 64
+
+typedef OptimizingTree OT;
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Helper methods
+//----------------------------------------------------------------------------------------------------------------------
+
+OptimizingTree *OptimizingTree::node(const BaseFunction *f, OptimizingTree *a, OptimizingTree *b)
+{
+	OptimizingTree *t = new OptimizingTree;
+	t->function = f;
+	t->add_child(a);
+	if (b) t->add_child(b);
+	t->deterministic = f->deterministic() && a->deterministic && (!b || b->deterministic);
+	t->real = false;
+	return t;
+}
+
+OptimizingTree *OptimizingTree::constant(const cnum &z)
+{
+	OptimizingTree *t = new OptimizingTree;
+	t->type = OT_Constant;
+	t->value = new cnum(z);
+	t->deterministic = true;
+	t->real = false;
+	return t;
+}
+
+void OptimizingTree::become(OptimizingTree *t)
+{
+	// this node keeps all its parents, so it must calculate the same value as before
+	assert(type == OT_Function && !root());
+	assert(t->type == OT_Function && t->retainCount() == 0);
+	for (auto *c : t->children) c->retain();
+	for (auto *c : children) c->release(); // deletes the unshared ones
+	children = t->children;
+	function = t->function;
+	t->collect();
+}
+
+static inline bool is_sqrt(const BaseFunction *f)
+{
+	// sqrt and √, but not __rsqrt__
+	return f->arity() == 1 && f->ufrc == (ufuncRC*)sqrt_ && !f->ufrr;
+}
+
+static inline bool is_coefficient(const OT *t)
+{
+	return t->type == OT::OT_Constant || t->type == OT::OT_Variable;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Reducer
+//----------------------------------------------------------------------------------------------------------------------
+
+class Reducer
+{
+public:
+	explicit Reducer(const RootNamespace &rns) : rns(rns){ }
+	~Reducer(){ for (OT *t : held) t->release(); }
+
+	void horner(OT *t); // pre-order, so it sees complete sums
+	void reduce(OT *t); // post-order
+
+private:
+	const RootNamespace &rns;
+
+	// Every node that was visited or has a range is retained until the end, so no new node can get the address
+	// of a deleted one. uses() is the retain count without that.
+	std::set<OT*> held;
+	std::map<const OT*, Range> ranges;
+	void hold(OT *t){ if (!t->root() && held.insert(t).second) t->retain(); }
+	int  uses(OT *t) const{ return t->retainCount() - (int)held.count(t); }
+
+	int power(const BaseFunction *f) const // n for the PowOps
+	{
+		for (int n = 1; n < 10; ++n) if (f == rns.PowOps[n]) return n;
+		return 0;
+	}
+	bool is_pow(const OT *t) const
+	{
+		return t->type == OT::OT_Function && (t->function == rns.Pow || t->function == rns.PowStar);
+	}
+
+	// Range of the values t can take. Only tracks Complex, Real and NonNegative: nothing can be Positive
+	// with floating point underflow.
+	Range range(OT *t);
+	Range function_range(OT *t);
+	bool nonnegative(OT *t){ return subset(range(t), R_NonNegative); }
+	bool real(OT *t){ return subset(range(t), R_Real); }
+
+	OT *power(OT *x, int n);
+	void powers(OT *t);
+
+	struct Term
+	{
+		OT  *node; // the whole term
+		bool neg;  // subtracted?
+		OT  *coef; // NULL for 1
+		OT  *base; // node = coef * base^k
+		int  k;
+	};
+	void terms(OT *t, bool neg, bool top, std::vector<Term> &ret);
+	void monomial(OT *p, Term &x);
+	OT  *leading(const Term &lead, OT *x);
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Ranges
+//----------------------------------------------------------------------------------------------------------------------
+
+Range Reducer::range(OT *t)
+{
+	auto i = ranges.find(t);
+	if (i != ranges.end()) return i->second;
+
+	Range r = R_Complex;
+	switch (t->type)
+	{
+		case OT::OT_Constant:
+		{
+			// not ::range, which allows for rounding errors
+			const cnum &z = *t->value;
+			if (z.imag() == 0.0) r = z.real() >= 0.0 ? R_NonNegative : R_Real;
+			break;
+		}
+		case OT::OT_Variable:
+			// Parameter::range depends on its current limits, which can change without rebuilding the Evaluator
+			if (t->variable->isVariable() ? ((const Variable*)t->variable)->real()
+			                              : ((const Parameter*)t->variable)->is_real()) r = R_Real;
+			break;
+		case OT::OT_Function:
+			r = function_range(t);
+			break;
+	}
+	hold(t);
+	ranges[t] = r;
+	return r;
+}
+
+Range Reducer::function_range(OT *t)
+{
+	const BaseFunction *f = t->function;
+	bool real = true, nonneg = true;
+	for (auto *c : t->children)
+	{
+		Range r = range(c);
+		real   = real   && subset(r, R_Real);
+		nonneg = nonneg && subset(r, R_NonNegative);
+	}
+
+	int n = power(f);
+	if (f == rns.Abs) return R_NonNegative;
+	if (real && (f == rns.Exp || f == rns.Hypot || (n > 0 && n % 2 == 0) ||
+	             (f->arity() == 1 && f->ufrr == (ufuncRR*)sqr) || // sqr and absq
+	             (f == rns.Mul && t->child(0) == t->child(1)))) return R_NonNegative;
+	if (nonneg && (n || f == rns.Plus || f == rns.Mul || f == rns.Div || f == rns.Invert || f == rns.Identity ||
+	               f == rns.UPlus || f == rns.RSqrt || is_sqrt(f) || f == rns.SPow)) return R_NonNegative;
+	return f->is_real(real) ? R_Real : R_Complex;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Powers, division, exp and real variants
+//----------------------------------------------------------------------------------------------------------------------
+
+OT *Reducer::power(OT *x, int n)
+{
+	assert(n >= 1 && n <= MAX_POWER);
+	if (n == 1) return x;
+	if (n <= 9) return OT::node(rns.PowOps[n], x);
+	OT *h = OT::node(rns.PowOps[2], power(x, n/2));
+	return n % 2 ? OT::node(rns.Mul, h, x) : h;
+}
+
+void Reducer::powers(OT *t)
+{
+	// x^n --> x·x·..., x^-n --> 1/(x·x·...), x^±0.5 --> √x or 1/√x
+	const cnum &z = *t->child(1)->value;
+	const double e = z.real();
+	if (z.imag() != 0.0) return;
+
+	OT *x = t->child(0), *p;
+	if (fabs(e) == 0.5)
+	{
+		p = OT::node(nonnegative(x) ? rns.RSqrt : rns.Sqrt, x);
+	}
+	else if (e == std::round(e) && (fabs(e) >= 2.0 && fabs(e) <= MAX_POWER || e == -1.0))
+	{
+		p = power(x, (int)fabs(e));
+	}
+	else
+	{
+		return;
+	}
+	t->become(e < 0.0 ? OT::node(rns.Invert, p) : p);
+}
+
+void Reducer::reduce(OT *t)
+{
+	if (t->type != OT::OT_Function || held.count(t)) return;
+	hold(t);
+	for (auto *c : t->children) reduce(c);
+	if (t->root()) return;
+
+	if (is_pow(t) && t->child(1)->type == OT::OT_Constant) powers(t);
+
+	const BaseFunction *f = t->function;
+	if (f == rns.Div && t->child(1)->type == OT::OT_Constant)
+	{
+		// x/c --> x·(1/c)
+		const cnum &c = *t->child(1)->value;
+		cnum r = 1.0 / c;
+		if (c != 0.0 && defined(r) && r != 0.0) t->become(OT::node(rns.Mul, t->child(0), OT::constant(r)));
+	}
+	else if (f == rns.Mul || f == rns.Div)
+	{
+		// exp(a)·exp(b) --> exp(a+b), exp(a)/exp(b) --> exp(a-b)
+		OT *a = t->child(0), *b = t->child(1);
+		if (a->type == OT::OT_Function && a->function == rns.Exp && uses(a) == 1 &&
+		    b->type == OT::OT_Function && b->function == rns.Exp && uses(b) == 1)
+		{
+			t->become(OT::node(rns.Exp, OT::node(f == rns.Mul ? rns.Plus : rns.Minus, a->child(0), b->child(0))));
+		}
+	}
+
+	// complex --> real variants, which are also real for the Evaluator
+	f = t->function;
+	if (is_sqrt(f) && nonnegative(t->child(0)))
+	{
+		t->function = rns.RSqrt;
+	}
+	else if (is_pow(t) && nonnegative(t->child(0)) && real(t->child(1)))
+	{
+		t->function = rns.SPow;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Horner's scheme: a x³ + b x² + c x + d --> ((a x + b) x + c) x + d
+//----------------------------------------------------------------------------------------------------------------------
+
+void Reducer::terms(OT *t, bool neg, bool top, std::vector<Term> &ret)
+{
+	// flatten the unshared + - and unary - below t
+	if (t->type == OT::OT_Function && (top || uses(t) == 1))
+	{
+		const BaseFunction *f = t->function;
+		if (f == rns.Plus || f == rns.Minus)
+		{
+			terms(t->child(0), neg, false, ret);
+			terms(t->child(1), f == rns.Minus ? !neg : neg, false, ret);
+			return;
+		}
+		if (f == rns.UMinus)
+		{
+			terms(t->child(0), !neg, false, ret);
+			return;
+		}
+	}
+
+	Term x; x.node = t; x.neg = neg; x.coef = NULL;
+	if (t->type == OT::OT_Function && t->function == rns.Mul && uses(t) == 1)
+	{
+		OT *a = t->child(0), *b = t->child(1);
+		if (is_coefficient(a)){ x.coef = a; monomial(b, x); }
+		else if (is_coefficient(b)){ x.coef = b; monomial(a, x); }
+		else monomial(t, x);
+	}
+	else
+	{
+		monomial(t, x);
+	}
+	ret.push_back(x);
+}
+
+void Reducer::monomial(OT *p, Term &x)
+{
+	x.base = p; x.k = 1;
+	if (p->type != OT::OT_Function || uses(p) != 1) return;
+
+	int n = power(p->function);
+	if (n >= 2)
+	{
+		x.base = p->child(0); x.k = n;
+	}
+	else if (is_pow(p) && p->child(1)->type == OT::OT_Constant)
+	{
+		const cnum &z = *p->child(1)->value;
+		if (z.imag() == 0.0 && z.real() == std::round(z.real()) && z.real() >= 2.0 && z.real() <= MAX_POWER)
+		{
+			x.base = p->child(0); x.k = (int)z.real();
+		}
+	}
+}
+
+OT *Reducer::leading(const Term &lead, OT *x)
+{
+	// ±coef·x
+	OT *c = lead.coef;
+	if (!c) return lead.neg ? OT::node(rns.UMinus, x) : x;
+	if (lead.neg) c = (c->type == OT::OT_Constant ? OT::constant(-*c->value) : OT::node(rns.UMinus, c));
+	return OT::node(rns.Mul, c, x);
+}
+
+void Reducer::horner(OT *t)
+{
+	if (t->type != OT::OT_Function || held.count(t)) return;
+	hold(t);
+
+	if (!t->root() && (t->function == rns.Plus || t->function == rns.Minus))
+	{
+		std::vector<Term> T;
+		terms(t, false, true, T);
+
+		// the variable is the base of the highest power
+		OT *x = NULL; int n = 1;
+		for (auto &a : T) if (a.k > n){ x = a.base; n = a.k; }
+		if (!x) goto Children;
+
+		// sort into the polynomial and the rest
+		std::vector<const Term*> poly(n+1, NULL), rest;
+		int np = 0, direct = 0;
+		for (auto &a : T)
+		{
+			if (a.base != x && !a.coef && is_coefficient(a.node))
+			{
+				a.coef = a.node; a.base = x; a.k = 0;
+			}
+			else if (a.base != x && a.coef == x && a.k == 1 && is_coefficient(a.base))
+			{
+				std::swap(a.coef, a.base); // x·y
+			}
+			if (a.base == x && !poly[a.k])
+			{
+				poly[a.k] = &a;
+				++np;
+				direct += (a.k >= 2) + (a.coef && a.k >= 1);
+			}
+			else
+			{
+				rest.push_back(&a);
+			}
+		}
+
+		// n multiplications (the first one could be a negation) and np-1 additions
+		direct += np-1;
+		int cost = n + np-1 - (!poly[n]->coef && !poly[n]->neg ? 1 : 0);
+		if (np - (poly[0] ? 1 : 0) >= 2 && cost < direct)
+		{
+			OT *h = leading(*poly[n], x);
+			for (int j = n-1; j >= 0; --j)
+			{
+				if (j < n-1) h = OT::node(rns.Mul, h, x);
+				const Term *a = poly[j];
+				if (a) h = OT::node(a->neg ? rns.Minus : rns.Plus, h, a->coef ? a->coef : OT::constant(1.0));
+			}
+			for (auto *a : rest) h = OT::node(a->neg ? rns.Minus : rns.Plus, h, a->node);
+			t->become(h);
+		}
+	}
+
+Children:
+	for (auto *c : t->children) horner(c);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Main
+//----------------------------------------------------------------------------------------------------------------------
+
+void OptimizingTree::reduce(const RootNamespace &rns)
+{
+	assert(root());
+	{
+		Reducer r(rns);
+		r.horner(this); // before reduce, which replaces the powers it looks for
+	}
+	{
+		Reducer r(rns);
+		r.reduce(this);
+	}
+}
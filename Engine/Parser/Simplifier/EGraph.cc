@@ -0,0 +1,712 @@
+#include "../WorkingTree.h"
+#include "Pattern.h"
+#include "../../Namespace/Constant.h"
+#include "../../Namespace/Variable.h"
+#include "../../Namespace/Parameter.h"
+#include "../../../Utility/Timer.h"
+#include <climits>
+#include <cstring>
+#include <cassert>
+
+//----------------------------------------------------------------------------------------------------------------------
+// EGraph: equivalence classes of expressions for equality saturation
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Every e-class is a set of equivalent e-nodes (function, sum, product or leaf), whose arguments are e-classes
+ * again, so the graph holds exponentially many equivalent trees in little space. Rules only ever add e-nodes and
+ * merge e-classes, which makes the result independent of their order, and afterwards the cheapest tree in the
+ * e-class of the input is extracted (@see BaseFunction::cost).
+ * Sums and products are n-ary with sorted arguments, so rules match them in any order and also part of a longer
+ * sum or product. + - * / exp sqrt etc. get their normalized forms (@see WorkingTree::normalize) added, which is
+ * what the patterns are written in.
+ */
+class EGraph
+{
+public:
+	EGraph(const RootNamespace &rns) : rns(rns), dirty(false){ }
+
+	int  add(const WorkingTree &t); ///< Returns its e-class
+	void saturate(const std::vector<Rule> &rules);
+
+	int  cost(int c) const{ return best_cost[find(c)]; } ///< Only valid after saturate
+	int  cost(const WorkingTree &t) const;
+	WorkingTree extract(int c) const; ///< Cheapest tree in e-class c
+
+private:
+	typedef std::vector<int> Args;
+	typedef Rule::Pattern    Pattern;
+	typedef std::map<const Pattern*, int> Bindings;
+
+	struct ENode
+	{
+		WorkingTree::Type type;
+		const Element    *element; // NULL for numbers, sums and products
+		cnum              z;       // for numbers
+		Args              args;    // e-classes, sorted for sums and products
+
+		bool operator< (const ENode &n) const
+		{
+			if (type != n.type) return type < n.type;
+			if (element != n.element) return element < n.element;
+			if (type == WorkingTree::TT_Number)
+			{
+				int c = memcmp(&z, &n.z, sizeof(cnum)); // so that NANs have an order too
+				if (c) return c < 0;
+			}
+			return args < n.args;
+		}
+	};
+
+	struct Match
+	{
+		const Rule *rule;
+		int         c;    // matched e-class
+		Bindings    b;
+		Args        rest; // unmatched part of a sum or product
+	};
+
+	const RootNamespace &rns;
+	std::vector<ENode>  nodes;
+	std::vector<int>    home;      // e-class that nodes[i] was added to
+	std::vector<int>    parent;    // union-find of the e-classes
+	std::vector<Args>   members;   // e-nodes in every e-class, empty if merged into another one
+	std::vector<Range>  ranges;    // what is known about the values of every e-class
+	std::map<ENode,int> index;     // hash-consing, outdated while dirty
+	bool                dirty;
+	std::vector<int>    best_cost, best_node;
+
+	int  find(int c) const{ while (parent[c] != c) c = parent[c]; return c; }
+	void canonicalize(ENode &n) const;
+	Range range(const ENode &n) const;
+
+	int  add(ENode &&n);
+	int  number(const cnum &z);
+	int  node(const Function *f, Args &&a);
+	int  node(WorkingTree::Type t, Args &&a);
+	int  negate(int c);
+	int  invert(int c);
+	int  find_node(int c, WorkingTree::Type t) const; ///< Some e-node of type t in e-class c or -1
+
+	bool merge(int a, int b);
+	void rebuild(); ///< Restores the invariants after merge: congruent e-nodes are in the same e-class
+
+	void normalize(int i);
+
+	void match(const Rule &r, int c, std::vector<Match> &out) const;
+	void match(const Pattern *p, int c, const Bindings &b, std::vector<Bindings> &out) const;
+	void match_args(const Pattern *p, const Args &args, int i, const Bindings &b, std::vector<Bindings> &out) const;
+	void match_any (const Pattern *p, const Args &args, int i, unsigned used, const Bindings &b,
+	                std::vector<std::pair<Bindings, unsigned>> &out) const;
+	int  instantiate(const Pattern *p, const Bindings &b);
+
+	int  op_cost(WorkingTree::Type t, const Element *e, size_t n, const cnum *exponent) const;
+	void update_costs();
+};
+
+static const int    MAX_NODES      = 5000;
+static const int    MAX_ITERATIONS = 10;
+static const double MAX_TIME       = 0.02; // seconds
+static const int    INF            = INT_MAX / 4;
+
+//----------------------------------------------------------------------------------------------------------------------
+// building
+//----------------------------------------------------------------------------------------------------------------------
+
+void EGraph::canonicalize(ENode &n) const
+{
+	for (int &a : n.args) a = find(a);
+	if (n.type == WorkingTree::TT_Sum || n.type == WorkingTree::TT_Product) std::sort(n.args.begin(), n.args.end());
+}
+
+static inline Range finite_range(const cnum &z)
+{
+	// values of variables and of everything computed can overflow or be nan, so only
+	// numbers get these (z/z = 1 and the like need them, @see Rules.txt)
+	Range r = ::range(z);
+	if (defined(z)) r |= isz(z) ? R_Finite : R_NonZero;
+	return r;
+}
+
+Range EGraph::range(const ENode &n) const
+{
+	switch (n.type)
+	{
+		case WorkingTree::TT_Root:      assert(false); return R_Complex;
+		case WorkingTree::TT_Number:    return finite_range(n.z);
+		case WorkingTree::TT_Constant:  return finite_range(((const Constant*)n.element)->value());
+		case WorkingTree::TT_Variable:  return ((const Variable*)n.element)->range();
+		case WorkingTree::TT_Parameter: return ((const Parameter*)n.element)->range();
+
+		case WorkingTree::TT_Function:
+		case WorkingTree::TT_Operator:
+		{
+			const Function *f = (const Function*)n.element;
+			if (n.args.empty()) return f->range(R_Complex);
+			Range r = ranges[find(n.args[0])];
+			for (size_t i = 1; i < n.args.size(); ++i) r &= ranges[find(n.args[i])];
+			return f->range(r & ~R_NonZero);
+		}
+
+		case WorkingTree::TT_Sum:
+		case WorkingTree::TT_Product:
+		{
+			// as in WorkingTree::range
+			size_t m = n.args.size(), nr = 0, ni = 0;
+			Range r = ranges[find(n.args[0])];
+			for (int a : n.args)
+			{
+				Range rc = ranges[find(a)];
+				r &= rc;
+				if ((rc & R_Real)) ++nr; else if ((rc & R_Imag)) ++ni;
+			}
+			if (n.type == WorkingTree::TT_Product && nr+ni == m)
+			{
+				r &= ~(R_Imag | R_Real);
+				r |= (ni&1) ? R_Imag : R_Real;
+			}
+			else
+			{
+				r &= ~R_Unit;
+			}
+			return r & ~R_NonZero;
+		}
+	}
+	assert(false); throw std::logic_error("can't happen");
+}
+
+int EGraph::add(ENode &&n)
+{
+	canonicalize(n);
+	if (n.type == WorkingTree::TT_Sum || n.type == WorkingTree::TT_Product)
+	{
+		if (n.args.size() == 1) return n.args[0];
+		if (n.args.empty()) return number(n.type == WorkingTree::TT_Sum ? 0.0 : 1.0);
+	}
+
+	auto i = index.find(n);
+	if (i != index.end()) return find(i->second);
+
+	int c = (int)parent.size();
+	parent.push_back(c);
+	members.push_back(Args(1, (int)nodes.size()));
+	ranges.push_back(range(n));
+	home.push_back(c);
+	nodes.push_back(std::move(n));
+	index.insert(std::make_pair(nodes.back(), c));
+	return c;
+}
+
+int EGraph::add(const WorkingTree &t)
+{
+	ENode n;
+	n.type = t.type;
+	n.element = NULL;
+
+	switch (t.type)
+	{
+		case WorkingTree::TT_Root: assert(false); throw std::logic_error("can't happen");
+
+		case WorkingTree::TT_Number: return number((cnum)t);
+
+		case WorkingTree::TT_Constant:
+		case WorkingTree::TT_Variable:
+		case WorkingTree::TT_Parameter:
+			n.element = t.element;
+			break;
+
+		case WorkingTree::TT_Function:
+		case WorkingTree::TT_Operator:
+			n.element = t.element;
+			// fallthrough
+		case WorkingTree::TT_Sum:
+		case WorkingTree::TT_Product:
+			for (auto &c : t) n.args.push_back(add(c));
+			break;
+	}
+	return add(std::move(n));
+}
+
+int EGraph::number(const cnum &z)
+{
+	ENode n;
+	n.type = WorkingTree::TT_Number;
+	n.element = NULL;
+	n.z = z;
+	return add(std::move(n));
+}
+
+int EGraph::node(const Function *f, Args &&a)
+{
+	ENode n;
+	n.type = f->isOperator() ? WorkingTree::TT_Operator : WorkingTree::TT_Function;
+	n.element = f;
+	n.args = std::move(a);
+	return add(std::move(n));
+}
+
+int EGraph::node(WorkingTree::Type t, Args &&a)
+{
+	assert(t == WorkingTree::TT_Sum || t == WorkingTree::TT_Product);
+	ENode n;
+	n.type = t;
+	n.element = NULL;
+	n.args = std::move(a);
+	return add(std::move(n));
+}
+
+int EGraph::find_node(int c, WorkingTree::Type t) const
+{
+	for (int i : members[find(c)]) if (nodes[i].type == t) return i;
+	return -1;
+}
+
+int EGraph::negate(int c)
+{
+	c = find(c);
+	for (int i : members[c]) if (nodes[i].element == rns.UMinus) return nodes[i].args[0];
+	int k = find_node(c, WorkingTree::TT_Number);
+	if (k >= 0) return number(-nodes[k].z);
+	return node(rns.UMinus, Args(1, c));
+}
+
+int EGraph::invert(int c)
+{
+	c = find(c);
+	for (int i : members[c]) if (nodes[i].element == rns.Invert) return nodes[i].args[0];
+	int r = node(rns.Invert, Args(1, c));
+	int k = find_node(c, WorkingTree::TT_Number);
+	if (k >= 0 && !isz(nodes[k].z)) merge(r, number(inverse(nodes[k].z)));
+	return r;
+}
+
+bool EGraph::merge(int a, int b)
+{
+	a = find(a); b = find(b);
+	if (a == b) return false;
+	if (members[a].size() < members[b].size()) std::swap(a, b);
+	parent[b] = a;
+	members[a].insert(members[a].end(), members[b].begin(), members[b].end());
+	members[b].clear();
+	ranges[a] |= ranges[b];
+	dirty = true;
+	return true;
+}
+
+void EGraph::rebuild()
+{
+	while (dirty)
+	{
+		dirty = false;
+		index.clear();
+		std::vector<std::pair<int,int>> same;
+		for (int c = 0, n = (int)members.size(); c < n; ++c)
+		{
+			if (parent[c] != c) continue;
+			Args keep;
+			for (int i : members[c])
+			{
+				canonicalize(nodes[i]);
+				auto r = index.insert(std::make_pair(nodes[i], c));
+				if (r.second) keep.push_back(i);
+				else if (r.first->second != c) same.push_back(std::make_pair(r.first->second, c));
+			}
+			members[c].swap(keep);
+		}
+		for (auto &p : same) merge(p.first, p.second);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// normal forms
+//----------------------------------------------------------------------------------------------------------------------
+
+void EGraph::normalize(int i)
+{
+	const ENode n = nodes[i]; // nodes can grow
+	int c = find(home[i]);
+
+	switch (n.type)
+	{
+		case WorkingTree::TT_Function:
+		case WorkingTree::TT_Operator:
+		{
+			const Function *f = (const Function*)n.element;
+			const Args &a = n.args;
+			double p;
+
+			if      (f == rns.Plus)    merge(c, node(WorkingTree::TT_Sum, Args({a[0], a[1]})));
+			else if (f == rns.Minus)   merge(c, node(WorkingTree::TT_Sum, Args({a[0], negate(a[1])})));
+			else if (f == rns.Mul)     merge(c, node(WorkingTree::TT_Product, Args({a[0], a[1]})));
+			else if (f == rns.Div)     merge(c, node(WorkingTree::TT_Product, Args({a[0], invert(a[1])})));
+			else if (f == rns.PowStar) merge(c, node(rns.Pow, Args(a)));
+			else if (f == rns.Exp)     merge(c, node(rns.Pow, Args({number(M_E), a[0]})));
+			else if (f == rns.Log_)    merge(c, node(rns.Log, Args(a)));
+			else if (f == rns.UPlus || f == rns.Identity || f == rns.PowOps[1]) merge(c, a[0]);
+			else if (f->is_power(p))   merge(c, node(rns.Pow, Args({a[0], number(p)})));
+			break;
+		}
+
+		case WorkingTree::TT_Sum:
+		case WorkingTree::TT_Product:
+			// flatten, one level at a time, and drop zeros from sums and ones from products
+			for (size_t k = 0; k < n.args.size(); ++k)
+			{
+				Args rest;
+				for (size_t l = 0; l < n.args.size(); ++l) if (l != k) rest.push_back(n.args[l]);
+
+				int j = find_node(n.args[k], n.type);
+				if (j >= 0)
+				{
+					Args a(nodes[j].args);
+					a.insert(a.end(), rest.begin(), rest.end());
+					merge(c, node(n.type, std::move(a)));
+				}
+				j = find_node(n.args[k], WorkingTree::TT_Number);
+				if (j >= 0 && nodes[j].z == cnum(n.type == WorkingTree::TT_Sum ? 0.0 : 1.0))
+				{
+					merge(c, node(n.type, std::move(rest)));
+				}
+			}
+			break;
+
+		default: break;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// matching
+//----------------------------------------------------------------------------------------------------------------------
+
+void EGraph::match(const Pattern *p, int c, const Bindings &b, std::vector<Bindings> &out) const
+{
+	c = find(c);
+	switch (p->type)
+	{
+		case Pattern::TT_Wildcard:
+		{
+			auto i = b.find(p);
+			if (i != b.end())
+			{
+				if (find(i->second) == c) out.push_back(b);
+				return;
+			}
+			if (!subset(ranges[c], p->range)) return;
+			out.push_back(b);
+			out.back().insert(std::make_pair(p, c));
+			return;
+		}
+
+		case Pattern::TT_Constant:
+			for (int i : members[c])
+			{
+				if (nodes[i].type == WorkingTree::TT_Constant && nodes[i].element == p->constant)
+				{
+					out.push_back(b);
+					return;
+				}
+			}
+			return;
+
+		case Pattern::TT_Number:
+			for (int i : members[c])
+			{
+				if (nodes[i].type == WorkingTree::TT_Number && eq(nodes[i].z, p->number))
+				{
+					out.push_back(b);
+					return;
+				}
+			}
+			return;
+
+		case Pattern::TT_Function:
+			for (int i : members[c])
+			{
+				const ENode &n = nodes[i];
+				if (n.element != p->function || n.args.size() != (size_t)p->num_children()) continue;
+				if (n.type != WorkingTree::TT_Function && n.type != WorkingTree::TT_Operator) continue;
+				match_args(p, n.args, 0, b, out);
+			}
+			return;
+
+		case Pattern::TT_Sum:
+		case Pattern::TT_Product:
+		{
+			auto t = p->type == Pattern::TT_Sum ? WorkingTree::TT_Sum : WorkingTree::TT_Product;
+			for (int i : members[c])
+			{
+				const ENode &n = nodes[i];
+				if (n.type != t || n.args.size() != (size_t)p->num_children()) continue;
+				std::vector<std::pair<Bindings, unsigned>> r;
+				match_any(p, n.args, 0, 0, b, r);
+				for (auto &m : r) out.push_back(std::move(m.first));
+			}
+			return;
+		}
+	}
+}
+
+// match the pattern's children to args in order
+void EGraph::match_args(const Pattern *p, const Args &args, int i, const Bindings &b,
+                        std::vector<Bindings> &out) const
+{
+	if (i == (int)args.size()){ out.push_back(b); return; }
+	std::vector<Bindings> r;
+	match(p->child(i), args[i], b, r);
+	for (auto &b1 : r) match_args(p, args, i+1, b1, out);
+}
+
+// match the pattern's children to any distinct args, returns the used ones as bitmask
+void EGraph::match_any(const Pattern *p, const Args &args, int i, unsigned used, const Bindings &b,
+                       std::vector<std::pair<Bindings, unsigned>> &out) const
+{
+	if (i == p->num_children()){ out.push_back(std::make_pair(b, used)); return; }
+	for (size_t j = 0; j < args.size(); ++j)
+	{
+		if (used & (1u << j)) continue;
+		std::vector<Bindings> r;
+		match(p->child(i), args[j], b, r);
+		for (auto &b1 : r) match_any(p, args, i+1, used | (1u << j), b1, out);
+	}
+}
+
+void EGraph::match(const Rule &rule, int c, std::vector<Match> &out) const
+{
+	const Pattern *p = rule.pattern;
+	if (p->type == Pattern::TT_Sum || p->type == Pattern::TT_Product)
+	{
+		auto t = p->type == Pattern::TT_Sum ? WorkingTree::TT_Sum : WorkingTree::TT_Product;
+		size_t k = p->num_children();
+		for (int i : members[c])
+		{
+			const ENode &n = nodes[i];
+			if (n.type != t || n.args.size() < k || n.args.size() > 16) continue;
+			std::vector<std::pair<Bindings, unsigned>> r;
+			match_any(p, n.args, 0, 0, Bindings(), r);
+			for (auto &m : r)
+			{
+				Args rest;
+				for (size_t j = 0; j < n.args.size(); ++j) if (!(m.second & (1u << j))) rest.push_back(n.args[j]);
+				out.push_back(Match{&rule, c, std::move(m.first), std::move(rest)});
+			}
+		}
+	}
+	else
+	{
+		std::vector<Bindings> r;
+		match(p, c, Bindings(), r);
+		for (auto &b : r) out.push_back(Match{&rule, c, std::move(b), Args()});
+	}
+}
+
+int EGraph::instantiate(const Pattern *p, const Bindings &b)
+{
+	switch (p->type)
+	{
+		case Pattern::TT_Constant:
+		{
+			ENode n;
+			n.type = WorkingTree::TT_Constant;
+			n.element = p->constant;
+			return add(std::move(n));
+		}
+		case Pattern::TT_Number: return number(p->number);
+		case Pattern::TT_Wildcard:
+		{
+			auto i = b.find(p);
+			if (i == b.end()) throw std::logic_error("apply with unbound wildcard");
+			return i->second;
+		}
+		case Pattern::TT_Function:
+		case Pattern::TT_Sum:
+		case Pattern::TT_Product:
+		{
+			Args a;
+			for (int i = 0, n = p->num_children(); i < n; ++i) a.push_back(instantiate(p->child(i), b));
+			if (p->type == Pattern::TT_Function) return node(p->function, std::move(a));
+			return node(p->type == Pattern::TT_Sum ? WorkingTree::TT_Sum : WorkingTree::TT_Product, std::move(a));
+		}
+	}
+	assert(false); throw std::logic_error("can't happen");
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// saturation
+//----------------------------------------------------------------------------------------------------------------------
+
+void EGraph::saturate(const std::vector<Rule> &rules)
+{
+	double t0 = now();
+	size_t done = 0; // e-nodes that have their normal forms added
+
+	for (int k = 0; k < MAX_ITERATIONS; ++k)
+	{
+		// sums and products again every time, their arguments may have become sums or zeros since
+		size_t n0 = nodes.size();
+		for (size_t i = 0; i < n0 && nodes.size() < MAX_NODES; ++i)
+		{
+			auto t = nodes[i].type;
+			if (i >= done || t == WorkingTree::TT_Sum || t == WorkingTree::TT_Product) normalize((int)i);
+		}
+		done = n0;
+		rebuild();
+
+		std::vector<Match> matches;
+		for (const Rule &r : rules)
+		{
+			for (int c = 0, n = (int)members.size(); c < n; ++c) if (parent[c] == c) match(r, c, matches);
+		}
+
+		bool change = false;
+		for (Match &m : matches)
+		{
+			if (nodes.size() >= MAX_NODES) break;
+			int r = instantiate(m.rule->replacement, m.b);
+			if (!m.rest.empty())
+			{
+				m.rest.push_back(r);
+				r = node(m.rule->pattern->type == Pattern::TT_Sum ? WorkingTree::TT_Sum : WorkingTree::TT_Product,
+				         std::move(m.rest));
+			}
+			if (merge(m.c, r)) change = true;
+		}
+		rebuild();
+
+		if (!change && nodes.size() == n0) break; // saturated
+		if (nodes.size() >= MAX_NODES || now() - t0 > MAX_TIME) break;
+	}
+
+	update_costs();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// extraction
+//----------------------------------------------------------------------------------------------------------------------
+
+int EGraph::op_cost(WorkingTree::Type t, const Element *e, size_t n, const cnum *exponent) const
+{
+	switch (t)
+	{
+		case WorkingTree::TT_Sum:     return (int)(n-1) * rns.Plus->cost();
+		case WorkingTree::TT_Product: return (int)(n-1) * rns.Mul->cost();
+
+		case WorkingTree::TT_Function:
+		case WorkingTree::TT_Operator:
+		{
+			const Function *f = (const Function*)e;
+			if (!f->base()) return 100; // expanded later, but invisible to the rules
+			if (f == rns.Pow && exponent && is_real(*exponent) && is_int(exponent->real()) &&
+			    fabs(exponent->real()) <= 64.0)
+			{
+				// becomes multiplications in OptimizingTree::reduce
+				int k = (int)fabs(exponent->real()), m = 0;
+				while (k > 1){ m += (k & 1) ? 2 : 1; k >>= 1; }
+				return m * rns.Mul->cost() + (exponent->real() < 0.0 ? rns.Invert->cost() : 0);
+			}
+			return ((const BaseFunction*)f)->cost();
+		}
+
+		default: return 0;
+	}
+}
+
+int EGraph::cost(const WorkingTree &t) const
+{
+	const cnum *exponent = NULL;
+	cnum z;
+	if (t.is_operator(rns.Pow) && t.child(1).type == WorkingTree::TT_Number){ z = (cnum)t.child(1); exponent = &z; }
+	int c = op_cost(t.type, t.element, t.num_children(), exponent);
+	for (auto &x : t) c = std::min(c + cost(x), INF);
+	return c;
+}
+
+void EGraph::update_costs()
+{
+	best_cost.assign(parent.size(), INF);
+	best_node.assign(parent.size(), -1);
+
+	bool change = true;
+	while (change)
+	{
+		change = false;
+		for (int c = 0, n = (int)members.size(); c < n; ++c)
+		{
+			if (parent[c] != c) continue;
+			for (int i : members[c])
+			{
+				const ENode &e = nodes[i];
+				const cnum *exponent = NULL;
+				if (e.element == rns.Pow)
+				{
+					int k = find_node(e.args[1], WorkingTree::TT_Number);
+					if (k >= 0) exponent = &nodes[k].z;
+				}
+				int k = op_cost(e.type, e.element, e.args.size(), exponent);
+				for (int a : e.args) k = std::min(k + best_cost[find(a)], INF);
+				if (k < best_cost[c]){ best_cost[c] = k; best_node[c] = i; change = true; }
+			}
+		}
+	}
+}
+
+WorkingTree EGraph::extract(int c) const
+{
+	c = find(c);
+	assert(best_node[c] >= 0);
+	const ENode &n = nodes[best_node[c]];
+
+	switch (n.type)
+	{
+		case WorkingTree::TT_Root:      assert(false); throw std::logic_error("can't happen");
+		case WorkingTree::TT_Number:    return WorkingTree(n.z, rns);
+		case WorkingTree::TT_Constant:  return WorkingTree((const Constant*)n.element);
+		case WorkingTree::TT_Variable:  return WorkingTree((const Variable*)n.element);
+		case WorkingTree::TT_Parameter: return WorkingTree(n.element, WorkingTree::TT_Parameter);
+
+		case WorkingTree::TT_Function:
+		case WorkingTree::TT_Operator:
+		{
+			WorkingTree t((const Function*)n.element);
+			for (int a : n.args) t.children.push_back(extract(a));
+			assert(t.verify());
+			return t;
+		}
+
+		case WorkingTree::TT_Sum:
+		case WorkingTree::TT_Product:
+		{
+			WorkingTree t(&rns, n.type);
+			for (int a : n.args) t.children.push_back(extract(a));
+			assert(t.verify());
+			return t;
+		}
+	}
+	assert(false); throw std::logic_error("can't happen");
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// WorkingTree::saturate
+//----------------------------------------------------------------------------------------------------------------------
+
+bool WorkingTree::saturate()
+{
+	if (type != TT_Root) return false; // only entire expressions
+	if (!is_deterministic()) return false; // rand()-rand() is not 0
+	const std::vector<Rule> &rules = rns->all_rules();
+	if (rules.empty()) return false;
+
+	EGraph g(*rns);
+	std::vector<int> roots;
+	for (auto &c : children) roots.push_back(g.add(c));
+	g.saturate(rules);
+
+	bool change = false;
+	for (size_t i = 0; i < roots.size(); ++i)
+	{
+		if (g.cost(roots[i]) >= g.cost(children[i])) continue;
+		children[i] = g.extract(roots[i]);
+		change = true;
+	}
+	assert(verify());
+	return change;
+}
@@ -251,30 +251,37 @@ Rule::Rule(RootNamespace &rns, const std::string &s) : rns(rns), pattern(NULL),
 				if (i >= l) syntax_error(s);
 				if (s[i] != ',') break;
 			}
-			Range r;
-			const char *d = s.c_str() + i;
-			if (s[i] == '>')
+			Range r = R_Complex;
+			do // "x real finite" takes both
 			{
-				bool gte = false;
-				if (++i >= l) syntax_error(s);
-				if (s[i] == '='){ gte = true; ++i; }
+				const char *d = s.c_str() + i;
+				if (s[i] == '>')
+				{
+					bool gte = false;
+					if (++i >= l) syntax_error(s);
+					if (s[i] == '='){ gte = true; ++i; }
+					while (i < l && isspace(s[i])) ++i;
+					if (i >= l || s[i] != '0') syntax_error(s);
+					++i;
+					r |= gte ? R_NonNegative : R_Positive;
+				}
+				#define TST(t, T) else if (0 == strncasecmp(t, d, strlen(t))){ i += strlen(t); r |= (T); }
+				TST("real",      R_Real)
+				TST("complex",   R_Complex)
+				TST("imaginary", R_Imag)
+				TST("imag",      R_Imag)
+				TST("disc",      R_Unit)
+				TST("unit",      R_Interval)
+				TST("integer",   R_Integer)
+				TST("int",       R_Integer)
+				TST("natural",   R_Integer|R_NonNegative)
+				TST("finite",    R_Finite)
+				TST("nonzero",   R_NonZero)
+				#undef TST
+				else syntax_error(s);
 				while (i < l && isspace(s[i])) ++i;
-				if (i >= l || s[i] != '0') syntax_error(s);
-				++i;
-				r = gte ? R_NonNegative : R_Positive;
 			}
-			#define TST(t, T) else if (0 == strncasecmp(t, d, strlen(t))){ i += strlen(t); r = (T); }
-			TST("real",      R_Real)
-			TST("complex",   R_Complex)
-			TST("imaginary", R_Imag)
-			TST("imag",      R_Imag)
-			TST("disc",      R_Unit)
-			TST("unit",      R_Interval)
-			TST("integer",   R_Integer)
-			TST("int",       R_Integer)
-			TST("natural",   R_Integer|R_NonNegative)
-			#undef TST
-			else syntax_error(s);
+			while (i < l && s[i] != ',');
 			assert(!names.empty());
 			
 			Variable *v;
@@ -335,7 +342,11 @@ void load(const std::string &path, std::vector<Rule> &rules, RootNamespace &rns)
 {
 	std::ifstream f(path);
 	if (!f.good()) return;
-	
+	load(f, rules, rns);
+}
+
+void load(std::istream &f, std::vector<Rule> &rules, RootNamespace &rns)
+{
 	std::string line;
 	while (std::getline(f, line))
 	{
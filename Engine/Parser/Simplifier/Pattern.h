@@ -4,6 +4,8 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
+#include <istream>
 class Element;
 class Function;
 class Constant;
@@ -13,6 +15,8 @@ class RootNamespace;
 
 class Rule
 {
+	friend class EGraph;
+	
 	struct Pattern : public RetainTree<Pattern>
 	{
 		enum Type
@@ -84,3 +88,4 @@ private:
 };
 
 void load(const std::string &path, std::vector<Rule> &rules, RootNamespace &rns);
+void load(std::istream &in, std::vector<Rule> &rules, RootNamespace &rns);
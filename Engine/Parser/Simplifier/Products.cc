@@ -35,7 +35,7 @@ void WorkingTree::simplify_products(bool &change)
 	// remove +-1, handle 0, prettify constants (0.5 --> 1/2, ...)
 	//------------------------------------------------------------------------------------------------------------------
 
-	std::vector<cnum> vals;
+	WorkingTreeVector<cnum> vals;
 	for (int i = 0; i < n_const; ++i)
 	{
 		auto &c = child(i);
@@ -8,6 +8,25 @@
 //----------------------------------------------------------------------------------------------------------------------
 
 void WorkingTree::simplify(bool full)
+{
+	// the passes allocate their child arrays from the arena, the result is copied out of it at the end
+	WorkingTreeArena::Session arena;
+	if (arena.nested()) return simplify_rounds(full);
+	try
+	{
+		simplify_rounds(full);
+	}
+	catch (...)
+	{
+		arena.end();
+		WorkingTree t(*this); *this = std::move(t);
+		throw;
+	}
+	arena.end();
+	WorkingTree t(*this); *this = std::move(t);
+}
+
+void WorkingTree::simplify_rounds(bool full)
 {
 	#ifdef DEBUG
 	std::ostringstream os;
@@ -17,7 +17,7 @@ void WorkingTree::simplify_sums(bool &change)
 	// sort constants to the front
 	//------------------------------------------------------------------------------------------------------------------
 	int n_const = 0;
-	std::vector<cnum> vals;
+	WorkingTreeVector<cnum> vals;
 	
 	for (int i = 0; i < nc; ++i)
 	{
@@ -114,10 +114,10 @@ bool WorkingTree::sum_compatible(const WorkingTree &A, const WorkingTree &B,
 	assert(&A != &B);
 	a_coeff_i = b_coeff_i = -1;
 	
-	std::vector<const WorkingTree*> a, b;
+	WorkingTreeVector<const WorkingTree*> a, b;
 	if (A.type == TT_Product) for (auto &c : A) a.push_back(&c); else a.push_back(&A);
 	if (B.type == TT_Product) for (auto &c : B) b.push_back(&c); else b.push_back(&B);
-	std::vector<bool> a_done(a.size(), false), b_done(b.size(), false);
+	WorkingTreeVector<bool> a_done(a.size(), false), b_done(b.size(), false);
 	
 	int na = (int)a.size(), nb = (int)b.size();
 	if (abs(na - nb) > 1) return false;
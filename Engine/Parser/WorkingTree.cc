@@ -31,7 +31,7 @@ WorkingTree::WorkingTree(const ParsingTree &pt, const RootNamespace &ns)
 		case Token::TT_Variable:  type = TT_Variable;  variable  = head->data.variable;  break;
 		case Token::TT_Parameter: type = TT_Parameter; parameter = head->data.parameter; break;
 		case Token::TT_Constant:  type = TT_Constant;  constant  = head->data.constant;  break;
-		case Token::TT_Number:    type = TT_Number;    num       = new CNP({&ns, head->num}); break;
+		case Token::TT_Number:    type = TT_Number;    rns       = &ns; number = head->num; break;
 		case Token::TT_Function:  type = TT_Function;  function  = head->data.function;  break;
 		case Token::TT_Operator:  type = TT_Operator;  operator_ = head->data.operator_; break;
 		case Token::TT_Alias:
@@ -39,7 +39,7 @@ WorkingTree::WorkingTree(const ParsingTree &pt, const RootNamespace &ns)
 			const WorkingTree &t = head->data.alias->replacement();
 			type = t.type;
 			element = t.element;
-			if (type == TT_Number) num = new CNP(*num);
+			number  = t.number;
 			children.assign(t.children.begin(), t.children.end());
 			break;
 		}
@@ -70,7 +70,7 @@ bool WorkingTree::verify() const
 		case TT_Sum:
 		case TT_Product:   return rns;
 			
-		case TT_Number:    return num && num->rns && nc == 0;
+		case TT_Number:    return rns && nc == 0;
 		case TT_Constant:  return constant  && constant->isConstant()   && nc == 0;
 		case TT_Variable:  return variable  && variable->isVariable()   && nc == 0;
 		case TT_Parameter: return parameter && parameter->isParameter() && nc == 0;
@@ -82,9 +82,9 @@ bool WorkingTree::verify() const
 
 bool WorkingTree::operator== (const WorkingTree &t) const
 {
-	// TODO: this should be much more clever
-	if (!type != !t.type || children.size() != t.children.size()) return false;
-	if (type == TT_Number) return eq(num->z, t.num->z);
+	if (this == &t) return true;
+	if (type != t.type || children.size() != t.children.size()) return false;
+	if (type == TT_Number) return eq(number, t.number);
 	if (element != t.element) return false;
 	for (size_t i = 0, n = num_children(); i < n; ++i) if (children[i] != t.children[i]) return false;
 	return true;
@@ -100,9 +100,8 @@ const RootNamespace &WorkingTree::ns() const
 	{
 		case TT_Root:
 		case TT_Sum:
-		case TT_Product: return *rns;
-			
-		case TT_Number:  return *num->rns;
+		case TT_Product:
+		case TT_Number:  return *rns;
 			
 		case TT_Variable:
 		case TT_Parameter:
@@ -128,7 +127,8 @@ bool WorkingTree::is_constant(bool strong) const
 			
 		case TT_Function:
 		case TT_Operator:
-			if (strong && !is_deterministic()) return false;
+			// the children check their own determinism
+			if (strong && !function->deterministic()) return false;
 			// fallthrough
 		case TT_Root:
 		case TT_Sum:
@@ -151,7 +151,7 @@ int WorkingTree::uglyness() const
 		case TT_Parameter:
 		case TT_Constant:  return 0;
 			
-		case TT_Number: return ::uglyness(num->z);
+		case TT_Number: return ::uglyness(number);
 			
 		case TT_Root:
 		case TT_Function:
@@ -229,7 +229,7 @@ cnum WorkingTree::evaluate(const std::map<const Variable*, cnum> &values) const
 		case TT_Root:      assert(false); return UNDEFINED;
 		case TT_Constant:  return constant->value();
 		case TT_Parameter: return parameter->value();
-		case TT_Number:    return num->z;
+		case TT_Number:    return number;
 		case TT_Variable:
 		{
 			auto it = values.find(variable);
@@ -336,7 +336,7 @@ bool WorkingTree::is_real() const
 		case TT_Root: assert(false); return false;
 		case TT_Constant:  return constant->real();
 		case TT_Parameter: return parameter->is_real();
-		case TT_Number:    return ::is_real(num->z);
+		case TT_Number:    return ::is_real(number);
 		case TT_Variable:  return variable->real();
 			
 		case TT_Function:
@@ -358,7 +358,7 @@ bool WorkingTree::is_real(const std::set<Variable*> &real_vars) const
 		case TT_Root:      return false;
 		case TT_Constant:  return constant->real();
 		case TT_Parameter: return parameter->is_real();
-		case TT_Number:    return ::is_real(num->z);
+		case TT_Number:    return ::is_real(number);
 		case TT_Variable:  return variable->real() || real_vars.count((Variable*)variable);
 			
 		case TT_Function:
@@ -382,7 +382,7 @@ Range WorkingTree::range() const
 		case TT_Root: assert(false); return false;
 		case TT_Constant:  return constant->range();
 		case TT_Parameter: return parameter->range();
-		case TT_Number:    return ::range(num->z);
+		case TT_Number:    return ::range(number);
 		case TT_Variable:  return variable->range();
 			
 		case TT_Function:
@@ -427,7 +427,7 @@ Range WorkingTree::range(const std::map<Variable*, Range> &input) const
 		case TT_Root: assert(false); return false;
 		case TT_Constant:  return constant->range();
 		case TT_Parameter: return parameter->range();
-		case TT_Number:    return ::range(num->z);
+		case TT_Number:    return ::range(number);
 		case TT_Variable:
 		{
 			auto i = input.find((Variable*)variable);
@@ -1,5 +1,6 @@
 #pragma once
 #include "RetainTree.h"
+#include "WorkingTreeArena.h"
 #include "../Namespace/Operator.h"
 //#include "Function.h"
 //#include "Element.h"
@@ -29,6 +30,7 @@ public:
 	friend class OptimizingTree;
 	friend class Pattern;
 	friend class Rule;
+	friend class EGraph;
 	
 	//------------------------------------------------------------------------------------------------------------------
 	// data and info
@@ -49,8 +51,6 @@ public:
 	
 	Type type;
 	
-	struct CNP{ const RootNamespace *rns; cnum z; };
-	
 	union
 	{
 		const Element       *element;
@@ -59,13 +59,11 @@ public:
 		const Operator      *operator_;
 		const Constant      *constant;
 		const Parameter     *parameter;
-		const RootNamespace *rns; // for root
-		CNP                 *num;
+		const RootNamespace *rns; // for root, sums, products and numbers
 	};
+	cnum number; // kept in the node, so numbers are not allocated separately
 	
-private: std::vector<WorkingTree> children; public:
-	
-	~WorkingTree(){ if (type == TT_Number) delete num; }
+private: WorkingTrees children; public: // from the WorkingTreeArena during simplify
 	
 	inline int  num_children() const{ return (int)children.size(); }
 	
@@ -73,8 +71,8 @@ private: std::vector<WorkingTree> children; public:
 	inline const WorkingTree &child(int i) const { assert(i >= 0 && (size_t)i < children.size()); return children[i]; }
 	const Function *head() const; // top-level function or NULL
 	
-	typedef typename std::vector<WorkingTree>::const_iterator const_iterator;
-	typedef typename std::vector<WorkingTree>::iterator       iterator;
+	typedef typename WorkingTrees::const_iterator const_iterator;
+	typedef typename WorkingTrees::iterator       iterator;
 	inline const_iterator begin() const{ return children.begin(); }
 	inline iterator       begin()      { return children.begin(); }
 	inline const_iterator   end() const{ return children.end();   }
@@ -82,11 +80,11 @@ private: std::vector<WorkingTree> children; public:
 	
 	const RootNamespace &ns() const;
 	
-	explicit operator cnum() const{ assert(type == TT_Number); return num->z; }
+	explicit operator cnum() const{ assert(type == TT_Number); return number; }
 	
 	bool operator== (const WorkingTree &t) const;
 	bool operator!= (const WorkingTree &t) const{ return !(*this == t); }
-	bool operator== (const cnum &z){ return type == TT_Number && eq(num->z, z); }
+	bool operator== (const cnum &z){ return type == TT_Number && eq(number, z); }
 	
 	//------------------------------------------------------------------------------------------------------------------
 	// constructors, assignment
@@ -94,20 +92,18 @@ private: std::vector<WorkingTree> children; public:
 	
 	WorkingTree(const ParsingTree &pt, const RootNamespace &ns);
 	
-	WorkingTree(const WorkingTree &t) : type(t.type), element(t.element), children(t.children)
+	WorkingTree(const WorkingTree &t) : type(t.type), element(t.element), number(t.number), children(t.children)
 	{
-		if (type == TT_Number) num = new CNP(*num);
 		assert(verify());
 	}
-	WorkingTree(WorkingTree &&t) : type(t.type), element(t.element), children(std::move(t.children))
+	WorkingTree(WorkingTree &&t) noexcept : type(t.type), element(t.element), number(t.number), children(std::move(t.children))
 	{
-		t.num = NULL;
 		#ifndef NDEBUG
 		t.type = (Type)-15; // so verify will not fail assertions if some container copies the remains
 		#endif
 	}
 	
-	WorkingTree(const cnum &z, const RootNamespace &rns) : num(new CNP({&rns, z})), type(TT_Number){ assert(verify()); }
+	WorkingTree(const cnum &z, const RootNamespace &rns) : rns(&rns), number(z), type(TT_Number){ assert(verify()); }
 	
 	explicit WorkingTree(const Variable *v) : variable(v), type(TT_Variable){ assert(verify()); }
 	explicit WorkingTree(const Constant *c) : constant(c), type(TT_Constant){ assert(verify()); }
@@ -121,21 +117,21 @@ private: std::vector<WorkingTree> children; public:
 	
 	WorkingTree(const UnaryOperator *o, WorkingTree &&x) : operator_(o), type(TT_Operator)
 	{
-		children.push_back(x);
+		children.push_back(std::move(x));
 		assert(verify());
 	}
 	WorkingTree(const BinaryOperator *o, WorkingTree &&x1, WorkingTree &&x2) : operator_(o), type(TT_Operator)
 	{
 		children.reserve(2);
-		children.push_back(x1);
-		children.push_back(x2);
+		children.push_back(std::move(x1));
+		children.push_back(std::move(x2));
 		assert(verify());
 	}
 	WorkingTree(const Function *f, WorkingTree &&x1)
 	: function(f), type(TT_Function)
 	{
 		assert(f->arity() == 1);
-		children.push_back(x1);
+		children.push_back(std::move(x1));
 		assert(verify());
 	}
 	WorkingTree(const Function *f, WorkingTree &&x1, WorkingTree &&x2)
@@ -143,8 +139,8 @@ private: std::vector<WorkingTree> children; public:
 	{
 		assert(f->arity() == 2);
 		children.reserve(2);
-		children.push_back(x1);
-		children.push_back(x2);
+		children.push_back(std::move(x1));
+		children.push_back(std::move(x2));
 		assert(verify());
 	}
 	WorkingTree(const Function *f, WorkingTree &&x1, WorkingTree &&x2, WorkingTree &&x3)
@@ -152,9 +148,9 @@ private: std::vector<WorkingTree> children; public:
 	{
 		assert(f->arity() == 3);
 		children.reserve(3);
-		children.push_back(x1);
-		children.push_back(x2);
-		children.push_back(x3);
+		children.push_back(std::move(x1));
+		children.push_back(std::move(x2));
+		children.push_back(std::move(x3));
 		assert(verify());
 	}
 	
@@ -173,16 +169,15 @@ private:
 	WorkingTree &operator=(const WorkingTree &t)
 	{
 		if (this == &t) return *this;
-		type = t.type; element = t.element;
-		if (type == TT_Number) num = new CNP(*num);
+		type = t.type; element = t.element; number = t.number;
 		children = t.children;
 		assert(verify());
 		return *this;
 	}
 	
-	WorkingTree &operator=(WorkingTree &&t)
+	WorkingTree &operator=(WorkingTree &&t) noexcept
 	{
-		type = t.type; element = t.element; t.num = NULL;
+		type = t.type; element = t.element; number = t.number;
 		children = std::move(t.children);
 		assert(verify());
 		return *this;
@@ -190,17 +185,13 @@ private:
 	
 	WorkingTree &operator=(const cnum &z)
 	{
-		if (type == TT_Number)
-		{
-			num->z = z;
-		}
-		else
+		if (type != TT_Number)
 		{
-			auto *rns = &ns();
-			num = new CNP({rns, z});
+			rns  = &ns();
 			type = TT_Number;
 			children.clear();
 		}
+		number = z;
 		assert(verify());
 		return *this;
 	}
@@ -219,17 +210,24 @@ private:
 	void collect_variables(std::set<Variable*> &dst) const;
 	
 	WorkingTree *derivative(const Variable &x, std::string &error) const;
+private:
+	WorkingTree *derivative_rec(const Variable &x, std::string &error) const; // derivative without the arena
+public:
 	WorkingTree *split_var(const Variable &z, const Variable &x, const Variable &y) const; // f(z) --> f(x+iy)
 	
 	void simplify(bool full);
 	
-	inline bool is_zero     () const{ return type == TT_Number && ::isz        (num->z); }
-	inline bool is_one      () const{ return type == TT_Number && ::is_one     (num->z); }
-	inline bool is_minus_one() const{ return type == TT_Number && ::is_minusone(num->z); }
+	/// Equality saturation with the rules from Rules.txt: replaces the expressions in this root with the cheapest
+	/// equivalents that were found for evaluation. Returns false if there was nothing cheaper. @see EGraph.cc
+	bool saturate();
+	
+	inline bool is_zero     () const{ return type == TT_Number && ::isz        (number); }
+	inline bool is_one      () const{ return type == TT_Number && ::is_one     (number); }
+	inline bool is_minus_one() const{ return type == TT_Number && ::is_minusone(number); }
 	inline bool is_real(double &value) const
 	{
-		if (type != TT_Number || !::is_real(num->z)) return false;
-		value = num->z.real();
+		if (type != TT_Number || !::is_real(number)) return false;
+		value = number.real();
 		return true;
 	}
 	
@@ -279,16 +277,16 @@ private:
 	static WorkingTree add(WorkingTree &&a, WorkingTree &&b);
 	static WorkingTree mul(WorkingTree &&a, WorkingTree &&b);
 	
-	void add_child(WorkingTree &&c){ children.push_back(c); }
+	void add_child(WorkingTree &&c){ children.push_back(std::move(c)); }
 	
 	void pull(int i) // replace this by child(i)
 	{
 		WorkingTree &t = children[i];
 		type = t.type;
 		element = t.element;
-		t.num = NULL;
+		number = t.number;
 		
-		std::vector<WorkingTree> tmp(std::move(t.children));
+		WorkingTrees tmp(std::move(t.children));
 		children = std::move(tmp);
 		assert(verify());
 	}
@@ -332,10 +330,11 @@ private:
 	void pack(const Element *e, bool transit = false)
 	{
 		assert(transit || e->arity() == 1);
-		std::vector<WorkingTree> tmp;
+		WorkingTrees tmp;
 		std::swap(tmp, children);
-		children.emplace_back(nullptr, type, private_key()); // don't copy number
+		children.emplace_back(nullptr, type, private_key());
 		children[0].element = element;
+		children[0].number  = number;
 		element = e;
 		type    = e->isOperator() ? TT_Operator : TT_Function;
 		std::swap(tmp, children[0].children);
@@ -344,10 +343,11 @@ private:
 	void pack(Type t, const RootNamespace &ns)
 	{
 		assert(t == TT_Sum || t == TT_Product);
-		std::vector<WorkingTree> tmp;
+		WorkingTrees tmp;
 		std::swap(tmp, children);
-		children.emplace_back(nullptr, type, private_key()); // don't copy number
+		children.emplace_back(nullptr, type, private_key());
 		children[0].element = element;
+		children[0].number  = number;
 		rns = &ns;
 		type = t;
 		std::swap(tmp, children[0].children);
@@ -409,7 +409,7 @@ private:
 	void flip_involution(const Function *f)
 	{
 		assert(f->involution());
-		if (type == TT_Number && f == ns().UMinus){ num->z = -num->z; return; }
+		if (type == TT_Number && f == ns().UMinus){ number = -number; return; }
 		if ((type == TT_Function || type == TT_Operator) && function == f) pull(0); else pack(f);
 		assert(verify());
 	}
@@ -417,7 +417,7 @@ private:
 	// add a number (from the right)
 	void operator+= (const cnum &z)
 	{
-		if (type == TT_Number){ num->z += z; return; }
+		if (type == TT_Number){ number += z; return; }
 		if (type != TT_Sum) pack(TT_Sum, ns());
 		children.emplace_back(z, ns());
 		assert(verify());
@@ -425,7 +425,7 @@ private:
 	// add an expression (from the right)
 	void operator+= (WorkingTree &&z)
 	{
-		if (type == TT_Number && z.type == TT_Number){ num->z += z.num->z; return; }
+		if (type == TT_Number && z.type == TT_Number){ number += z.number; return; }
 		if (type != TT_Sum) pack(TT_Sum, ns());
 		children.push_back(std::move(z));
 		assert(verify());
@@ -434,7 +434,7 @@ private:
 	// subtract a number (from the right)
 	void operator-= (const cnum &z)
 	{
-		if (type == TT_Number){ num->z -= z; return; }
+		if (type == TT_Number){ number -= z; return; }
 		if (type != TT_Sum) pack(TT_Sum, ns());
 		children.emplace_back(-z, ns());
 		assert(verify());
@@ -442,7 +442,7 @@ private:
 	// subtract an expression (from the right)
 	void operator-= (WorkingTree &&z)
 	{
-		if (type == TT_Number && z.type == TT_Number){ num->z -= z.num->z; return; }
+		if (type == TT_Number && z.type == TT_Number){ number -= z.number; return; }
 		if (type != TT_Sum) pack(TT_Sum, ns());
 		z.flip_involution(ns().UMinus);
 		children.push_back(std::move(z));
@@ -452,7 +452,7 @@ private:
 	// multiply by a number (from the left)
 	void operator*= (const cnum &z)
 	{
-		if (type == TT_Number){ num->z *= z; return; }
+		if (type == TT_Number){ number *= z; return; }
 		if (type != TT_Product) pack(TT_Product, ns());
 		children.emplace(children.begin(), z, ns());
 		assert(verify());
@@ -460,7 +460,7 @@ private:
 	// multiply by an expression (from the left)
 	void operator*= (WorkingTree &&z)
 	{
-		if (type == TT_Number && z.type == TT_Number){ num->z *= z.num->z; return; }
+		if (type == TT_Number && z.type == TT_Number){ number *= z.number; return; }
 		if (type != TT_Product) pack(TT_Product, ns());
 		children.push_back(std::move(z));
 		assert(verify());
@@ -484,6 +484,8 @@ private:
 	// simplify
 	//------------------------------------------------------------------------------------------------------------------
 	
+	void simplify_rounds(bool full); // simplify without the arena
+	
 	void normalize();
 	void flatten(bool &change);
 	void denormalize();
@@ -0,0 +1,77 @@
+#include "WorkingTreeArena.h"
+#include <cassert>
+#include <cstring>
+
+thread_local WorkingTreeArena *WorkingTreeArena::current_ = NULL;
+
+WorkingTreeArena::WorkingTreeArena() : RawMemoryPool(CHUNK_SIZE, 16), allocating(false)
+{
+	assert(!current_);
+	memset(free_list, 0, sizeof(free_list));
+	current_ = this;
+}
+
+WorkingTreeArena::~WorkingTreeArena()
+{
+	assert(current_ == this && !allocating);
+	current_ = NULL;
+}
+
+WorkingTreeArena &WorkingTreeArena::thread_arena()
+{
+	static thread_local WorkingTreeArena arena;
+	return arena;
+}
+
+WorkingTreeArena::Session::Session() : arena(thread_arena()), outer(arena.allocating), ended(false)
+{
+	arena.allocating = true;
+}
+
+void WorkingTreeArena::Session::end()
+{
+	if (ended) return;
+	ended = true;
+	if (!outer) arena.allocating = false;
+}
+
+// smallest class that holds bytes or -1
+static inline int size_class(size_t bytes, int min_class, int n_classes)
+{
+	int k = 0;
+	while (k < n_classes && ((size_t)1 << (min_class + k)) < bytes) ++k;
+	return k < n_classes ? k : -1;
+}
+
+void *WorkingTreeArena::allocate(size_t bytes)
+{
+	if (!allocating) return NULL;
+	int k = size_class(bytes, MIN_CLASS, N_CLASSES);
+	if (k < 0) return NULL;
+
+	if (void *p = free_list[k])
+	{
+		free_list[k] = *(void**)p;
+		return p;
+	}
+
+	const Chunk *c = cn;
+	char *p = alloc((size_t)1 << (MIN_CLASS + k));
+	if (cn != c) chunks[p] = p + CHUNK_SIZE; // p is the start of a new chunk
+	return p;
+}
+
+bool WorkingTreeArena::release(void *p, size_t bytes)
+{
+	if (!p || chunks.empty()) return false;
+	auto i = chunks.upper_bound((const char*)p);
+	if (i == chunks.begin()) return false;
+	--i;
+	if ((const char*)p >= i->second) return false;
+
+	int k = size_class(bytes, MIN_CLASS, N_CLASSES);
+	assert(k >= 0);
+	*(void**)p = free_list[k];
+	free_list[k] = p;
+	return true;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "../../Utility/MemoryPool.h"
+#include <cstddef>
+#include <map>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+class WorkingTree;
+
+/**
+ * Memory for the child arrays of WorkingTrees while WorkingTree::simplify or WorkingTree::derivative runs.
+ *
+ * The simplifier passes build, move and drop child vectors all the time (pack, pull, add, mul, rule replacements,
+ * ...). Inside a Session, small arrays come from this thread's arena, which takes them from a RawMemoryPool and puts
+ * released ones onto a free list for their size class. The arena is kept for the lifetime of the thread, so once it
+ * has grown to the size of the largest simplification, a simplify allocates nothing from the heap except for the
+ * final copy of its result. Arrays that were allocated outside of a Session (or are too large) go through operator
+ * new/delete as usual.
+ *
+ * Nothing allocated in a Session may outlive it, because trees can be deleted on other threads: simplify and
+ * derivative copy their result out after Session::end, and trees that are kept elsewhere must be built under a
+ * Pause (@see Simplify.cc, WorkingTreeDerivative.cc, Expression::parse, Function::parse_gradient).
+ */
+
+class WorkingTreeArena : private RawMemoryPool
+{
+public:
+	/// Allocates from the current thread's arena until end() or the destructor
+	class Session
+	{
+	public:
+		Session();
+		~Session(){ end(); }
+		void end();
+		bool nested() const{ return outer; } ///< there was a Session already, which will do the copying
+		
+	private:
+		WorkingTreeArena &arena;
+		bool outer, ended;
+	};
+
+	/// Allocates from the heap again until the destructor, for trees that are kept after the Session
+	class Pause
+	{
+	public:
+		Pause() : arena(current_), was(arena && arena->allocating){ if (was) arena->allocating = false; }
+		~Pause(){ if (was) arena->allocating = true; }
+		
+	private:
+		WorkingTreeArena *arena;
+		bool was;
+	};
+
+	/// This thread's arena if it has one
+	static WorkingTreeArena *current(){ return current_; }
+
+	void *allocate(size_t bytes);           ///< NULL if bytes is too large or there is no Session
+	bool  release (void *p, size_t bytes);  ///< false if p was not allocated here
+
+private:
+	WorkingTreeArena();
+	~WorkingTreeArena();
+	WorkingTreeArena(const WorkingTreeArena &) = delete;
+	WorkingTreeArena &operator= (const WorkingTreeArena &) = delete;
+
+	static thread_local WorkingTreeArena *current_;
+	static WorkingTreeArena &thread_arena(); // creates it on first use
+
+	enum{ MIN_CLASS = 6, N_CLASSES = 8, CHUNK_SIZE = 1 << 16 }; // 64 bytes to 8 kB from chunks of 64 kB
+
+	std::map<const char*, const char*> chunks; // start -> end of the pool's chunks, for release
+	void  *free_list[N_CLASSES];               // released arrays, the first word of each points to the next one
+	bool   allocating;                         // in a Session?
+};
+
+/// Allocator for WorkingTree::children (and anything else that is rebound from it)
+template<typename T> struct WorkingTreeAllocator
+{
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type is_always_equal;
+
+	WorkingTreeAllocator(){ }
+	template<typename U> WorkingTreeAllocator(const WorkingTreeAllocator<U> &){ }
+
+	T *allocate(size_t n)
+	{
+		WorkingTreeArena *a = WorkingTreeArena::current();
+		void *p = a ? a->allocate(n * sizeof(T)) : NULL;
+		return (T*)(p ? p : ::operator new(n * sizeof(T)));
+	}
+	void deallocate(T *p, size_t n)
+	{
+		WorkingTreeArena *a = WorkingTreeArena::current();
+		if (!a || !a->release(p, n * sizeof(T))) ::operator delete(p);
+	}
+
+	template<typename U> bool operator== (const WorkingTreeAllocator<U> &) const{ return true; }
+	template<typename U> bool operator!= (const WorkingTreeAllocator<U> &) const{ return false; }
+};
+
+typedef std::vector<WorkingTree, WorkingTreeAllocator<WorkingTree>> WorkingTrees;
+
+/// Scratch space for the simplifier passes
+template<typename T> using WorkingTreeVector = std::vector<T, WorkingTreeAllocator<T>>;
@@ -1,5 +1,6 @@
 #include "WorkingTree.h"
 #include "../Namespace/Function.h"
+#include "../Namespace/UserFunction.h"
 #include "../Namespace/Variable.h"
 #include "../Namespace/RootNamespace.h"
 #include <cassert>
@@ -43,6 +44,17 @@ WorkingTree WorkingTree::mul(WorkingTree &&a, WorkingTree &&b)
 //----------------------------------------------------------------------------------------------------------------------
 
 WorkingTree *WorkingTree::derivative(const Variable &x, std::string &error) const
+{
+	// the whole recursion works in the arena (@see simplify), only the result is copied out of it
+	WorkingTreeArena::Session arena;
+	if (arena.nested()) return derivative_rec(x, error);
+	WorkingTree *ret = derivative_rec(x, error);
+	arena.end();
+	if (ret){ WorkingTree t(*ret); *ret = std::move(t); }
+	return ret;
+}
+
+WorkingTree *WorkingTree::derivative_rec(const Variable &x, std::string &error) const
 {
 	bool cpx = !x.real();
 	switch (type)
@@ -52,7 +64,7 @@ WorkingTree *WorkingTree::derivative(const Variable &x, std::string &error) cons
 			WorkingTree *ret = new WorkingTree(ns());
 			for (auto &c : children)
 			{
-				WorkingTree *dc = c.derivative(x, error);
+				WorkingTree *dc = c.derivative_rec(x, error);
 				if (!dc){ delete ret; return NULL; }
 				ret->add_child(std::move(*dc)); delete dc;
 			}
@@ -80,6 +92,14 @@ WorkingTree *WorkingTree::derivative(const Variable &x, std::string &error) cons
 				return new WorkingTree(0.0, ns());
 			}
 			
+			if (!function->base()) // apply fails for invalid (e.g. recursive) definitions
+			{
+				// differentiate the body with the arguments plugged in
+				std::unique_ptr<WorkingTree> r(((const UserFunction*)function)->apply(children));
+				if (r && r->type != TT_Root) return r->derivative_rec(x, error);
+				if (r && r->num_children() == 1) return r->child(0).derivative_rec(x, error);
+			}
+			
 			std::unique_ptr<WorkingTree> grad(cpx ? function->complex_gradient(children)
 											  : function->real_gradient(children));
 			if (!grad)
@@ -97,7 +117,7 @@ WorkingTree *WorkingTree::derivative(const Variable &x, std::string &error) cons
 			{
 				for (int i = 0, n = num_children(); i < n; ++i)
 				{
-					WorkingTree *dc = child(i).derivative(x, error);
+					WorkingTree *dc = child(i).derivative_rec(x, error);
 					if (!dc){ delete ret; return NULL; }
 					ret->add_child(mul(std::move(*dc), std::move(grad->child(i)))); delete dc;
 				}
@@ -108,7 +128,7 @@ WorkingTree *WorkingTree::derivative(const Variable &x, std::string &error) cons
 				
 				for (int i = 0, n = num_children(); i < n; ++i)
 				{
-					WorkingTree *dc = child(i).derivative(x, error);
+					WorkingTree *dc = child(i).derivative_rec(x, error);
 					if (!dc){ delete ret; return NULL; }
 					if (dc->is_real())
 					{
@@ -147,7 +167,7 @@ WorkingTree *WorkingTree::derivative(const Variable &x, std::string &error) cons
 			WorkingTree *ret = new WorkingTree(element, type);
 			for (auto &c : children)
 			{
-				WorkingTree *dc = c.derivative(x, error);
+				WorkingTree *dc = c.derivative_rec(x, error);
 				if (!dc){ delete ret; return NULL; }
 				ret->add_child(std::move(*dc)); delete dc;
 			}
@@ -167,7 +187,7 @@ WorkingTree *WorkingTree::derivative(const Variable &x, std::string &error) cons
 				{
 					if (j == i)
 					{
-						WorkingTree *dc = child(j).derivative(x, error);
+						WorkingTree *dc = child(j).derivative_rec(x, error);
 						if (!dc){ delete ret; return NULL; }
 						t.add_child(std::move(*dc)); delete dc;
 					}
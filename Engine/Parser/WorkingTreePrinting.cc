@@ -353,7 +353,7 @@ void WorkingTree::print(std::ostream &o, PrintingStyle ds, const Operator *outsi
 		{
 			const char *s0, *s1;
 			grouping_format(ds, s0, s1);
-			const cnum &z = num->z;
+			const cnum &z = number;
 			
 			if (prints_sum(z))
 			{
@@ -17,7 +17,9 @@ enum
 	R_NonNegative = 16 + R_Real,        // x >= 0
 	R_Positive    = 32 + R_NonNegative, // x > 0
 	R_Zero        = R_Integer | R_NonNegative | R_Imag | R_Unit,
-	R_One         = R_Integer | R_Positive | R_Unit
+	R_One         = R_Integer | R_Positive | R_Unit,
+	R_Finite      = 64,                 // not inf or nan, only known for numbers (@see EGraph::range)
+	R_NonZero     = 128 + R_Finite      // finite and != 0
 };
 typedef int Range;
 
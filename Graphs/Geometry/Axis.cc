@@ -23,6 +23,7 @@ void AxisOptions::load(Deserializer &s)
 Axis::Axis() : m_type(Rect)
 {
 	m_center[0] = m_center[1] = m_center[2] = 0.0;
+	m_center_lo[0] = m_center_lo[1] = 0.0;
 	m_range [0] = m_range [1] = m_range [2] = 5.0;
 	m_in_center[0] = m_in_center[1] = 0.0;
 	m_in_range [0] = m_in_range [1] = 1.0;
@@ -47,6 +48,9 @@ void Axis::save(Serializer &s) const
 	s.double_(m_in_range[1]);
 	s.enum_(m_type, Invalid, Sphere);
 	options.save(s);
+	if (s.version() < FILE_VERSION_1_11) return;
+	s.double_(m_center_lo[0]);
+	s.double_(m_center_lo[1]);
 }
 void Axis::load(Deserializer &s)
 {
@@ -66,12 +70,22 @@ void Axis::load(Deserializer &s)
 	s.double_(m_in_range[1]);
 	s.enum_(m_type, Invalid, Sphere);
 	options.load(s);
+	if (s.version() < FILE_VERSION_1_11)
+	{
+		m_center_lo[0] = m_center_lo[1] = 0.0;
+	}
+	else
+	{
+		s.double_(m_center_lo[0]);
+		s.double_(m_center_lo[1]);
+	}
 	update();
 }
 
-void Axis::zoom(double d)
+void Axis::zoom(double d, bool deep)
 {
-	const double zmin = 1.0e-12, zmax = 1.0e12;
+	// 2D axes can go much deeper for the fractals (@see DeepZoom), everything else is noise below 1e-12
+	const double zmin = deep && m_type == Rect ? 1.0e-26 : 1.0e-12, zmax = 1.0e12;
 	m_range[0] *= d;
 	m_range[1] *= d;
 	m_range[2] *= d;
@@ -93,8 +107,15 @@ void Axis::zoom(double d)
 }
 void Axis::move(double dx, double dy, double dz)
 {
-	m_center[0] += dx;
-	m_center[1] += dy;
+	// add dx and dy in double-double precision, so moving around stays smooth in deep zooms
+	const double d[2] = {dx, dy};
+	for (int i = 0; i < 2; ++i)
+	{
+		double c = m_center[i], s = c + d[i], v = s - c;
+		double e = (c - (s - v)) + (d[i] - v) + m_center_lo[i];
+		m_center[i] = s + e;
+		m_center_lo[i] = e - (m_center[i] - s);
+	}
 	m_center[2] += dz;
 	update();
 }
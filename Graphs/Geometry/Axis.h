@@ -66,7 +66,8 @@ public:
 	inline double  range(int i) const{ assert(i>=0 && i < 3); return m_effective_range[i]; }
 	inline double    min(int i) const{ assert(i>=0 && i < 3); return m_effective_center[i] - m_effective_range[i]; }
 	inline double    max(int i) const{ assert(i>=0 && i < 3); return m_effective_center[i] + m_effective_range[i]; }
-	inline void center(int i, double x){ assert(i>=0 && i < 3); m_center[i] = x; update(); }
+	inline double center_lo(int i) const{ assert(i>=0 && i < 3); return m_type == Rect && i < 2 ? m_center_lo[i] : 0.0; }
+	inline void center(int i, double x){ assert(i>=0 && i < 3); m_center[i] = x; if (i < 2) m_center_lo[i] = 0.0; update(); }
 	inline void  range(int i, double x){ assert(i>=0 && i < 3); m_range [i] = x; update(); }
 
 	inline double in_center(int i) const{ assert(i>=0 && i < 2); return m_in_center[i]; }
@@ -78,9 +79,9 @@ public:
 	
 	AxisOptions options;
 	
-	void zoom(double factor); // multiplies range with factor
+	void zoom(double factor, bool deep = false); // multiplies range with factor, deep allows the tiny ranges of DeepZoom
 	void move(double dx, double dy, double dz); // adds these to center
-	void reset_center(){ for (int i = 0; i < 3; ++i) m_center[i] = 0.0; update(); }
+	void reset_center(){ for (int i = 0; i < 3; ++i) m_center[i] = 0.0; m_center_lo[0] = m_center_lo[1] = 0.0; update(); }
 	void equal_ranges()
 	{
 		if (m_type != Box) return;
@@ -122,6 +123,7 @@ public:
 	{
 		memcpy(m_center, (const double*)center, 3*sizeof(double));
 		memcpy(m_range, (const double*)range, 3*sizeof(double));
+		m_center_lo[0] = m_center_lo[1] = 0.0;
 		update();
 	}
 	void get_inrange(P2d &center, P2d &range) const
@@ -139,6 +141,7 @@ public:
 private:
 	Type m_type;
 	double m_center[3], m_range[3];       // image: [c-r, c+r] = [min_i, max_i]
+	double m_center_lo[2];                // what move lost to rounding in m_center, for deep zooms
 	double m_effective_center[3], m_effective_range[3];
 	double m_in_center[2], m_in_range[2]; // preimage
 	int m_win_w, m_win_h;
@@ -1,5 +1,6 @@
 #include "Camera.h"
 #include "Axis.h"
+#include "Jitter.h"
 #include <GL/gl.h>
 #include <GL/glu.h>
 
@@ -7,9 +8,6 @@
 // antialiasing
 //----------------------------------------------------------------------------------------------------------------------
 
-static double jit4[4][2] = {{0.375, 0.25}, {0.125, 0.75}, {0.875, 0.25}, {0.625, 0.75}};
-static double jit8[8][2] = {{0.5625, 0.4375}, {0.0625, 0.9375}, {0.3125, 0.6875}, {0.6875, 0.8125}, {0.8125, 0.1875}, {0.9375, 0.5625}, {0.4375, 0.0625}, {0.1875, 0.3125}};
-
 /* accFrustum()
  * The first 6 arguments are identical to the glFrustum() call.
  *
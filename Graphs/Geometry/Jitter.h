@@ -0,0 +1,6 @@
+#pragma once
+
+// Subpixel sample positions (in pixels) for 4x and 8x antialiasing: the FSAA passes of Camera::set and the
+// supersampling of color graphs
+static const double jit4[4][2] = {{0.375, 0.25}, {0.125, 0.75}, {0.875, 0.25}, {0.625, 0.75}};
+static const double jit8[8][2] = {{0.5625, 0.4375}, {0.0625, 0.9375}, {0.3125, 0.6875}, {0.6875, 0.8125}, {0.8125, 0.1875}, {0.9375, 0.5625}, {0.4375, 0.0625}, {0.1875, 0.3125}};
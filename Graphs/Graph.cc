@@ -5,6 +5,7 @@
 #include "../Engine/Namespace/Variable.h"
 #include "../Engine/Namespace/AliasVariable.h"
 #include "../Engine/Parser/Evaluator.h"
+#include "../Engine/Parser/EvalProfile.h"
 #include "../Engine/Namespace/Parameter.h"
 #include "Graphics/GL_Graph.h"
 #include "Graphics/GL_AreaGraph.h"
@@ -18,6 +19,7 @@
 #include "Graphics/GL_HistogramPointGraph.h"
 #include "Graphics/GL_RiemannHistogram.h"
 #include "Graphics/GL_RiemannHistogramPointGraph.h"
+#include "../Utility/Preferences.h"
 
 void GraphOptions::save(Serializer &s) const
 {
@@ -120,7 +122,7 @@ void GraphOptions::load(Deserializer &s)
 
 Graph::Graph(Plot &p)
 : plot(p)
-, gl(NULL), ex(NULL)
+, gl(NULL), ex(NULL), m_profile(NULL)
 , m_type(R_R), m_coords(GC_Cartesian), m_mode(GM_Graph)
 , m_gl_class(-1), m_need_update(true)
 {
@@ -134,7 +136,7 @@ Graph::Graph(const Graph &g)
 , m_type(g.m_type)
 , m_coords(g.m_coords)
 , m_mode(g.m_mode)
-, ex(NULL), gl(NULL), m_gl_class(-1), m_need_update(true)
+, ex(NULL), gl(NULL), m_profile(NULL), m_gl_class(-1), m_need_update(true)
 {
 	ins.link(&plot.ns);
 	invalidate();
@@ -147,7 +149,7 @@ Graph::Graph(const Graph &g, Plot &plot)
 , m_type(g.m_type)
 , m_coords(g.m_coords)
 , m_mode(g.m_mode)
-, ex(NULL), gl(NULL), m_gl_class(-1), m_need_update(true)
+, ex(NULL), gl(NULL), m_profile(NULL), m_gl_class(-1), m_need_update(true)
 {
 	ins.link(&plot.ns);
 	invalidate();
@@ -158,6 +160,7 @@ Graph::~Graph()
 	plot.ns.remove(&ins);
 	delete ex;
 	delete gl;
+	delete m_profile;
 }
 
 void Graph::save(Serializer &s) const
@@ -411,6 +414,7 @@ void Graph::invalidate(bool for_init)
 	update(CH_UNKNOWN);
 	delete ex; ex = NULL;
 	delete gl; gl = NULL;
+	delete m_profile; m_profile = NULL;
 	
 	vars.clear();
 	ins.clear();
@@ -510,7 +514,13 @@ void Graph::set(std::string f1, std::string f2, std::string f3)
 	m_f1 = f1;
 	m_f2 = f2;
 	m_f3 = f3;
-	invalidate();
+	if (!ex){ invalidate(); return; }
+
+	// same type, so the variables stay and ex can keep whatever did not change
+	update(CH_UNKNOWN);
+	delete gl; gl = NULL;
+	delete m_profile; m_profile = NULL;
+	ex->strings(strings());
 }
 
 void Graph::type(GraphType t)
@@ -673,40 +683,45 @@ int Graph::inRangeDimension() const
 }
 
 
+std::vector<std::string> Graph::strings() const
+{
+	std::vector<std::string> strings;
+	switch (m_type)
+	{
+		case  R_R: 
+		case R2_R: 
+		case R3_R:
+		case  C_C:
+			strings.push_back(m_f1);
+			break;
+			
+		case  R_R2:
+		case R2_R2:
+		case S1_R2:
+			strings.push_back(m_f1);
+			strings.push_back(m_f2);
+			break;
+			
+		case  R_R3:
+		case R2_R3:
+		case S2_R3:
+		case R3_R3:
+		case S1_R3:
+			strings.push_back(m_f1);
+			strings.push_back(m_f2);
+			strings.push_back(m_f3);
+			break;
+	}
+	return strings;
+}
+
 Expression *Graph::expression() const
 {
 	if (!ex)
 	{
-		std::vector<std::string> strings;
-		switch (m_type)
-		{
-			case  R_R: 
-			case R2_R: 
-			case R3_R:
-			case  C_C:
-				strings.push_back(m_f1);
-				break;
-				
-			case  R_R2:
-			case R2_R2:
-			case S1_R2:
-				strings.push_back(m_f1);
-				strings.push_back(m_f2);
-				break;
-				
-			case  R_R3:
-			case R2_R3:
-			case S2_R3:
-			case R3_R3:
-			case S1_R3:
-				strings.push_back(m_f1);
-				strings.push_back(m_f2);
-				strings.push_back(m_f3);
-				break;
-		}
 		ex = new Expression;
 		ins.add(ex);
-		ex->strings(strings);
+		ex->strings(strings());
 	}
 	return ex;
 }
@@ -723,6 +738,32 @@ Evaluator *Graph::evaluator() const
 	return e;
 }
 
+Evaluator *Graph::jet_evaluator() const
+{
+	if (!ex)
+	{
+		expression();
+		if (!ex || !ex->valid()) return NULL;
+	}
+	if (vars.empty()) return NULL;
+	Evaluator *e = ex->jet_evaluator(vars, vars);
+	if (e) e->set_parameters(used_parameters());
+	return e;
+}
+
+EvalProfile *Graph::profile() const
+{
+	if (!Preferences::profileExpressions()) return NULL;
+	Evaluator *e = evaluator();
+	if (!e) return NULL;
+	if (!m_profile || !m_profile->matches(*e))
+	{
+		delete m_profile;
+		m_profile = new EvalProfile(*e, &ins);
+	}
+	return m_profile;
+}
+
 bool Graph::isValid() const
 {
 	if (!ex)
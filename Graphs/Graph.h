@@ -16,6 +16,7 @@ class Evaluator;
 class Variable;
 class Parameter;
 class GL_Graph;
+class EvalProfile;
 struct Plot;
 
 enum GraphType
@@ -294,6 +295,9 @@ public:
 	std::vector<const Variable*> plotvars() const{ return vars; }
 	
 	Evaluator *evaluator() const; // current parameter values will already be set
+	Evaluator *jet_evaluator() const; // same, followed by the derivatives by each plotvar (or NULL)
+	EvalProfile *profile() const; // NULL unless Preferences::profileExpressions() is on
+	EvalProfile *last_profile() const{ return m_profile; } // for displaying it, does not create one
 	Expression *expression() const;
 	std::set<Parameter*> used_parameters() const;
 	bool uses_parameter(const Parameter &p) const;
@@ -324,10 +328,12 @@ private:
 	mutable std::vector<const Variable*> vars;
 	
 	mutable GL_Graph *gl;
+	mutable EvalProfile *m_profile;
 	mutable int m_gl_class; // used inside gl_graph() only
 	mutable bool m_need_update; // gl needs recomputing
 	
 	void invalidate(bool for_init = false);
+	std::vector<std::string> strings() const; // the formulas that go into ex
 	void fix_mode();   // set to a valid (for current type) mode
 	void fix_coords(); // set to a valid (for current type) coordinate-system
 };
@@ -1,7 +1,9 @@
 #include "GL_AreaGraph.h"
 #include "../Threading/ThreadInfo.h"
+#include "SharedGrid.h"
 #include "../../Utility/Preferences.h"
 #include "../OpenGL/GL_Context.h"
+#include "../OpenGL/GL_Export.h"
 #include <GL/gl.h>
 #include <vector>
 
@@ -11,16 +13,8 @@
 
 static inline double sqr(double x){ return x*x; }
 
-void GL_AreaGraph::update(int n_threads, double quality)
+static bool domain(const Graph &graph, bool &circle, bool &parametric)
 {
-	//------------------------------------------------------------------------------------------------------------------
-	// setup the info structs
-	//------------------------------------------------------------------------------------------------------------------
-	
-	DI_Calc ic(graph);
-	if (!ic.e0 || ic.dim == 0 || ic.dim > 3) return;
-	
-	bool circle, parametric;
 	switch (graph.type())
 	{
 		case  C_C:  circle = false; parametric = (graph.mode()==GM_Image || graph.mode()==GM_Riemann); break;
@@ -28,8 +22,59 @@ void GL_AreaGraph::update(int n_threads, double quality)
 		case R2_R3: circle = false; parametric = true;  break;
 		case S2_R3: circle = true;  parametric = true;  break;
 		case R2_R2: circle = false; parametric = (graph.mode()==GM_Image);  break;
-		default: return;
+		default: return false;
 	}
+	return true;
+}
+
+static inline size_t max_faces(const Graph &graph, double quality)
+{
+	return (size_t)((quality*graph.options.quality*1000.0 + 1.0)*1000.0);
+}
+
+static inline int grid_lines(size_t max_faces)
+{
+	int ngrid = (int)ceil(sqrt(max_faces));
+	return ngrid < 12 ? 12 : ngrid;
+}
+
+static inline bool smooth_shading(const Graph &graph, const DI_Axis &ia)
+{
+	ShadingMode s = graph.options.shading_mode;
+	return !ia.is2D && s != Shading_Hiddenline && s != Shading_Wireframe && s != Shading_Flat;
+}
+
+static inline bool jet_normals(const DI_Calc &ic, bool parametric)
+{
+	// smooth shading uses the exact normals from the derivatives of z = f(x,y) or (x,y,z) = f(u,v)
+	return !ic.complex && (ic.dim == 3 || ic.dim == 1 && !parametric);
+}
+
+bool GL_AreaGraph::sample_grid(double quality, DI_Grid &ig, bool &jet) const
+{
+	bool circle, parametric;
+	if (!domain(graph, circle, parametric)) return false;
+	
+	DI_Axis ia(graph, !parametric, circle);
+	if (ia.pixel <= 0.0) return false;
+	
+	ig = DI_Grid(ia, graph.options.grid_density, grid_lines(max_faces(graph, quality)), false);
+	DI_Calc ic(graph, quality);
+	jet = ic.e0 && !ic.profile && smooth_shading(graph, ia) && jet_normals(ic, parametric);
+	return true;
+}
+
+void GL_AreaGraph::update(int n_threads, double quality)
+{
+	//------------------------------------------------------------------------------------------------------------------
+	// setup the info structs
+	//------------------------------------------------------------------------------------------------------------------
+	
+	DI_Calc ic(graph, quality);
+	if (!ic.e0 || ic.dim == 0 || ic.dim > 3) return;
+	
+	bool circle, parametric;
+	if (!domain(graph, circle, parametric)) return;
 	
 	DI_Axis ia(graph, !parametric, circle);
 	if (ia.pixel <= 0.0) return;
@@ -40,7 +85,6 @@ void GL_AreaGraph::update(int n_threads, double quality)
 	bool do_normals = (!ia.is2D && !hiddenline && !wireframe);
 	bool grid = (wireframe || graph.options.grid_style == Grid_On);
 	bool texture = !wireframe; // this could be more precise but then the settingsBox pays for it...
-	double q0 = graph.options.quality;
 	
 	ic.vertex_normals = (do_normals && !flatshade);
 	ic.face_normals   = (do_normals &&  flatshade);
@@ -56,12 +100,17 @@ void GL_AreaGraph::update(int n_threads, double quality)
 	//info.max_area     = sqr(4.0*info.pixel);
 	//info.min_area     = sqr(2.0*info.pixel);
 	is.max_kink  = sqr(1.0*ia.pixel);
-	is.max_faces = (size_t)((quality*q0*1000.0 + 1.0)*1000.0);
+	is.max_faces = max_faces(graph, quality);
 
+	DI_Grid ig(ia, graph.options.grid_density, grid_lines(is.max_faces), false);
 	
-	int ngrid = (int)ceil(sqrt(is.max_faces));
-	if (ngrid < 12) ngrid = 12;
-	DI_Grid ig(ia, graph.options.grid_density, ngrid, false);
+	if (ic.vertex_normals && jet_normals(ic, parametric)) ic.use_derivatives(graph);
+	if (shared && shared->matches(ig, ic.complex) && (!ic.jet || shared->jet(shared_index)))
+	{
+		ic.shared        = shared->values(shared_index);
+		ic.shared_stride = shared->stride();
+	}
+	ic.choose_precision(ia);
 
 	//int nx = ig.x.nlines(), ny = ig.y.nlines();
 	//double dyn = graph.options.dynamic;
@@ -174,6 +223,10 @@ void GL_AreaGraph::draw(GL_RM &rm) const
 	}
 	assert(wireframe || transparent == !fill_color.opaque());
 
+	// the graph is not bigger than the axis box, but curved surfaces can wrap textures around it, so a few times its
+	// size on screen is the most texels of them that can show. Riemann color graphs map the whole texture anywhere.
+	unsigned tsize = (unsigned)std::min(4.0 * screen_size(), 65536.0);
+
 	//------------------------------------------------------------------------------------------------------------------
 	// setup light and textures
 	//------------------------------------------------------------------------------------------------------------------
@@ -234,11 +287,12 @@ void GL_AreaGraph::draw(GL_RM &rm) const
 			{
 				rm.upload_texture(graph.options.texture);
 			}
-			rm.setup(graph.options.texture_projection == TP_Repeat, false, false);
+			// colorSamples splits the faces of riemann color graphs instead (@see GL_RiemannColorGraph.cc)
+			rm.setup(graph.options.texture_projection == TP_Repeat, Preferences::textureFiltering(), false);
 		}
 		else
 		{
-			rm.upload_texture(graph.options.texture, (float)graph.options.texture_opacity, fill_color);
+			rm.upload_texture(graph.options.texture.level_for(tsize, tsize), (float)graph.options.texture_opacity, fill_color);
 			rm.setup(false, true, true);
 		}
 		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
@@ -256,7 +310,7 @@ void GL_AreaGraph::draw(GL_RM &rm) const
 	if (envmap)
 	{
 		glEnable(GL_TEXTURE_2D);
-		rm.upload_texture(graph.options.reflection_texture, (float)graph.options.reflection_opacity);
+		rm.upload_texture(graph.options.reflection_texture.level_for(tsize, tsize), (float)graph.options.reflection_opacity);
 		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -321,7 +375,19 @@ void GL_AreaGraph::draw(GL_RM &rm) const
 		glEnable(GL_CULL_FACE);
 	}
 
-	if (!wireframe) mesh.draw(has_unit_normals());
+	// coarser faces if the graph is too small on screen for all of them (grid lines are drawn on the fine ones)
+	int lod = 0;
+	if (!grid && !full_grid && !hiddenline && mesh.num_lods() > 1)
+	{
+		P3f a, b, a0, b0;
+		mesh.bounds(a, b);
+		axis_box(a0, b0); // there could be points far outside
+		a.set(std::max(a.x, a0.x), std::max(a.y, a0.y), std::max(a.z, a0.z));
+		b.set(std::min(b.x, b0.x), std::min(b.y, b0.y), std::min(b.z, b0.z));
+		double d = std::max(std::max(b.x - a.x, b.y - a.y), b.z - a.z);
+		if (d > 0.0) lod = mesh.lod(screen_size(a, b) / d);
+	}
+	if (!wireframe) mesh.draw(has_unit_normals(), lod);
 
 	glDisable(GL_CULL_FACE);
 
@@ -404,3 +470,8 @@ void GL_AreaGraph::draw(GL_RM &rm) const
 		
 	finish_drawing();
 }
+
+void GL_AreaGraph::export_geometry(GL_Export &e) const
+{
+	e.add(mesh);
+}
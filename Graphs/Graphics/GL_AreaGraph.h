@@ -11,6 +11,7 @@ public:
 	
 	virtual void update(int n_threads, double quality);
 	virtual void draw(GL_RM &rm) const;
+	virtual void export_geometry(GL_Export &e) const;
 
 	virtual Opacity opacity() const;
 	
@@ -24,6 +25,8 @@ public:
 
 	virtual bool has_unit_normals() const{ return graph.options.shading_mode == Shading_Flat; }
 
+	virtual bool sample_grid(double quality, DI_Grid &ig, bool &jet) const;
+
 protected:
 	GL_Mesh      mesh;
 	GL_MaskScale mask_scale;
@@ -12,9 +12,10 @@
 //----------------------------------------------------------------------------------------------------------------------
 
 static void gridWorker(ThreadInfo &ti, int i1, int i2, GL_Mesh  &mesh, bool *eau, VisibilityFlags *vis,
-					   bool flat, bool between, size_t &skipped_faces)
+					   bool *exact, bool flat, bool between, size_t &skipped_faces)
 {
 	// if between is true, we are on the second run through and the outer rows are already done
+	// if exact is set, vertex normals come from the derivatives where possible and exact[idx] tells where
 	
 	//------------------------------------------------------------------------------------------------------------------
 	// extract info
@@ -29,6 +30,7 @@ static void gridWorker(ThreadInfo &ti, int i1, int i2, GL_Mesh  &mesh, bool *eau
 	bool texture    = (tau != NULL);
 	bool grid       = (eau != NULL);
 
+	const DI_Calc        &ic = ti.ic;
 	const DI_Axis        &ia = ti.ia;
 	const DI_Grid        &ig = ti.ig;
 	const DI_Subdivision &is = ti.is;
@@ -61,16 +63,22 @@ static void gridWorker(ThreadInfo &ti, int i1, int i2, GL_Mesh  &mesh, bool *eau
 				//------------------------------------------------------------------------------------------------------
 				
 				bool exists;
-				ti.eval(xj, yi, vau[idx], exists, false, j>0 && !disco);
+				const cnum *pre = ic.shared ? ic.shared + (size_t)idx*ic.shared_stride : NULL;
+				if (pre)
+					ti.extract(xj, yi, pre, vau[idx], exists);
+				else
+					ti.eval(xj, yi, vau[idx], exists, false, j>0 && !disco);
 				
 				if (exists)
 				{
 					vis[idx].set(ia, vau[idx]);
 					if (texture) ti.ia.map_texture(xj, yi, tau[idx]);
+					if (exact) exact[idx] = pre ? ti.extract_normal(pre, nau[idx]) : ti.extract_normal(nau[idx]);
 				}
 				else
 				{
 					vis[idx].set_invalid();
+					if (exact) exact[idx] = false;
 				}
 			}
 			
@@ -173,6 +181,13 @@ static void gridWorker(ThreadInfo &ti, int i1, int i2, GL_Mesh  &mesh, bool *eau
 						n.to_unit();
 						*face_normal++ = n;
 					}
+					else if (exact)
+					{
+						// only where the derivatives failed
+						if (!exact[p1[k]]) nau[p1[k]] += n;
+						if (!exact[p2[k]]) nau[p2[k]] += n;
+						if (!exact[p3[k]]) nau[p3[k]] += n;
+					}
 					else
 					{
 						nau[p1[k]] += n;
@@ -202,6 +217,7 @@ void GL_AreaGraph::update_without_subdivision(int n_threads, std::vector<void *>
 	// extract info
 	//------------------------------------------------------------------------------------------------------------------
 
+	const DI_Calc &ic = *(const DI_Calc*)info[0];
 	const DI_Axis &ia = *(const DI_Axis*)info[1];
 	const DI_Grid &ig = *(const DI_Grid*)info[3];
 
@@ -233,6 +249,7 @@ void GL_AreaGraph::update_without_subdivision(int n_threads, std::vector<void *>
 	
 	std::unique_ptr<bool[]> eau(grid ? new bool[3*nfaces] : NULL);
 	std::unique_ptr<VisibilityFlags[]> vis(new VisibilityFlags[nvertexes]);
+	std::unique_ptr<bool[]> exact(ic.jet && do_normals && !flat ? new bool[nvertexes] : NULL);
 	std::vector<size_t> skipped_faces;
 
 	//------------------------------------------------------------------------------------------------------------------
@@ -249,11 +266,11 @@ void GL_AreaGraph::update_without_subdivision(int n_threads, std::vector<void *>
 	bool between = false;
 	for (int i = 0, j = 0; i < ny; i += chunk, ++j, between = !between)
 	{
-		gridLayer->add_unit([=,&eau,&vis,&skipped_faces](void *ti)
+		gridLayer->add_unit([=,&eau,&vis,&exact,&skipped_faces](void *ti)
 		{
 			gridWorker(*(ThreadInfo*)ti,
 					   i, i+chunk, // i+chunk can be > ny, but the last worker-thread needs to know that it is the last
-					   mesh, eau.get(), vis.get(),
+					   mesh, eau.get(), vis.get(), exact.get(),
 					   flat, between, skipped_faces[j]);
 		});
 	}
@@ -307,6 +324,7 @@ void GL_AreaGraph::update_without_subdivision(int n_threads, std::vector<void *>
 
 	mesh.close_gaps(2*(nx-1)*chunk, skipped_faces, eau.get());
 	mesh.set_grid(eau.get());
+	mesh.set_lod(nx, ny);
 	
 #ifdef AGDEBUG
 	std::cerr << " -- faces: " << nfaces << " + " << ((size_t)(nx-1) * (ny-1) * 2 - nfaces) << " dropped"
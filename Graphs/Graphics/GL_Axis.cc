@@ -229,7 +229,7 @@ void GL_Axis::draw2D() const
 		GL_Font font(axis.options.label_font);
 		font.color = caxis;
 		labelCache.font(font);
-		labelCache.start();
+		labelCache.start(true);
 
 		for (LabelIterator l(al, x0+20.0*pixel, x1-border-arrh, 6.0*pixel); !l.done(); ++l)
 		{
@@ -285,7 +285,7 @@ void GL_Axis::draw3D() const
 	glEnd();
 
 	// XYZ-labels
-	labelCache.start();
+	labelCache.start(true);
 	GL_Font font(axis.options.label_font);
 	font.size *= 1.5f;
 	font.color = axis.options.axis_color;
@@ -4,189 +4,409 @@
 #include "../Threading/ThreadMap.h"
 #include "../OpenGL/GL_Util.h"
 #include "../OpenGL/GL_RM.h"
+#include "../OpenGL/GL_Export.h"
+#include "../Geometry/Jitter.h"
+#include "../../Utility/Preferences.h"
+#include "../../Engine/Parser/DeepZoom.h"
 
 #include <vector>
 #include <algorithm>
 
 //----------------------------------------------------------------------------------------------------------------------
-// update worker: fill in the area [x1,x2) x [y1,y2)
+// texture projections: map a row of z values to texel coordinates
 //----------------------------------------------------------------------------------------------------------------------
+// Every kernel writes continuous texel coordinates into u and v, where texel (i,j) covers [j,j+1) x [i,i+1).
+// Undefined z (and z outside the texture for TP_Center) give NaN, which the lookup turns into transparent pixels.
+// The loops are branch-free so the compiler can vectorize them.
 
-static void update(ThreadInfo &ti, int w, int h, int y1, int y2, unsigned char *data, const GL_Image &tex, TextureProjection tp)
+struct TextureInfo
 {
-	const DI_Axis &ia = ti.ia;
-	const DI_Calc &ic = ti.ic;
-	BoundContext  &ec = ti.ec;
+	TextureInfo(const GL_Image &tex, TextureProjection tp, bool bilinear)
+	: tw(tex.w()), th(tex.h())
+	, tp(tp), bilinear(bilinear), wrap(tp == TP_Repeat || tp == TP_UV)
+	{
+		for (unsigned k = 0; k < tex.levels(); ++k)
+		{
+			const GL_Image &L = tex.level(k);
+			levels.push_back(Level{L.w(), L.h(), (const uint32_t*)L.data().data(), (double)L.w() / tw, (double)L.h() / th});
+		}
+	}
 	
-	int32_t *dst = (int32_t*)data;
+	struct Level
+	{
+		unsigned w, h;
+		const uint32_t *d;
+		double sx, sy; // from texel coordinates in level 0
+	};
+	
+	unsigned tw, th;
+	std::vector<Level> levels; // mip pyramid of the texture, levels[0] is the texture itself
+	TextureProjection tp;
+	bool bilinear, wrap;
+};
+
+static void project_repeat(const TextureInfo &t, const cnum *z, int n, double *u, double *v)
+{
+	const double tw = t.tw, th = t.th, ys = tw / th;
+	for (int j = 0; j < n; ++j)
+	{
+		double x = z[j].real(), y = z[j].imag() * ys;
+		double fy = y - floor(y); if (fy >= 1.0) fy = 0.0; // y = -tiny
+		u[j] = (x - floor(x)) * tw;
+		// row th-1 - floor(fy*th) as in the unbatched lookup, so fy = 0 is row th-1 (not th, which would wrap to 0)
+		// and the boundary between two rows belongs to the one with the smaller index
+		double r = th - fy * th;
+		v[j] = r == floor(r) ? nextafter(r, 0.0) : r;
+	}
+}
+
+static void project_center(const TextureInfo &t, const cnum *z, int n, double *u, double *v)
+{
+	const double ys = (double)t.tw / t.th, cx = 0.5*(t.tw-1), cy = 0.5*(t.th-1);
+	for (int j = 0; j < n; ++j)
+	{
+		double x = z[j].real(), y = -z[j].imag() * ys;
+		bool inside = fabs(x) <= 1.0 && fabs(y) <= 1.0;
+		u[j] = inside ? (x+1.0) * cx : UNDEFINED;
+		v[j] = inside ? (y+1.0) * cy : UNDEFINED;
+	}
+}
+
+static void project_riemann(const TextureInfo &t, const cnum *z, int n, double *u, double *v)
+{
+	/*******************************************************************************************************************
+	 (1) project z onto riemann sphere:
+	 l = 2 / (|z|² + 1)
+	 q.x = l * rez
+	 q.y = l * imz
+	 q.z = l - 1
+	 
+	 (2) find the (spherical) distance from the north pole to q, normalize to [0,1]
+	 d = arccos(q.z) / π = 2 arctan(|z|) / π
+	 
+	 (3) find the texture coords on a unit disk
+	 z *= d / |z|
+	 ******************************************************************************************************************/
+	const double tr = M_1_PI * std::min(t.tw-1, t.th-1) * 0.99999, tx = 0.5*(t.tw-1), ty = 0.5*(t.th-1);
+	for (int j = 0; j < n; ++j)
+	{
+		double r = std::hypot(z[j].real(), z[j].imag());
+		double f = r > 0.0 ? tr * atan(r) / r : tr;
+		u[j] = tx + f * z[j].real();
+		v[j] = ty - f * z[j].imag();
+	}
+}
+
+static void project_uv(const TextureInfo &t, const cnum *z, int n, double *u, double *v)
+{
+	/*******************************************************************************************************************
+	 (1) project z onto riemann sphere:
+	 l = 2 / (|z|² + 1)
+	 q.x = l * rez
+	 q.y = l * imz
+	 q.z = l - 1;
+	 
+	 (2) find its spherical coordinates when N = 0, S = ∞
+	 phi   = arccos(q.z)     in [ 0, π]  (= 2 arctan(|z|))
+	 theta = arctan(q.y/q.x) in [-π, π]
+	 
+	 (3) map range to texture range
+	 x = theta*w/2π
+	 y = phi*h/π
+	 ******************************************************************************************************************/
+	const double fx = 0.5 * M_1_PI * t.tw, fy = 2.0 * M_1_PI * t.th;
+	for (int j = 0; j < n; ++j)
+	{
+		double x = z[j].real(), y = z[j].imag();
+		bool def = defined(z[j]);
+		u[j] = def ? (atan2(y, x) + M_PI) * fx : UNDEFINED;
+		v[j] = def ? atan(std::hypot(x, y)) * fy : UNDEFINED;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// texel lookup
+//----------------------------------------------------------------------------------------------------------------------
+
+static inline unsigned wrap_index(int i, unsigned n)
+{
+	int r = i % (int)n;
+	return (unsigned)(r < 0 ? r + (int)n : r);
+}
+
+static inline uint32_t blend(uint32_t a, uint32_t b, uint32_t c, uint32_t d, unsigned wx, unsigned wy)
+{
+	// bilinear mix of the four texels with 8 bit weights (wx, wy in [0,256])
+	const unsigned wa = (256-wx)*(256-wy), wb = wx*(256-wy), wc = (256-wx)*wy, wd = wx*wy;
+	uint32_t r = 0;
+	for (int k = 0; k < 32; k += 8)
+	{
+		uint32_t s = ((a >> k) & 0xFF) * wa + ((b >> k) & 0xFF) * wb + ((c >> k) & 0xFF) * wc + ((d >> k) & 0xFF) * wd;
+		r |= ((s + 32768) >> 16) << k;
+	}
+	return r;
+}
+
+static inline uint32_t texel(const TextureInfo &t, const TextureInfo::Level &L, double x, double y)
+{
+	const unsigned tw = L.w, th = L.h;
 	
-	unsigned tw = tex.w(), th = tex.h();
-	double ys = (double)tw / th;
-	const int32_t *td = (int32_t*)tex.data().data();
+	if (!t.bilinear)
+	{
+		unsigned tj = (unsigned)x, ti = (unsigned)y;
+		if (t.wrap){ tj %= tw; ti %= th; }
+		else{ tj = std::min(tj, tw-1); ti = std::min(ti, th-1); }
+		return L.d[(size_t)tw * ti + tj];
+	}
 	
-	double tr = M_1_PI * 0.5 * std::min(tw-1, th-1) * 0.99999, tx = 0.5*(tw-1), ty = 0.5*(th-1); // for riemann
-	double int_part; // unused
+	x -= 0.5; y -= 0.5;
+	double x0 = floor(x), y0 = floor(y);
+	unsigned wx = (unsigned)((x - x0) * 256.0 + 0.5), wy = (unsigned)((y - y0) * 256.0 + 0.5);
+	int j0 = (int)x0, i0 = (int)y0;
+	unsigned j1, i1;
+	if (t.wrap)
+	{
+		j1 = wrap_index(j0+1, tw); j0 = (int)wrap_index(j0, tw);
+		i1 = wrap_index(i0+1, th); i0 = (int)wrap_index(i0, th);
+	}
+	else
+	{
+		j1 = (unsigned)std::max(0, std::min(j0+1, (int)tw-1)); j0 = std::max(0, std::min(j0, (int)tw-1));
+		i1 = (unsigned)std::max(0, std::min(i0+1, (int)th-1)); i0 = std::max(0, std::min(i0, (int)th-1));
+	}
+	const uint32_t *r0 = L.d + (size_t)tw * i0, *r1 = L.d + (size_t)tw * i1;
+	return blend(r0[j0], r0[j1], r1[j0], r1[j1], wx, wy);
+}
+
+// distance in level 0 texels between two lookups
+static inline double texel_distance(const TextureInfo &t, double u0, double v0, double u1, double v1)
+{
+	double du = fabs(u1 - u0), dv = fabs(v1 - v0);
+	if (t.wrap){ du = std::min(du, t.tw - du); dv = std::min(dv, t.th - dv); }
+	return std::max(du, dv);
+}
+
+// Texels are read from the mip level that matches the distance between neighbouring lookups: the pixels of a row
+// (for C_C graphs the mapping is conformal, so this is their size in every direction) or, with group > 1, the
+// samples of one pixel.
+static void lookup(const TextureInfo &t, const double *u, const double *v, int n, int32_t *dst, int group = 1)
+{
+	const int nl = (int)t.levels.size();
 	
-	for (int i = y1; i < y2; ++i)
+	for (int j = 0; j < n; ++j)
 	{
-		int32_t *d = dst + (size_t)w * i;
-		double y = ((h-1-i) * ia.min[1] + i * ia.max[1]) / (h-1);
+		if (isnan(u[j]) || isnan(v[j])){ dst[j] = 0; continue; }
 		
-		for (int j = 0; j < w; ++j, ++d)
+		double d = 0.0;
+		if (nl > 1 && group > 1)
 		{
-			double x = ((w-1-j) * ia.min[0] + j * ia.max[0]) / (w-1);
-			
-			cnum z;
-			
-			if (ic.complex)
+			for (int k = j - j % group, k1 = k + group; k < k1; ++k)
 			{
-				if (ic.xi >= 0) ec.set_input(ic.xi, cnum(x,y));
-				ec.eval();
-				z = ec.output(0);
-			}
-			else
-			{
-				if (ic.xi >= 0) ec.set_input(ic.xi, x);
-				if (j == 0 && ic.yi >= 0) ec.set_input(ic.yi, y);
-				#ifdef DEBUG
-				if (j != 0 && ic.yi >= 0) assert(ec.input(ic.yi).real() == y);
-				#endif
-				ec.eval();
-				assert(ic.dim == 2);
-				
-				const cnum &xc = ec.output(0);
-				const cnum &yc = ec.output(1);
-				if (is_real(xc) && is_real(yc))
-				{
-					z.real(xc.real());
-					z.imag(yc.real());
-				}
-				else
-				{
-					z = UNDEFINED;
-				}
-			}
-			
-			if (defined(z))
-			{
-				unsigned ti, tj;
-				
-				switch (tp)
-				{
-					case TP_Repeat:
-					{
-						double fx = modf(z.real(),    &int_part); if (fx < 0.0){ ++fx; assert(fx >= 0.0); }
-						double fy = modf(z.imag()*ys, &int_part); if (fy < 0.0){ ++fy; assert(fy >= 0.0); }
-						tj = (unsigned)(fx * tw) % tw;
-						ti = th-1 - (unsigned)(fy * th) % th;
-						assert(tj < tw);
-						assert(ti < th);
-						*d = td[(size_t)tw * ti + tj];
-						break;
-					}
-						
-					case TP_Center:
-					{
-						double x =  z.real();
-						double y = -z.imag() * tw / th;
-						if (abs(x) <= 1.0 && abs(y) <= 1.0)
-						{
-							tj = (unsigned)((x+1.0) * (tw-1) * 0.5);
-							ti = (unsigned)((y+1.0) * (th-1) * 0.5);
-							assert(tj < tw);
-							assert(ti < th);
-							*d = td[(size_t)tw * ti + tj];
-						}
-						else
-						{
-							*d = 0;
-						}
-						break;
-					}
-						
-					case TP_Riemann:
-					{
-						/***********************************************************************************************
-						 (1) project z onto riemann sphere:
-						 l = 2 / (|z|² + 1)
-						 q.x = l * rez
-						 q.y = l * imz
-						 q.z = l - 1
-						 
-						 (2) find the (spherical) distance from the north pole to q, normalize to [0,1]
-						 d = arccos(q.z) / π
-						 
-						 (3) find the texture coords on a unit disk
-						 z *= d / |z|
-						 **********************************************************************************************/
-						double r = abs(z);
-						if (r > 0.0)
-						{
-							double f = tr * acos(2.0 / (r*r + 1.0) - 1.0) / r;
-							tj = (unsigned)(tx + f*z.real());
-							ti = (unsigned)(ty - f*z.imag());
-						}
-						else
-						{
-							tj = (unsigned)tx;
-							ti = (unsigned)ty;
-						}
-						assert(tj < tw);
-						assert(ti < th);
-						*d = td[(size_t)tw * ti + tj];
-						break;
-						
-						#if 0
-						// TODO: is this riemann texture projection?
-						double fx = std::min(1.0, th), fy = std::min(1.0, 1.0/th);
-						for (int ip = 0; ip < 5; ++ip)
-						{
-							P3f &v = ...;
-							double d = sqrt(2.0+2.0*v.z);
-							t->x = (float)(0.5 + 0.5*fx * v.x/d);
-							t->y = (float)(0.5 - 0.5*fy * v.y/d);
-							++t;
-						}
-						#endif
-					}
-						
-					case TP_UV:
-					{
-						/***********************************************************************************************
-						 (1) project z onto riemann sphere:
-						 l = 2 / (|z|² + 1)
-						 q.x = l * rez
-						 q.y = l * imz
-						 q.z = l - 1;
-						 
-						 (2) find its spherical coordinates when N = 0, S = ∞
-						 phi   = arccos(q.z)     in [ 0, π]
-						 theta = arctan(q.y/q.x) in [-π, π]
-						 
-						 (3) map range to texture range
-						 x = theta*w/2π
-						 y = phi*h/π
-						 **********************************************************************************************/
-						
-						double phi   = acos(2.0 / (absq(z) + 1.0) - 1.0) / M_PI;
-						double theta = atan2(z.imag(), z.real()) / M_PI + 1.0;
-						
-						tj = (unsigned)(theta * tw * 0.5) % tw;
-						ti = (unsigned)(phi * th) % th;
-						
-						assert(tj < tw);
-						assert(ti < th);
-						*d = td[(size_t)tw * ti + tj];
-						break;
-					}
-				}
-				
-			}
-			else
-			{
-				*d = 0;
+				if (!isnan(u[k]) && !isnan(v[k])) d = std::max(d, texel_distance(t, u[j], v[j], u[k], v[k]));
 			}
 		}
+		else if (nl > 1)
+		{
+			// the smaller step, so discontinuities do not blur their neighbours
+			double d0 = j > 0   && !isnan(u[j-1]) && !isnan(v[j-1]) ? texel_distance(t, u[j], v[j], u[j-1], v[j-1]) : INFINITY;
+			double d1 = j < n-1 && !isnan(u[j+1]) && !isnan(v[j+1]) ? texel_distance(t, u[j], v[j], u[j+1], v[j+1]) : INFINITY;
+			d = std::min(d0, d1);
+			if (d == INFINITY) d = 0.0;
+		}
+		
+		int k = d < 2.0 ? 0 : std::min(nl-1, std::ilogb(d));
+		const TextureInfo::Level &L = t.levels[k];
+		dst[j] = (int32_t)texel(t, L, u[j] * L.sx, v[j] * L.sy);
+	}
+}
+
+static void texture_row(const TextureInfo &t, const cnum *z, int n, double *u, double *v, int32_t *dst, int group = 1)
+{
+	switch (t.tp)
+	{
+		case TP_Repeat:  project_repeat (t, z, n, u, v); break;
+		case TP_Center:  project_center (t, z, n, u, v); break;
+		case TP_Riemann: project_riemann(t, z, n, u, v); break;
+		case TP_UV:      project_uv     (t, z, n, u, v); break;
+		default: assert(false); std::fill(u, u+n, UNDEFINED); break;
+	}
+	lookup(t, u, v, n, dst, group);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// evaluation
+//----------------------------------------------------------------------------------------------------------------------
+
+#define DEEP_ZOOM 1e-12 // relative pixel size where mandel and julia switch to DeepZoom
+
+// pixel coordinates are absolute or, with DeepZoom, relative to the axis center
+struct View
+{
+	View(const DI_Axis &ia, const DeepZoom *dz) : dz(dz)
+	{
+		for (int i = 0; i < 2; ++i)
+		{
+			min[i] = dz ? -ia.range[i] : ia.min[i];
+			max[i] = dz ?  ia.range[i] : ia.max[i];
+		}
+	}
+	
+	double min[2], max[2];
+	const DeepZoom *dz;
+};
+
+static inline cnum eval(ThreadInfo &ti, const View &view, double x, double y, bool same_y = false)
+{
+	const DI_Calc &ic = ti.ic;
+	BoundContext  &ec = ti.ec;
+	
+	if (view.dz) return view.dz->eval(x, y);
+	
+	if (ic.complex)
+	{
+		if (ic.xi >= 0) ec.set_input(ic.xi, cnum(x,y));
+		ec.eval();
+		return ec.output(0);
+	}
+	
+	if (ic.xi >= 0) ec.set_input(ic.xi, x);
+	if (!same_y && ic.yi >= 0) ec.set_input(ic.yi, y);
+	#ifdef DEBUG
+	if (same_y && ic.yi >= 0) assert(ec.input(ic.yi).real() == y);
+	#endif
+	ec.eval();
+	assert(ic.dim == 2);
+	
+	const cnum &xc = ec.output(0);
+	const cnum &yc = ec.output(1);
+	return is_real(xc) && is_real(yc) ? cnum(xc.real(), yc.real()) : cnum(UNDEFINED);
+}
+
+static void eval_row(ThreadInfo &ti, const View &view, double y, int n, cnum *z)
+{
+	const double x0 = view.min[0], x1 = view.max[0];
+	for (int j = 0; j < n; ++j)
+	{
+		double x = ((n-1-j) * x0 + j * x1) / (n-1);
+		z[j] = eval(ti, view, x, y, j > 0);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// adaptive supersampling: pixels that differ strongly from one of their neighbours are re-evaluated at several
+// jittered positions and replaced by the average color.
+//----------------------------------------------------------------------------------------------------------------------
+
+#define EDGE_THRESHOLD 32 // max difference in any color channel for non-edges
+
+static inline bool differs(uint32_t a, uint32_t b)
+{
+	for (int k = 0; k < 32; k += 8)
+	{
+		if (abs((int)((a >> k) & 0xFF) - (int)((b >> k) & 0xFF)) > EDGE_THRESHOLD) return true;
+	}
+	return false;
+}
+
+struct SampleBuffers
+{
+	std::vector<int>     edges;
+	std::vector<cnum>    z;
+	std::vector<double>  u, v;
+	std::vector<int32_t> c;
+};
+
+static void antialias_row(ThreadInfo &ti, const View &view, const TextureInfo &tex, int samples, int w, int h, int i,
+						  const int32_t *prev, const int32_t *cur, const int32_t *next, int32_t *dst, SampleBuffers &b)
+{
+	std::copy(cur, cur+w, dst);
+	
+	b.edges.clear();
+	for (int j = 0; j < w; ++j)
+	{
+		uint32_t c = (uint32_t)cur[j];
+		if (j > 0   && differs(c, (uint32_t)cur[j-1]) ||
+			j < w-1 && differs(c, (uint32_t)cur[j+1]) ||
+			prev    && differs(c, (uint32_t)prev[j])  ||
+			next    && differs(c, (uint32_t)next[j]))
+		{
+			b.edges.push_back(j);
+		}
+	}
+	if (b.edges.empty()) return;
+	
+	const double (*jit)[2] = (samples == 8 ? jit8 : jit4);
+	const double dx = (view.max[0] - view.min[0]) / (w-1), dy = (view.max[1] - view.min[1]) / (h-1);
+	const double y = ((h-1-i) * view.min[1] + i * view.max[1]) / (h-1);
+	
+	const size_t n = b.edges.size() * samples;
+	b.z.resize(n); b.u.resize(n); b.v.resize(n); b.c.resize(n);
+	
+	cnum *z = b.z.data();
+	for (int j : b.edges)
+	{
+		double x = ((w-1-j) * view.min[0] + j * view.max[0]) / (w-1);
+		for (int k = 0; k < samples; ++k)
+		{
+			*z++ = eval(ti, view, x + (jit[k][0] - 0.5) * dx, y + (jit[k][1] - 0.5) * dy);
+		}
+	}
+	texture_row(tex, b.z.data(), (int)n, b.u.data(), b.v.data(), b.c.data(), samples);
+	
+	const uint32_t *c = (const uint32_t*)b.c.data();
+	for (int j : b.edges)
+	{
+		uint32_t r = 0;
+		for (int k = 0; k < 32; k += 8)
+		{
+			unsigned s = 0;
+			for (int l = 0; l < samples; ++l) s += (c[l] >> k) & 0xFF;
+			r |= ((s + samples/2) / samples) << k;
+		}
+		dst[j] = (int32_t)r;
+		c += samples;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// update worker: fill in the rows [y1,y2)
+//----------------------------------------------------------------------------------------------------------------------
+
+static void update(ThreadInfo &ti, const DeepZoom *dz, int w, int h, int y1, int y2, unsigned char *data,
+				   const TextureInfo &tex, int samples)
+{
+	const View view(ti.ia, dz);
+	int32_t *dst = (int32_t*)data;
+	
+	std::vector<cnum>   z(w);
+	std::vector<double> uv(2*(size_t)w);
+	auto row = [&](int i, int32_t *d)
+	{
+		double y = ((h-1-i) * view.min[1] + i * view.max[1]) / (h-1);
+		eval_row(ti, view, y, w, z.data());
+		texture_row(tex, z.data(), w, uv.data(), uv.data() + w, d);
+	};
+	
+	if (samples <= 1)
+	{
+		for (int i = y1; i < y2; ++i) row(i, dst + (size_t)w * i);
+		return;
+	}
+	
+	// keep the unfiltered rows i-1, i and i+1, so the edge detection never sees already smoothed pixels
+	// (the rows just outside [y1,y2) are computed twice, once here and once in the neighbouring unit)
+	std::vector<int32_t> window(3*(size_t)w);
+	int32_t *prev = window.data(), *cur = prev + w, *next = cur + w;
+	SampleBuffers buffers;
+	
+	if (y1 > 0) row(y1-1, prev);
+	row(y1, cur);
+	for (int i = y1; i < y2; ++i)
+	{
+		if (i+1 < h) row(i+1, next);
+		antialias_row(ti, view, tex, samples, w, h, i, i > 0 ? prev : NULL, cur, i+1 < h ? next : NULL, dst + (size_t)w * i, buffers);
+		std::swap(prev, cur);
+		std::swap(cur, next);
 	}
 }
 
@@ -200,7 +420,8 @@ void GL_ColorGraph::update(int nthreads, double quality)
 	// (1) setup the info structs
 	//------------------------------------------------------------------------------------------------------------------
 	
-	DI_Calc ic(graph);
+	deep = false;
+	DI_Calc ic(graph, quality);
 	if (!ic.e0 || ic.dim <= 0 || ic.dim > 3 || graph.options.texture.empty()){ im.redim(0, 0); return; }
 	
 	DI_Axis ia(graph, true, false);
@@ -247,9 +468,26 @@ void GL_ColorGraph::update(int nthreads, double quality)
 		im.redim(0, 0);
 	}
 	if (im.empty()) return;
+	
+	// mandel and julia can zoom in further with perturbation
+	DeepZoom *dz = ic.complex && !ic.profile ? DeepZoom::create(*ic.e0, ic.xi) : NULL;
+	deep = (dz != NULL); // let the axis zoom in that far
+	double pixel = 2.0 * ia.range[0] / std::max(1, (int)im.w()-1);
+	if (dz && pixel < DEEP_ZOOM * std::max(1.0, std::max(fabs(ia.center[0]), fabs(ia.center[1]))))
+	{
+		dz->set_view(ia.center[0], ia.center_lo[0], ia.center[1], ia.center_lo[1], ia.range[0], ia.range[1], pixel);
+	}
+	else
+	{
+		delete dz;
+		dz = NULL;
+	}
 
 	WorkLayer *layer = new WorkLayer("calculate", &task, NULL);
 	
+	TextureInfo tex(graph.options.texture, graph.options.texture_projection, Preferences::textureFiltering());
+	int samples = quality >= 1.0 ? Preferences::colorSamples() : 1; // no supersampling during animation
+	
 	int     h = im.h();
 	int chunk = (h+nthreads-1) / nthreads;
 	if (chunk < 2) chunk = 2;
@@ -258,11 +496,12 @@ void GL_ColorGraph::update(int nthreads, double quality)
 		int i1 = std::min(h, i+chunk);
 		layer->add_unit([=](void *ti)
 		{
-			::update(*(ThreadInfo*)ti, im.w(), im.h(), i, i1, data, graph.options.texture, graph.options.texture_projection);
+			::update(*(ThreadInfo*)ti, dz, im.w(), im.h(), i, i1, data, tex, samples);
 		});
 	}
 	
 	task.run(nthreads);
+	delete dz;
 }
 
 Opacity GL_ColorGraph::opacity() const
@@ -331,3 +570,8 @@ void GL_ColorGraph::draw(GL_RM &rm) const
 	
 	finish_drawing();
 }
+
+void GL_ColorGraph::export_geometry(GL_Export &e) const
+{
+	if (!im.empty()) e.add(im);
+}
@@ -7,10 +7,11 @@
 class GL_ColorGraph : public GL_Graph
 {
 public:
-	GL_ColorGraph(Graph &graph) : GL_Graph(graph){ }
+	GL_ColorGraph(Graph &graph) : GL_Graph(graph), deep(false){ }
 	
 	virtual void update(int n_threads, double quality);
 	virtual void draw(GL_RM &rm) const;
+	virtual void export_geometry(GL_Export &e) const;
 	
 	virtual bool needs_depth_sort() const{ return false; }
 	virtual void depth_sort(const P3f &v){ (void)v; }
@@ -18,8 +19,10 @@ public:
 	virtual Opacity opacity() const;
 
 	virtual bool has_unit_normals() const{ return true; } // has no normals
+	virtual bool deep_zoom() const{ return deep; }
 
 private:
 	GL_Image im;
 	float xr, yr, zr;
+	bool deep; // mandel or julia, set by update
 };
@@ -67,3 +67,33 @@ void GL_Graph::finish_drawing() const
 
 	GL_CHECK;
 }
+
+void GL_Graph::axis_box(P3f &a, P3f &b) const
+{
+	const Axis &axis = graph.plot.axis;
+	if (axis.type() == Axis::Sphere)
+	{
+		a.set(-1.0f, -1.0f, -1.0f); b.set(1.0f, 1.0f, 1.0f);
+		return;
+	}
+	axis.map(P3d(axis.min(0), axis.min(1), axis.min(2)), a);
+	axis.map(P3d(axis.max(0), axis.max(1), axis.max(2)), b);
+}
+
+double GL_Graph::screen_size(const P3f &a, const P3f &b) const
+{
+	const Camera &camera = graph.plot.camera;
+	
+	// [-1,1] fills the screen width
+	if (graph.plot.axis.type() == Axis::Rect) return 0.5 * camera.screen_w() * std::max(b.x - a.x, b.y - a.y);
+	
+	P2f p, p0, p1;
+	for (int i = 0; i < 8; ++i)
+	{
+		if (!camera.project(P3f(i&1 ? b.x : a.x, i&2 ? b.y : a.y, i&4 ? b.z : a.z), p)) return INFINITY;
+		if (i == 0){ p0 = p; p1 = p; continue; }
+		p0.x = std::min(p0.x, p.x); p1.x = std::max(p1.x, p.x);
+		p0.y = std::min(p0.y, p.y); p1.y = std::max(p1.y, p.y);
+	}
+	return 0.5 * camera.screen_w() * std::max(p1.x - p0.x, p1.y - p0.y);
+}
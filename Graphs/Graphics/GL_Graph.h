@@ -3,6 +3,9 @@
 class Graph;
 struct Plot;
 class GL_RM;
+struct DI_Grid;
+class SharedGrid;
+class GL_Export;
 
 enum Opacity
 {
@@ -14,7 +17,7 @@ enum Opacity
 class GL_Graph
 {
 public:
-	GL_Graph(Graph &graph) : graph(graph){ }
+	GL_Graph(Graph &graph) : graph(graph), shared(NULL), shared_index(0){ }
 	virtual ~GL_Graph(){ }
 
 	virtual void draw(GL_RM &rm) const = 0;
@@ -25,10 +28,23 @@ public:
 	virtual Opacity opacity() const = 0;
 	virtual bool has_unit_normals() const = 0;
 	virtual bool wants_backface_culling() const{ return false; }
+	virtual void export_geometry(GL_Export &e) const{ } // add what draw would draw (@see GL_Export)
+	virtual bool deep_zoom() const{ return false; } // can be drawn at ranges far below double precision (@see DeepZoom)
+	
+	// for evaluating graphs that sample the same grid together (@see SharedGrid)
+	virtual bool sample_grid(double quality, DI_Grid &ig, bool &jet) const{ return false; } // grid that update would use,
+	                                                                                      // jet if with derivatives
+	void share(const SharedGrid *g, int k){ shared = g; shared_index = k; }
 	
 protected:
 	Graph &graph;
+	const SharedGrid *shared; // precomputed values for the next update or NULL
+	int shared_index;         // our index in shared
 	
 	void  start_drawing() const; // handles clipping
 	void finish_drawing() const;
+	
+	void   axis_box(P3f &a, P3f &b) const; // in GL coordinates
+	double screen_size(const P3f &a, const P3f &b) const; // largest extent of [a,b] on screen in pixels, infinite if behind the camera
+	double screen_size() const{ P3f a, b; axis_box(a, b); return screen_size(a, b); } // of the axis box
 };
@@ -186,7 +186,7 @@ void GL_Histogram::update(int nthreads, double quality)
 	assert(graph.isHistogram());
 	bool normal = (graph.options.hist_mode == HM_Normal);
 	
-	DI_Calc ic(graph);
+	DI_Calc ic(graph, quality);
 	if (!ic.e0 || ic.dim != 1)
 	{
 		mesh.clear();
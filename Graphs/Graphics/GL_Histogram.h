@@ -10,4 +10,5 @@ public:
 	virtual bool wants_backface_culling() const{ return true; }
 
 	virtual void update(int n_threads, double quality);
+	virtual bool sample_grid(double, DI_Grid &, bool &) const{ return false; } // has its own update
 };
@@ -481,7 +481,7 @@ void GL_ImplicitAreaGraph::update(int n_threads, double quality)
 	// setup the info structs
 	//------------------------------------------------------------------------------------------------------------------
 	
-	DI_Calc ic(graph);
+	DI_Calc ic(graph, quality);
 	if (graph.type() != R3_R || !ic.e0 || ic.dim != 1) return;
 	
 	DI_Axis ia(graph, true, false);
@@ -9,4 +9,5 @@ public:
 	virtual bool has_unit_normals() const{ return false; }
 
 	virtual void update(int n_threads, double quality);
+	virtual bool sample_grid(double, DI_Grid &, bool &) const{ return false; } // has its own update
 };
@@ -45,7 +45,7 @@ void GL_ImplicitLineGraph::update(int n_threads, double quality)
 	
 	if (graph.type() != R2_R) return;
 
-	DI_Calc ic(graph);
+	DI_Calc ic(graph, quality);
 	if (!ic.e0 || ic.dim != 1) return;
 	
 	DI_Axis ia(graph, true, false);
@@ -3,6 +3,7 @@
 #include "../Threading/ThreadMap.h"
 #include "VisibilityFlags.h"
 #include "../../Utility/Preferences.h"
+#include "../OpenGL/GL_Export.h"
 #include <GL/gl.h>
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -140,7 +141,7 @@ void GL_LineGraph::update(int n_threads, double quality)
 
 	if (graph.plotvars().size() != 1) return;
 
-	DI_Calc ic(graph);
+	DI_Calc ic(graph, quality);
 	if (!ic.e0 || ic.dim <= 0 || ic.dim > 3) return;
 	
 	bool circle = false, parametric = false;
@@ -158,6 +159,7 @@ void GL_LineGraph::update(int n_threads, double quality)
 	DI_Axis ia(graph, !parametric, circle);
 	if (ia.pixel <= 0.0) return;
 	if (ia.is2D) ic.embed_XZ = false;
+	ic.choose_precision(ia);
 	
 	DI_Subdivision is;
 	is.max_lenq    = sqr(  5.0 * ia.pixel / ia.range[0]);
@@ -373,3 +375,9 @@ void GL_LineGraph::draw(GL_RM &) const
 
 	finish_drawing();
 }
+
+void GL_LineGraph::export_geometry(GL_Export &e) const
+{
+	e.add(lines);
+	e.add(dots);
+}
@@ -11,6 +11,7 @@ public:
 	
 	virtual void update(int n_threads, double quality);
 	virtual void draw(GL_RM &rm) const;
+	virtual void export_geometry(GL_Export &e) const;
 
 	virtual Opacity opacity() const;
 	
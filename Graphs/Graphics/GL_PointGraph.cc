@@ -5,9 +5,11 @@
 #include "../Threading/ThreadMap.h"
 #include "../Geometry/RecursiveGrid.h"
 #include "../OpenGL/GL_Util.h"
+#include "../OpenGL/GL_Export.h"
 
 #include <vector>
 #include <algorithm>
+#include <unordered_set>
 
 #define VF_SUB 8
 
@@ -141,98 +143,182 @@ static void gridBuilder(ThreadInfo &ti, int i1, int i2, GraphPoint *vs, size_t &
 // Subdivision
 //----------------------------------------------------------------------------------------------------------------------
 
-struct StreamInfo3D
+/**
+ * Streamlines for VF_Connected.
+ *
+ * Starting from the grid points (outer shells first), every seed follows the field and drops an arrow about every
+ * VF_SUB*0.8 fine grid cells until it runs into a cell that was already visited (by any line, checked on a grid that
+ * is VF_SUB times finer than the point grid).
+ *
+ * The expensive part, integrating along the field, is done for batches of seeds in parallel: each seed is traced
+ * against the occupancy grid of the previous batches plus its own cells. The lines are then replayed against the
+ * real grid in seed order, which can only cut them shorter, so the result is the same as tracing them one by one.
+ * Seeds that the previous batches already covered are dropped before their batch is traced. Batches grow while
+ * few of their lines run into each other and shrink while many do.
+ */
+
+struct StreamSeed
 {
-	StreamInfo3D(const DI_Grid &ig, ThreadInfo &ti, MemoryPool<GraphPoint> &pool, RecursiveGrid_3D &grid, float max_len)
+	int x, y, z; // grid point
+};
+
+struct StreamInfo
+{
+	StreamInfo(const DI_Grid &ig, int dim)
 	: x00(ig.x[0]), x11(ig.x[ig.x.nlines()-1])
 	, y00(ig.y[0]), y11(ig.y[ig.y.nlines()-1])
 	, z00(ig.z[0]), z11(ig.z[ig.z.nlines()-1])
-	, ti(ti)
 	, nnx((ig.x.nlines()-1)*VF_SUB + 1)
 	, nny((ig.y.nlines()-1)*VF_SUB + 1)
 	, nnz((ig.z.nlines()-1)*VF_SUB + 1)
-	, pool(pool)
-	, grid(grid)
+	, dim(dim)
+	, scale(0.0), tol(0.0)
+	{
+		cell = std::min((x11-x00)/nnx, (y11-y00)/nny);
+		if (dim == 3) cell = std::min(cell, (z11-z00)/nnz);
+	}
+
+	void set_scale(float max_len)
 	{
-		scale = std::min((x11-x00)/nnx, std::min((y11-y00)/nny, (z11-z00)/nnz)) * VF_SUB*0.8 / max_len;
+		scale = cell * VF_SUB*0.8 / max_len;
+		tol   = cell * 0.01;
+	}
+
+	inline void index(const P3d &x, int &i, int &j, int &k) const
+	{
+		i = (int)((x.x - x00) / (x11-x00) * (nnx-1));
+		j = (int)((x.y - y00) / (y11-y00) * (nny-1));
+		k = (dim == 3 ? (int)((x.z - z00) / (z11-z00) * (nnz-1)) : 0);
 	}
 
 	double x00, x11, y00, y11, z00, z11;
-	double scale;
-	int    nnx, nny, nnz;
-	ThreadInfo &ti;
-	MemoryPool<GraphPoint> &pool;
-	RecursiveGrid_3D &grid;
+	int    nnx, nny, nnz, dim;
+	double cell;  // size of the smallest fine grid cell
+	double scale; // integration time between two arrows
+	double tol;   // error tolerance for a single step
 };
-struct StreamInfo2D
+
+/**
+ * Moves p along the field for si.scale, using an embedded Runge-Kutta 4(5) method (Cash-Karp) with adaptive step size.
+ * @param h Step size, carried over from the previous call.
+ * @return false if the field is undefined somewhere along the way.
+ */
+static bool advance(GraphPoint &p, const StreamInfo &si, double &h, ThreadInfo &ti)
 {
-	StreamInfo2D(const DI_Grid &ig, ThreadInfo &ti, MemoryPool<GraphPoint> &pool, RecursiveGrid_2D &grid, float max_len)
-	: x00(ig.x[0]), x11(ig.x[ig.x.nlines()-1])
-	, y00(ig.y[0]), y11(ig.y[ig.y.nlines()-1])
-	, ti(ti)
-	, nnx((ig.x.nlines()-1)*VF_SUB + 1)
-	, nny((ig.y.nlines()-1)*VF_SUB + 1)
-	, pool(pool)
-	, grid(grid)
+	static const double
+		b21 = 1.0/5.0,
+		b31 = 3.0/40.0,       b32 = 9.0/40.0,
+		b41 = 3.0/10.0,       b42 = -9.0/10.0,  b43 = 6.0/5.0,
+		b51 = -11.0/54.0,     b52 = 5.0/2.0,    b53 = -70.0/27.0,    b54 = 35.0/27.0,
+		b61 = 1631.0/55296.0, b62 = 175.0/512.0, b63 = 575.0/13824.0, b64 = 44275.0/110592.0, b65 = 253.0/4096.0,
+		c1  = 37.0/378.0, c3 = 250.0/621.0, c4 = 125.0/594.0, c6 = 512.0/1771.0,
+		d1  = c1 - 2825.0/27648.0, d3 = c3 - 18575.0/48384.0, d4 = c4 - 13525.0/55296.0,
+		d5  = -277.0/14336.0,      d6 = c6 - 0.25;
+
+	const double hmin = si.scale * 1e-3;
+	double rest = si.scale;
+	P3d k1 = (P3d)p.v, k2, k3, k4, k5, k6;
+	GraphPoint q;
+
+	while (rest > 0.0)
 	{
-		scale = std::min((x11-x00)/nnx, (y11-y00)/nny) * VF_SUB*0.8 / max_len;
+		double hs = std::min(h, rest);
+		bool ok = true;
+		#define STAGE(k, dx) if (ok){ q.x = p.x + (dx)*hs; q.calc(ti); ok = q.exists; if (ok) k = (P3d)q.v; }
+		STAGE(k2, b21*k1);
+		STAGE(k3, b31*k1 + b32*k2);
+		STAGE(k4, b41*k1 + b42*k2 + b43*k3);
+		STAGE(k5, b51*k1 + b52*k2 + b53*k3 + b54*k4);
+		STAGE(k6, b61*k1 + b62*k2 + b63*k3 + b64*k4 + b65*k5);
+		#undef STAGE
+
+		double err = ok ? ((d1*k1 + d3*k3 + d4*k4 + d5*k5 + d6*k6) * hs).abs() : INFINITY;
+		if (err > si.tol && hs > hmin)
+		{
+			h = std::max(hmin, hs * (ok ? std::max(0.1, 0.9*pow(si.tol/err, 0.25)) : 0.25));
+			continue;
+		}
+		if (!ok) return false;
+
+		p.x += (c1*k1 + c3*k3 + c4*k4 + c6*k6) * hs;
+		p.calc(ti);
+		if (!p.exists) return false;
+		k1 = (P3d)p.v;
+		rest -= hs;
+
+		if (hs == h) h *= (err > 0.0 ? std::min(4.0, 0.9*pow(si.tol/err, 0.2)) : 4.0);
 	}
-	
-	double x00, x11, y00, y11;
-	double scale;
-	int    nnx, nny;
-	ThreadInfo &ti;
-	MemoryPool<GraphPoint> &pool;
-	RecursiveGrid_2D &grid;
+	return true;
+}
+
+/// The occupancy grid of the previous batches plus the cells of the line that is being traced.
+struct TraceGrid2D
+{
+	TraceGrid2D(const RecursiveGrid_2D &base, size_t nx) : base(base), nx(nx){ }
+
+	void set(size_t x, size_t y){ own.insert(y*nx + x); }
+	bool get(size_t x, size_t y) const{ return base.get(x,y) || own.count(y*nx + x); }
+	bool get_range(size_t x, size_t y, int range) const{ assert(own.empty()); return base.get_range(x,y,range); }
+	bool valid(int x, int y) const{ return base.valid(x,y); }
+
+	const RecursiveGrid_2D    &base;
+	size_t                     nx;
+	std::unordered_set<size_t> own;
 };
+struct TraceGrid3D
+{
+	TraceGrid3D(const RecursiveGrid_3D &base, size_t nx, size_t ny) : base(base), nx(nx), ny(ny){ }
+
+	void set(size_t x, size_t y, size_t z){ own.insert((z*ny + y)*nx + x); }
+	bool get(size_t x, size_t y, size_t z) const{ return base.get(x,y,z) || own.count((z*ny + y)*nx + x); }
+	bool get_range(size_t x, size_t y, size_t z, int range) const{ assert(own.empty()); return base.get_range(x,y,z,range); }
+	bool valid(int x, int y, int z) const{ return base.valid(x,y,z); }
 
-#define SQ 20
+	const RecursiveGrid_3D    &base;
+	size_t                     nx, ny;
+	std::unordered_set<size_t> own;
+};
 
-static inline void stream(int x, int y, int z, GraphPoint p, const StreamInfo3D &si, size_t &nv)
+/**
+ * Follows a line from the seed p at grid cell (x,y,z).
+ * @param next  Moves p to the next point on the line. Returns false if there is none.
+ * @param emit  Called for every point that becomes an arrow.
+ */
+template<class Grid, class Next, class Emit>
+static inline void stream(int x, int y, int z, GraphPoint p, const StreamInfo &si, Grid &grid, Next next, Emit emit)
 {
-	if (!p.exists || si.grid.get_range(x,y,z,VF_SUB/2)) return;
-	//for (int np = 2 + random() % 7; np > 0; --np)
+	if (!p.exists || grid.get_range(x,y,z,VF_SUB/2)) return;
 	while (true)
 	{
-		assert(!si.grid.get(x,y,z));
-		si.grid.set(x,y,z);
-		
-		new(si.pool) GraphPoint(p);
-		++nv;
+		assert(!grid.get(x,y,z));
+		grid.set(x,y,z);
+		emit(p);
 
-		for (int i = 0; i < SQ; ++i)
-		{
-			p.x += (P3d)p.v * si.scale / SQ;
-			p.calc(si.ti);
-			if (!p.exists) return;
-		}
-		
-		x = (int)((p.x.x - si.x00) / (si.x11-si.x00) * (si.nnx-1));
-		y = (int)((p.x.y - si.y00) / (si.y11-si.y00) * (si.nny-1));
-		z = (int)((p.x.z - si.z00) / (si.z11-si.z00) * (si.nnz-1));
-		if (x < 0 || y < 0 || z < 0 || x >= si.nnx || y >= si.nny || z >= si.nnz) break;
-		//if (si.grid.get_range(x, y, z, 2)) break;
-		//if (si.grid.get_range(x, y, z, 1)) break;
-		if (si.grid.get(x, y, z)) break;
+		if (!next(p)) return;
+
+		si.index(p.x, x, y, z);
+		if (!grid.valid(x, y, z)) break;
+		if (grid.get(x, y, z)) break;
 	}
 }
 
-static inline bool move(int &x0, int &y0, int x1, int y1, RecursiveGrid_2D &grid)
+template<class Grid>
+static inline bool move(int &x0, int &y0, int x1, int y1, Grid &grid)
 {
 	if (!grid.valid(x1, y1))
 	{
 		grid.set(x0,y0);
 		return true;
 	}
-	
+
 	bool ret = grid.get(x1,y1);
-	
+
 	int dx = abs(x1-x0);
 	int dy = abs(y1-y0);
 	int sx = (x0 < x1 ? 1 : -1);
 	int sy = (y0 < y1 ? 1 : -1);
 	int err = dx-dy;
-			
+
 	while (true)
 	{
 		grid.set(x0,y0);
@@ -251,159 +337,258 @@ static inline bool move(int &x0, int &y0, int x1, int y1, RecursiveGrid_2D &grid
 			y0 += sy;
 		}
 	}
-	
+
 	return ret;
 }
-static inline void stream(int x, int y, GraphPoint p, const StreamInfo2D &si, size_t &nv)
+template<class Grid, class Next, class Emit>
+static inline void stream(int x, int y, GraphPoint p, const StreamInfo &si, Grid &grid, Next next, Emit emit)
 {
-	if (!p.exists || si.grid.get_range(x,y,VF_SUB/4)) return;
+	if (!p.exists || grid.get_range(x,y,VF_SUB/4)) return;
 	while (true)
 	{
-		si.grid.set(x,y);
-		new(si.pool) GraphPoint(p);
-		++nv;
-		
-		for (int i = 0; i < SQ; ++i)
-		{
-			p.x += (P3d)p.v * si.scale / SQ;
-			p.calc(si.ti);
-			if (!p.exists) return;
-		}
-		
-		if (move(x, y,
-			 (int)((p.x.x - si.x00) / (si.x11-si.x00) * (si.nnx-1)),
-			 (int)((p.x.y - si.y00) / (si.y11-si.y00) * (si.nny-1)),
-			 si.grid)) break;
-		
+		grid.set(x,y);
+		emit(p);
+
+		if (!next(p)) return;
+
+		int x1, y1, z1;
+		si.index(p.x, x1, y1, z1);
+		if (move(x, y, x1, y1, grid)) break;
+
 		if (x < 0 || y < 0 || x >= si.nnx || y >= si.nny) break;
 	}
 }
 
-static void connect(ThreadInfo &ti, GraphPoint *vs, size_t &nvertexes, float &max_len,
-					std::unique_ptr <P3f[]> &pau, std::unique_ptr <P3f[]> &vau)
+struct Streamlines
 {
-	//------------------------------------------------------------------------------------------------------------------
-	// (1) gather info
-	//------------------------------------------------------------------------------------------------------------------
-
-	const DI_Grid &ig = ti.ig;
-	const DI_Calc &ic = ti.ic;
-	
-	int nx = ig.x.nlines();
-	int ny = ig.y.nlines();
-	int nz = ig.z.nlines();
-	int nnx = (nx-1)*VF_SUB + 1;
-	int nny = (ny-1)*VF_SUB + 1;
-	int nnz = (nz-1)*VF_SUB + 1;
-	assert(ic.vector_field);
-		
-	//------------------------------------------------------------------------------------------------------------------
-	// (2) find scale factor from the grid points we already have
-	//------------------------------------------------------------------------------------------------------------------
-	
-	max_len = 0.0f;
-	for (int i = 0; i < nx*ny*nz; ++i)
+	Streamlines(const DI_Grid &ig, int dim, GraphPoint *vs)
+	: si(ig, dim), vs(vs), nx(ig.x.nlines()), ny(ig.y.nlines()), nz(ig.z.nlines()), nv(0)
+	, next_seed(0), rounds(0), batch(1), min_batch(1)
 	{
-		if (!vs[i].exists) continue;
-		float rq = vs[i].v.absq();
-		if (rq > max_len) max_len = rq;
-	}
-	max_len = sqrtf(max_len);
-
-	//------------------------------------------------------------------------------------------------------------------
-	// (3) subdivide
-	//------------------------------------------------------------------------------------------------------------------
-	
-	MemoryPool<GraphPoint> pool;
-	nvertexes = 0;
-
-	if (ic.dim == 3)
-	{
-		RecursiveGrid_3D rg(nnx, nny, nnz, 4);
-		StreamInfo3D info(ig, ti, pool, rg, max_len);
-
-		for (int x0 = 0, x1 = nx-1, y0 = 0, y1 = ny-1, z0 = 0, z1 = nz-1;
-			 x0 <= x1 && y0 <= y1 && z0 <= z1;
-			 ++x0, ++y0, ++z0, --x1, --y1, --z1)
+		#define SEED(x,y,z) seeds.push_back(StreamSeed{x, y, z})
+		if (dim == 3)
 		{
-			#define STREAM(x,y,z) stream(x*VF_SUB, y*VF_SUB, z*VF_SUB, vs[nx*ny*z + nx*y + x], info, nvertexes)
-			
-			for (int y = y0; y <= y1; ++y)
+			for (int x0 = 0, x1 = nx-1, y0 = 0, y1 = ny-1, z0 = 0, z1 = nz-1;
+				 x0 <= x1 && y0 <= y1 && z0 <= z1;
+				 ++x0, ++y0, ++z0, --x1, --y1, --z1)
 			{
-				for (int x = x0; x <= x1; ++x)
+				for (int y = y0; y <= y1; ++y)
 				{
-					STREAM(x, y, z0);
-					if (z1 > z0) STREAM(x, y, z1);
+					for (int x = x0; x <= x1; ++x)
+					{
+						SEED(x, y, z0);
+						if (z1 > z0) SEED(x, y, z1);
+					}
 				}
-			}
 
-			for (int z = z0+1; z < z1; ++z)
+				for (int z = z0+1; z < z1; ++z)
+				{
+					for (int x = x0; x <= x1; ++x)
+					{
+						SEED(x, y0, z);
+						if (y1 > y0) SEED(x, y1, z);
+					}
+				}
+
+				for (int z = z0+1; z < z1; ++z)
+				{
+					for (int y = y0+1; y < y1; ++y)
+					{
+						SEED(x0, y, z);
+						if (x1 > x0) SEED(x1, y, z);
+					}
+				}
+			}
+		}
+		else
+		{
+			for (int x0 = 0, x1 = nx-1, y0 = 0, y1 = ny-1;
+				 x0 <= x1 && y0 <= y1;
+				 ++x0, ++y0, --x1, --y1)
 			{
 				for (int x = x0; x <= x1; ++x)
 				{
-					STREAM(x, y0, z);
-					if (y1 > y0) STREAM(x, y1, z);
+					SEED(x, y0, 0);
+					if (y1 > y0) SEED(x, y1, 0);
 				}
-			}
 
-			for (int z = z0+1; z < z1; ++z)
-			{
 				for (int y = y0+1; y < y1; ++y)
 				{
-					STREAM(x0, y, z);
-					if (x1 > x0) STREAM(x1, y, z);
+					SEED(x0, y, 0);
+					if (x1 > x0) SEED(x1, y, 0);
 				}
 			}
-			
-			#undef STREAM
 		}
+		#undef SEED
 	}
-	else
+
+	/**
+	 * @param n   Number of trace + connect rounds for all seeds, 0 for trace_all.
+	 * @param min Minimal number of seeds per round.
+	 */
+	void set_rounds(int n, size_t min){ rounds = n; batch = min_batch = min; }
+
+	/// Find the scale factor from the grid points we already have
+	void setup()
 	{
-		RecursiveGrid_2D rg(nnx, nny, 4);
-		StreamInfo2D info(ig, ti, pool, rg, max_len);
-		
-		for (int x0 = 0, x1 = nx-1, y0 = 0, y1 = ny-1;
-			 x0 <= x1 && y0 <= y1;
-			 ++x0, ++y0, --x1, --y1)
+		float max_len = 0.0f;
+		for (int i = 0; i < nx*ny*nz; ++i)
 		{
-			#define STREAM(x,y) stream(x*VF_SUB, y*VF_SUB, vs[nx*y + x], info, nvertexes)
-			
-			for (int x = x0; x <= x1; ++x)
-			{
-				STREAM(x, y0);
-				if (y1 > y0) STREAM(x, y1);
-			}
-			
-			for (int y = y0+1; y < y1; ++y)
+			if (!vs[i].exists) continue;
+			float rq = vs[i].v.absq();
+			if (rq > max_len) max_len = rq;
+		}
+		max_len = sqrtf(max_len);
+		if (max_len > 0.0f) si.set_scale(max_len);
+
+		if (si.dim == 3)
+			grid3.reset(new RecursiveGrid_3D(si.nnx, si.nny, si.nnz, 4));
+		else
+			grid2.reset(new RecursiveGrid_2D(si.nnx, si.nny, 4));
+
+		select();
+	}
+
+	/// Single-threaded: trace every seed directly against the real grid
+	void trace_all(ThreadInfo &ti)
+	{
+		if (si.scale <= 0.0) return;
+		for (const StreamSeed &sd : seeds)
+		{
+			double h = si.scale;
+			auto next = [&](GraphPoint &q){ return advance(q, si, h, ti); };
+			auto emit = [this](const GraphPoint &q){ new(pool) GraphPoint(q); ++nv; };
+
+			const GraphPoint &p = vs[nx*ny*sd.z + nx*sd.y + sd.x];
+			if (si.dim == 3)
+				stream(sd.x*VF_SUB, sd.y*VF_SUB, sd.z*VF_SUB, p, si, *grid3, next, emit);
+			else
+				stream(sd.x*VF_SUB, sd.y*VF_SUB, p, si, *grid2, next, emit);
+		}
+	}
+
+	/// Integrate the line from seeds[todo[i]] into lines[i] (runs in parallel for all seeds of a batch)
+	void trace(ThreadInfo &ti, size_t i)
+	{
+		const StreamSeed &sd = seeds[todo[i]];
+		const GraphPoint &p = vs[nx*ny*sd.z + nx*sd.y + sd.x];
+		std::vector<GraphPoint> &dst = lines[i];
+
+		double h = si.scale;
+		auto next = [&](GraphPoint &q)
+		{
+			if (!advance(q, si, h, ti)) return false;
+			dst.push_back(q);
+			return true;
+		};
+		auto emit = [](const GraphPoint &){ };
+
+		if (si.dim == 3)
+		{
+			TraceGrid3D g(*grid3, si.nnx, si.nny);
+			stream(sd.x*VF_SUB, sd.y*VF_SUB, sd.z*VF_SUB, p, si, g, next, emit);
+		}
+		else
+		{
+			TraceGrid2D g(*grid2, si.nnx);
+			stream(sd.x*VF_SUB, sd.y*VF_SUB, p, si, g, next, emit);
+		}
+	}
+
+	/// Replay the traced lines of the current batch in order, mark them on the grid and select the next batch
+	void connect()
+	{
+		size_t traced = 0, nv0 = nv;
+		for (size_t s = 0; s < todo.size(); ++s)
+		{
+			const StreamSeed &sd = seeds[todo[s]];
+			std::vector<GraphPoint> &line = lines[s];
+			traced += line.size() + 1;
+			size_t i = 0;
+			auto next = [&](GraphPoint &q)
 			{
-				STREAM(x0, y);
-				if (x1 > x0) STREAM(x1, y);
-			}
-			
-			#undef STREAM
+				if (i == line.size()) return false;
+				q = line[i++];
+				return true;
+			};
+			auto emit = [this](const GraphPoint &q){ new(pool) GraphPoint(q); ++nv; };
+
+			const GraphPoint &p = vs[nx*ny*sd.z + nx*sd.y + sd.x];
+			if (si.dim == 3)
+				stream(sd.x*VF_SUB, sd.y*VF_SUB, sd.z*VF_SUB, p, si, *grid3, next, emit);
+			else
+				stream(sd.x*VF_SUB, sd.y*VF_SUB, p, si, *grid2, next, emit);
+
+			line.clear();
 		}
+
+		// how much of the tracing was wasted on lines that ran into earlier ones of the same batch?
+		size_t used = nv - nv0;
+		if (10*used < 7*traced)
+			batch = std::max(min_batch, batch/2);
+		else if (20*used > 17*traced)
+			batch *= 2;
+
+		select();
 	}
 
-	//------------------------------------------------------------------------------------------------------------------
-	// (4) transfer
-	//------------------------------------------------------------------------------------------------------------------
+	void transfer(size_t &nvertexes, float &max_len, std::unique_ptr <P3f[]> &pau, std::unique_ptr <P3f[]> &vau)
+	{
+		nvertexes = nv;
+		pau.reset(new P3f[nvertexes]);
+		vau.reset(new P3f[nvertexes]);
+		P3f *pa = pau.get();
+		P3f *va = vau.get();
 
-	pau.reset(new P3f[nvertexes]);
-	vau.reset(new P3f[nvertexes]);
-	P3f *pa = pau.get();
-	P3f *va = vau.get();
-	
-	max_len = 0.0f;
-	for (GraphPoint &gp : pool)
+		max_len = 0.0f;
+		for (GraphPoint &gp : pool)
+		{
+			*pa++ = gp.p;
+			*va++ = gp.v;
+			float rq = gp.v.absq();
+			if (rq > max_len) max_len = rq;
+		}
+		max_len = sqrtf(max_len);
+	}
+
+	StreamInfo                           si;
+	std::vector<StreamSeed>              seeds; // in processing order
+	std::vector<size_t>                  todo;  // seeds of the current batch
+	std::vector<std::vector<GraphPoint>> lines; // traced lines of the current batch (one buffer per todo entry)
+
+private:
+	/// Is the seed's cell already covered? Then stream would not start a line there either.
+	bool covered(const StreamSeed &sd) const
 	{
-		*pa++ = gp.p;
-		*va++ = gp.v;
-		float rq = gp.v.absq();
-		if (rq > max_len) max_len = rq;
+		if (si.dim == 3) return grid3->get_range(sd.x*VF_SUB, sd.y*VF_SUB, sd.z*VF_SUB, VF_SUB/2);
+		return grid2->get_range(sd.x*VF_SUB, sd.y*VF_SUB, VF_SUB/4);
+	}
+
+	/// Next batch: at least batch seeds that are not covered yet, more if the rounds would not be enough
+	void select()
+	{
+		todo.clear();
+		if (rounds <= 0 || si.scale <= 0.0) return;
+		size_t n = seeds.size(), want = std::max(batch, (n - next_seed + rounds - 1) / rounds);
+		if (--rounds == 0) want = n;
+		for (; next_seed < n && todo.size() < want; ++next_seed)
+		{
+			const StreamSeed &sd = seeds[next_seed];
+			if (vs[nx*ny*sd.z + nx*sd.y + sd.x].exists && !covered(sd)) todo.push_back(next_seed);
+		}
+		lines.resize(todo.size());
 	}
-	max_len = sqrtf(max_len);
-}
+
+	GraphPoint                       *vs;
+	int                               nx, ny, nz;
+	std::unique_ptr<RecursiveGrid_2D> grid2;
+	std::unique_ptr<RecursiveGrid_3D> grid3;
+	MemoryPool<GraphPoint>            pool;
+	size_t                            nv;
+	size_t                            next_seed; // first seed that was not selected yet
+	int                               rounds;    // left for select
+	size_t                            batch, min_batch;
+};
 
 //----------------------------------------------------------------------------------------------------------------------
 // drawing helpers
@@ -527,12 +712,52 @@ void GL_PointGraph::update(int nthreads, double /*quality*/)
 	// (3b) allocate and fill the arrays
 	//------------------------------------------------------------------------------------------------------------------
 	
+	std::unique_ptr<Streamlines> sl;
 	if (vf_subdiv)
 	{
-		layer = new WorkLayer("connectionLayer", &task, layer, 1, -1);
-		layer->add_unit([&](void *ti)
+		// more seeds per batch keep more threads busy, but get traced further than needed more often
+		const int units = 4*nthreads;
+		sl.reset(new Streamlines(ig, ic.dim, vs));
+		Streamlines &S = *sl;
+		const int rounds = (nthreads > 1 ? (int)std::min<size_t>(256, (S.seeds.size() + units-1) / units) : 0);
+		S.set_rounds(rounds, units);
+
+		layer = new WorkLayer("streamSetupLayer", &task, layer, 1, -1);
+		layer->add_unit([&S](void *)
+		{
+			S.setup();
+		});
+
+		if (!rounds)
+		{
+			layer = new WorkLayer("traceLayer", &task, layer, 1, -1);
+			layer->add_unit([&S](void *ti)
+			{
+				S.trace_all(*(ThreadInfo*)ti);
+			});
+		}
+		for (int r = 0; r < rounds; ++r)
+		{
+			layer = new WorkLayer("traceLayer", &task, layer, 0, -1);
+			for (int u = 0; u < units; ++u)
+			{
+				layer->add_unit([&S,u,units](void *ti)
+				{
+					for (size_t i = u; i < S.todo.size(); i += units) S.trace(*(ThreadInfo*)ti, i);
+				});
+			}
+
+			layer = new WorkLayer("connectionLayer", &task, layer, 1, -1);
+			layer->add_unit([&S](void *)
+			{
+				S.connect();
+			});
+		}
+
+		layer = new WorkLayer("transferLayer", &task, layer, 1, -1);
+		layer->add_unit([&](void *)
 		{
-			connect(*(ThreadInfo*)ti, vs, nvertexes, max_len, pau, vau);
+			sl->transfer(nvertexes, max_len, pau, vau);
 		});
 	}
 	else
@@ -561,6 +786,18 @@ bool GL_PointGraph::needs_depth_sort() const
 	return graph.plot.options.aa_mode == AA_Lines || !graph.options.line_color.opaque();
 }
 
+bool GL_PointGraph::vector_scale(float &f, bool &unit) const
+{
+	switch (graph.options.vf_mode)
+	{
+		case VF_Unscaled:   f = 1.0f;                     unit = false; return true;
+		case VF_Normalized: f = gridsize*0.9f  / max_len; unit = false; return true;
+		case VF_Connected:  f = gridsize*0.75f / max_len; unit = false; return true;
+		case VF_Unit:       f = gridsize*0.75f;           unit = true;  return true;
+		default: assert(false); return false;
+	}
+}
+
 void GL_PointGraph::draw(GL_RM &/*rm*/) const
 {
 	start_drawing();
@@ -579,15 +816,7 @@ void GL_PointGraph::draw(GL_RM &/*rm*/) const
 		float tip = float(15.0*graph.plot.pixel_size()/graph.plot.axis.range(0));
 		float f;
 		bool unit;
-		
-		switch (graph.options.vf_mode)
-		{
-			case VF_Unscaled:   f = 1.0f;                     unit = false; break;
-			case VF_Normalized: f = gridsize*0.9f  / max_len; unit = false; break;
-			case VF_Connected:  f = gridsize*0.75f / max_len; unit = false; break;
-			case VF_Unit:       f = gridsize*0.75f;           unit = true;  break;
-			default: assert(false); return;
-		}
+		if (!vector_scale(f, unit)) return;
 
 		glLineWidth(1.0f);
 
@@ -627,6 +856,28 @@ void GL_PointGraph::draw(GL_RM &/*rm*/) const
 	finish_drawing();
 }
 
+void GL_PointGraph::export_geometry(GL_Export &e) const
+{
+	if (!nvertexes) return;
+	if (!graph.isVectorField())
+	{
+		e.add_dots(pau.get(), nvertexes);
+		return;
+	}
+
+	float f;
+	bool unit;
+	if (!vector_scale(f, unit)) return;
+	if (!unit)
+	{
+		e.add_vectors(pau.get(), vau.get(), f, nvertexes);
+		return;
+	}
+	std::vector<P3f> v(vau.get(), vau.get() + nvertexes);
+	for (P3f &x : v) x.to_unit();
+	e.add_vectors(pau.get(), v.data(), f, nvertexes);
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 // Depth sorting
 //----------------------------------------------------------------------------------------------------------------------
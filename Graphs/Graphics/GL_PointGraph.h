@@ -14,6 +14,7 @@ public:
 	
 	virtual void update(int n_threads, double quality);
 	virtual void draw(GL_RM &rm) const;
+	virtual void export_geometry(GL_Export &e) const;
 
 	virtual Opacity opacity() const;
 
@@ -28,6 +29,8 @@ protected:
 	size_t nvertexes;
 	
 private:
+	bool vector_scale(float &f, bool &unit) const; // how draw scales vau
+
 	float  max_len;  // for scaling vector fields (as is gridsize)
 	float  gridsize; // distance between neighbouring grid points in any direction and in GL coordinates
 };
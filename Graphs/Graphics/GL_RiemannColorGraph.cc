@@ -7,165 +7,345 @@
 #include "GL_Graph.h"
 #include "../Geometry/Vector.h"
 #include "../OpenGL/GL_Image.h"
+#include "../OpenGL/GL_Export.h"
+#include "../../Utility/Preferences.h"
 
 #include <vector>
+#include <map>
+#include <unordered_map>
 #include <algorithm>
 
 //----------------------------------------------------------------------------------------------------------------------
-// update worker: fill in one subdivided triangle
+// geodesic grid: the icosahedron with every edge subdivided into k pieces
 //----------------------------------------------------------------------------------------------------------------------
 
-static void update(ThreadInfo &ti, int data_index, GL_Mesh &m, double th, const P3d &A, const P3d &B, const P3d &C, int k, TextureProjection tp, size_t &skipped_faces)
+#define P 1.61803398874989484820458683437 /* = φ = 1+√5 / 2 */
+static const P3d V[12] =
 {
-	#ifdef DEBUG
-	double l1 = (A-B).abs(), l2 = (B-C).abs(), l3 = (C-A).abs();
-	assert(fabs(l1-l2) < 1e-8 && fabs(l1-l3) < 1e-8);
-	#endif
-	
-	const DI_Calc &ic = ti.ic;
-	BoundContext  &ec = ti.ec;
+	{-1.0, 0.0,  P }, {1.0, 0.0,   P }, {-1.0,  0.0,  -P }, {1.0,  0.0,  -P },
+	{ 0.0,  P , 1.0}, {0.0,  P , -1.0}, { 0.0,  -P ,  1.0}, {0.0,  -P , -1.0},
+	{  P , 1.0, 0.0}, {-P , 1.0,  0.0}, {  P , -1.0,  0.0}, {-P , -1.0,  0.0}
+};
+#undef P
+static const int F[20][3] =
+{
+	{ 0, 4, 1}, { 0, 9, 4}, { 9, 5, 4}, { 4, 5, 8}, { 4, 8, 1},
+	{ 8,10, 1}, { 8, 3,10}, { 5, 3, 8}, { 5, 2, 3}, { 2, 7, 3},
+	{ 7,10, 3}, { 7, 6,10}, { 7,11, 6}, {11, 0, 6}, { 0, 1, 6},
+	{ 6, 1,10}, { 9, 0,11}, { 9,11, 2}, { 9, 2, 5}, { 7, 2,11}
+};
 
-	// k = number of subdivisions of each side
+/**
+ * Places the 10k^2+2 points of the grid (on the unit sphere) into m and sets idx[f*nv + i] to the index of
+ * point i of face f, where nv = (k+1)(k+2)/2 and the points of every face are numbered like this:
+ *
+ *   A = 0
+ *       | \
+ *       1--2
+ *       | \| \
+ *   B = 3--4--5 = C
+ *
+ * Corners come first, then the k-1 inner points of every edge, then the inner points of every face.
+ */
+static void build_grid(int k, GL_Mesh &m, std::vector<GLuint> &idx)
+{
 	assert(k >= 1);
 	const size_t nv = (size_t)(k+1)*(k+2)/2;
-	
-	P3f    *v = m.points () + nv * data_index;
-	P3f    *n = m.normals() + nv * data_index;
-	P2f    *t = m.texture() + nv * data_index;
-	
-	std::unique_ptr<bool[]> def0(new bool[nv]);
-	bool *def = def0.get();
-	
-	/* A = 0
-	       | \
-	       1--2
-	       | \| \
-	   B = 3--4--5 = C */
-	
-	P3f a = (P3f)(A/k), b = (P3f)(B/k), c = (P3f)(C/k);
-	
-	// (1) calculate the grid points
+	const size_t n  = (size_t)10*k*k + 2;
+	const GLuint ne = (GLuint)(k-1), ni = (GLuint)(k-1)*(k-2)/2;
+	idx.resize(20*nv);
 
-	for (int i = 0; i <= k; ++i) // top to bottom
+	P3f *v = m.points();
+	std::vector<bool> placed(n, false);
+	for (int c = 0; c < 12; ++c){ v[c] = (P3f)V[c]; v[c].to_unit(); placed[c] = true; }
+
+	std::map<std::pair<int,int>, GLuint> edges;
+	auto edge = [&](int P, int Q, int t) -> GLuint // point t of k on the edge from corner P to Q
 	{
-		for (int j = 0; j <= i; ++j, ++t, ++v, ++n) // left to right
+		auto e = edges.emplace(std::make_pair(std::min(P,Q), std::max(P,Q)), (GLuint)edges.size()).first;
+		return 12 + e->second*ne + (GLuint)(P < Q ? t : k-t) - 1;
+	};
+
+	GLuint *I = idx.data();
+	for (int f = 0; f < 20; ++f)
+	{
+		const int A = F[f][0], B = F[f][1], C = F[f][2];
+		P3f a = (P3f)(V[A]/k), b = (P3f)(V[B]/k), c = (P3f)(V[C]/k);
+		GLuint inner = 12 + 30*ne + f*ni;
+
+		for (int i = 0; i <= k; ++i) // top to bottom
 		{
-			//P3d P = A + ((double)i / k)*(B-A) + ((double)j / k)*(C-B);
-			*v = a*float(k-i) + b*float(i-j) + c*float(j);
-			v->to_unit();
+			for (int j = 0; j <= i; ++j, ++I) // left to right
+			{
+				GLuint g;
+				if      (i == 0)           g = A;
+				else if (i == k && j == 0) g = B;
+				else if (i == k && j == k) g = C;
+				else if (j == 0)           g = edge(A, B, i);
+				else if (i == k)           g = edge(B, C, j);
+				else if (j == i)           g = edge(A, C, i);
+				else                       g = inner++;
+
+				*I = g;
+				if (placed[g]) continue;
+				placed[g] = true;
+				v[g] = a*float(k-i) + b*float(i-j) + c*float(j);
+				v[g].to_unit();
+			}
+		}
+	}
+	assert(k == 1 || edges.size() == 30);
+	assert(std::find(placed.begin(), placed.end(), false) == placed.end());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// update workers: calculate grid points g0 to g1-1, build the faces of one subdivided triangle
+//----------------------------------------------------------------------------------------------------------------------
+
+// texture coordinates for the point v on the unit sphere, false if the function is undefined there
+static bool tex_coords(ThreadInfo &ti, const P3f &v, double th, TextureProjection tp, P2f &t)
+{
+	const DI_Calc &ic = ti.ic;
+	BoundContext  &ec = ti.ec;
+
+	cnum z; riemann(v, z);
+	if (ic.xi >= 0) ec.set_input(ic.xi, z);
+	ec.eval();
+	z = ec.output(0);
+	if (!defined(z)) return false;
+
+	switch (tp)
+	{
+		case TP_Repeat:
+		{
+			double x =  z.real();
+			double y = -z.imag() / th;
+			t.x = (float)x*2.0f;
+			t.y = (float)y*2.0f;
+			break;
+		}
+		
+		default:
+		case TP_Center:
+		{
+			double x =  z.real();
+			double y = -z.imag() / th;
+			if (abs(x) <= 1.0 && abs(y) <= 1.0)
+			{
+				t.x = (float)(0.5*x+0.5);
+				t.y = (float)(0.5*y+0.5);
+			}
+			else
+			{
+				return false;
+			}
+			break;
+		}
 			
-			*n = *v;
+		case TP_Riemann:
+		{
+			/***********************************************************************************************
+			 (1) project z onto riemann sphere:
+			 l = 2 / (|z|² + 1)
+			 q.x = l * rez
+			 q.y = l * imz
+			 q.z = l - 1
+			 
+			 (2) find the (spherical) distance from the north pole to q, normalize to [0,1]
+			 d = arccos(q.z) / π
+			 
+			 (3) find the texture coords on a unit disk
+			 z *= d / |z|
+			 
+			 (4) project onto texture space [0,2] x [0, 2], flipping y:
+			     w < h, th > 1: onto [0,2]x[1-1/th,1+1/th] by (1+x, 1-y/th)
+			     w > h, th < 1: onto [1-th,1+th]x[0,2] by (1+x*th, 1-y)
+			 **********************************************************************************************/
+			double tr = M_1_PI * 0.5 * 0.99999;
+			double fx = std::min(1.0, th), fy = std::min(1.0, 1.0/th);
+			double r = abs(z);
+			if (r > 0.0)
+			{
+				double f = tr * acos(2.0 / (r*r + 1.0) - 1.0) / r;
+				t.x = (float)(0.5 + f*z.real()*fx);
+				t.y = (float)(0.5 - f*z.imag()*fy);
+			}
+			else
+			{
+				t.x = 0.5f;
+				t.y = 0.5f;
+			}
+			break;
+		}
 			
-			cnum z; riemann(*v, z);
+		case TP_UV:
+		{
+			/***********************************************************************************************
+			 (1) project z onto riemann sphere:
+			 l = 2 / (|z|² + 1)
+			 q.x = l * rez
+			 q.y = l * imz
+			 q.z = l - 1;
+			 
+			 (2) find its spherical coordinates when N = 0, S = ∞
+			 phi   = arccos(q.z)     in [ 0, π]
+			 theta = arctan(q.y/q.x) in [-π, π]
+			 
+			 (3) map range to texture range
+			 x = theta/2π
+			 y = phi/π
+			 **********************************************************************************************/
 			
-			*v *= 0.999f;
+			double phi   = acos(2.0 / (absq(z) + 1.0) - 1.0) / M_PI;
+			double theta = atan2(z.imag(), z.real()) / M_PI + 1.0;
 			
-			if (ic.xi >= 0) ec.set_input(ic.xi, z);
-			ec.eval();
-			z = ec.output(0);
-			if ((*def++ = defined(z)))
-			{
-				switch (tp)
-				{
-					case TP_Repeat:
-					{
-						double x =  z.real();
-						double y = -z.imag() / th;
-						t->x = (float)x*2.0f;
-						t->y = (float)y*2.0f;
-						break;
-					}
-					
-					default:
-					case TP_Center:
-					{
-						double x =  z.real();
-						double y = -z.imag() / th;
-						if (abs(x) <= 1.0 && abs(y) <= 1.0)
-						{
-							t->x = (float)(0.5*x+0.5);
-							t->y = (float)(0.5*y+0.5);
-						}
-						else
-						{
-							def[-1] = false; // TODO
-						}
-						break;
-					}
-						
-					case TP_Riemann:
-					{
-						/***********************************************************************************************
-						 (1) project z onto riemann sphere:
-						 l = 2 / (|z|² + 1)
-						 q.x = l * rez
-						 q.y = l * imz
-						 q.z = l - 1
-						 
-						 (2) find the (spherical) distance from the north pole to q, normalize to [0,1]
-						 d = arccos(q.z) / π
-						 
-						 (3) find the texture coords on a unit disk
-						 z *= d / |z|
-						 
-						 (4) project onto texture space [0,2] x [0, 2], flipping y:
-						     w < h, th > 1: onto [0,2]x[1-1/th,1+1/th] by (1+x, 1-y/th)
-						     w > h, th < 1: onto [1-th,1+th]x[0,2] by (1+x*th, 1-y)
-						 **********************************************************************************************/
-						double tr = M_1_PI * 0.5 * 0.99999;
-						double fx = std::min(1.0, th), fy = std::min(1.0, 1.0/th);
-						double r = abs(z);
-						if (r > 0.0)
-						{
-							double f = tr * acos(2.0 / (r*r + 1.0) - 1.0) / r;
-							t->x = (float)(0.5 + f*z.real()*fx);
-							t->y = (float)(0.5 - f*z.imag()*fy);
-						}
-						else
-						{
-							t->x = 0.5f;
-							t->y = 0.5f;
-						}
-						break;
-					}
-						
-					case TP_UV:
-					{
-						/***********************************************************************************************
-						 (1) project z onto riemann sphere:
-						 l = 2 / (|z|² + 1)
-						 q.x = l * rez
-						 q.y = l * imz
-						 q.z = l - 1;
-						 
-						 (2) find its spherical coordinates when N = 0, S = ∞
-						 phi   = arccos(q.z)     in [ 0, π]
-						 theta = arctan(q.y/q.x) in [-π, π]
-						 
-						 (3) map range to texture range
-						 x = theta/2π
-						 y = phi/π
-						 **********************************************************************************************/
-						
-						double phi   = acos(2.0 / (absq(z) + 1.0) - 1.0) / M_PI;
-						double theta = atan2(z.imag(), z.real()) / M_PI + 1.0;
-						
-						t->x = (float)(theta * 0.5);
-						t->y = (float)(phi);
-						break;
-					}
-				}
-			}
+			t.x = (float)(theta * 0.5);
+			t.y = (float)(phi);
+			break;
 		}
 	}
+	return true;
+}
+
+static void calc(ThreadInfo &ti, GL_Mesh &m, size_t g0, size_t g1, double th, TextureProjection tp, bool *def)
+{
+	P3f *v = m.points () + g0;
+	P3f *n = m.normals() + g0;
+	P2f *t = m.texture() + g0;
+	def += g0;
+
+	for (size_t g = g0; g < g1; ++g, ++t, ++v, ++n)
+	{
+		*n = *v;
+		*def++ = tex_coords(ti, *v, th, tp, *t);
+		*v *= 0.999f;
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// edge supersampling: GL interpolates the texture coordinates linearly over every face, so faces whose corners have
+// very different colors (or whose texture coordinates jump, at poles and seams) are split into four, once for 4x
+// and twice for 8x. The new points lie on the edges of the faces they split, so there are no cracks next to faces
+// that are not split, but their texture coordinates come from their direction on the sphere. Faces on the border
+// of undefined regions are split too, which smooths the outline of holes.
+//----------------------------------------------------------------------------------------------------------------------
+
+#define EDGE_THRESHOLD 32 // max difference in any color channel for non-edges, as in GL_ColorGraph
+#define MAX_SPAN 0.25f    // max texture coordinate difference for non-edges
+
+static inline bool differs(uint32_t a, uint32_t b)
+{
+	for (int k = 0; k < 32; k += 8)
+	{
+		if (abs((int)((a >> k) & 0xFF) - (int)((b >> k) & 0xFF)) > EDGE_THRESHOLD) return true;
+	}
+	return false;
+}
+
+struct Refinement
+{
+	// shared by all units
+	int levels;                 // how often faces can be split
+	double th;
+	TextureProjection tp;
+	const uint32_t *tex;        // level 0 of the texture
+	unsigned tex_w, tex_h;
+	bool wrap;
+	GLuint base;                // number of grid points, indexes >= base are into p, n, t and def
+	const P3f *gp;
+	const P2f *gt;
+	const bool *gdef;
+
+	// for one face of the icosahedron
+	std::vector<P3f>    p, n;
+	std::vector<P2f>    t;
+	std::vector<bool>   def;
+	std::vector<GLuint> f;      // faces of the split triangles
+	std::unordered_map<uint64_t, GLuint> mid; // edge --> its midpoint
+	size_t offset;              // of p in the mesh, set after the update
+
+	const P3f &point  (GLuint i) const{ return i < base ? gp[i] : p[i-base]; }
+	const P2f &texture(GLuint i) const{ return i < base ? gt[i] : t[i-base]; }
+	bool       defined(GLuint i) const{ return i < base ? gdef[i] : def[i-base]; }
 	
+	uint32_t color(GLuint i) const
+	{
+		const P2f &c = texture(i);
+		float x = c.x, y = c.y;
+		if (wrap){ x -= floorf(x); y -= floorf(y); }
+		unsigned j = (unsigned)std::max(0.0f, std::min(x * tex_w, tex_w - 1.0f));
+		unsigned k = (unsigned)std::max(0.0f, std::min(y * tex_h, tex_h - 1.0f));
+		return tex[(size_t)tex_w * k + j];
+	}
+};
+
+static bool needs_split(const Refinement &r, GLuint a, GLuint b, GLuint c)
+{
+	int nd = r.defined(a) + r.defined(b) + r.defined(c);
+	if (nd < 3) return nd > 0;
 	
-	// (2) build the faces
+	const P2f &ta = r.texture(a), &tb = r.texture(b), &tc = r.texture(c);
+	float su = std::max(ta.x, std::max(tb.x, tc.x)) - std::min(ta.x, std::min(tb.x, tc.x));
+	float sv = std::max(ta.y, std::max(tb.y, tc.y)) - std::min(ta.y, std::min(tb.y, tc.y));
+	if (!(su <= MAX_SPAN && sv <= MAX_SPAN)) return true;
 	
-	def = def0.get();
-	GLuint *f = m.faces  () + (size_t)k*k * data_index * 3;
+	uint32_t ca = r.color(a), cb = r.color(b), cc = r.color(c);
+	return differs(ca, cb) || differs(cb, cc) || differs(ca, cc);
+}
+
+static GLuint midpoint(ThreadInfo &ti, Refinement &r, GLuint a, GLuint b)
+{
+	uint64_t key = a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a;
+	auto m = r.mid.find(key);
+	if (m != r.mid.end()) return m->second;
+	
+	P3f q = (r.point(a) + r.point(b)) * 0.5f, d = q; d.to_unit();
+	P2f t;
+	bool def = tex_coords(ti, d, r.th, r.tp, t);
+	
+	GLuint i = r.base + (GLuint)r.p.size();
+	r.p.push_back(q);
+	r.n.push_back(d);
+	r.t.push_back(t);
+	r.def.push_back(def);
+	r.mid[key] = i;
+	return i;
+}
+
+static void split(ThreadInfo &ti, Refinement &r, GLuint a, GLuint b, GLuint c, int level)
+{
+	if (level == r.levels || !needs_split(r, a, b, c))
+	{
+		if (!r.defined(a) || !r.defined(b) || !r.defined(c)) return;
+		r.f.push_back(a); r.f.push_back(b); r.f.push_back(c);
+		return;
+	}
+	GLuint ab = midpoint(ti, r, a, b), bc = midpoint(ti, r, b, c), ca = midpoint(ti, r, c, a);
+	split(ti, r, a,  ab, ca, level+1);
+	split(ti, r, ab, b,  bc, level+1);
+	split(ti, r, ca, bc, c,  level+1);
+	split(ti, r, ab, bc, ca, level+1);
+}
+
+static void faces(ThreadInfo &ti, GL_Mesh &m, int data_index, int k, const GLuint *idx, const bool *def,
+				  size_t &skipped_faces, Refinement *r)
+{
+	const size_t nv = (size_t)(k+1)*(k+2)/2;
+	idx += nv * data_index;
+
+	GLuint *f = m.faces() + (size_t)k*k * data_index * 3;
 	skipped_faces = (size_t)k*k;
 	
+	auto face = [&](GLuint a, GLuint b, GLuint c)
+	{
+		if (r && needs_split(*r, a, b, c)){ split(ti, *r, a, b, c, 0); return; }
+		if (!def[a] || !def[b] || !def[c]) return;
+		*f++ = a;
+		*f++ = b;
+		*f++ = c;
+		--skipped_faces;
+	};
+	
 	/* 0           i = 0
 	   | \
 	   1--2        i = 1
@@ -176,30 +356,13 @@ static void update(ThreadInfo &ti, int data_index, GL_Mesh &m, double th, const
 	
 	for (int i = 1; i <= k; ++i) // top to bottom
 	{
-		GLuint q0 = i*(i-1)/2; // index of first vertex on row i-1
-		GLuint q1 = i*(i+1)/2; // index of first vertex on row i
-		GLuint p0 = i*(i-1)/2 + (GLuint)(nv * data_index); // index of first vertex on row i-1
-		GLuint p1 = i*(i+1)/2 + (GLuint)(nv * data_index); // index of first vertex on row i
+		const GLuint *p0 = idx + i*(i-1)/2; // first vertex on row i-1
+		const GLuint *p1 = idx + i*(i+1)/2; // first vertex on row i
 		
 		for (int j = 0; j < i; ++j) // left to right
 		{
-			if (def[q0+j] && def[q1+j+1])
-			{
-				if (def[q1+j])
-				{
-					*f++ = p0+j;
-					*f++ = p1+j+1;
-					*f++ = p1+j;
-					--skipped_faces;
-				}
-				if (j < i-1 && def[q1+j+1])
-				{
-					*f++ = p0+j;
-					*f++ = p0+j+1;
-					*f++ = p1+j+1;
-					--skipped_faces;
-				}
-			}
+			face(p0[j], p1[j+1], p1[j]);
+			if (j < i-1) face(p0[j], p0[j+1], p1[j+1]);
 		}
 	}
 }
@@ -217,7 +380,7 @@ void GL_RiemannColorGraph::update(int nthreads, double quality)
 	assert(graph.type() == C_C);
 	assert(graph.isColor());
 
-	DI_Calc ic(graph);
+	DI_Calc ic(graph, quality);
 	if (!ic.e0 || ic.dim <= 0 || ic.dim != 1 || graph.options.texture.empty())
 	{
 		mesh.clear();
@@ -242,49 +405,97 @@ void GL_RiemannColorGraph::update(int nthreads, double quality)
 	// (2) calculation
 	//------------------------------------------------------------------------------------------------------------------
 
-	#define P 1.61803398874989484820458683437 /* = φ = 1+√5 / 2 */
-	static P3d V[12] =
-	{
-		{-1.0, 0.0,  P }, {1.0, 0.0,   P }, {-1.0,  0.0,  -P }, {1.0,  0.0,  -P },
-		{ 0.0,  P , 1.0}, {0.0,  P , -1.0}, { 0.0,  -P ,  1.0}, {0.0,  -P , -1.0},
-		{  P , 1.0, 0.0}, {-P , 1.0,  0.0}, {  P , -1.0,  0.0}, {-P , -1.0,  0.0}
-	};
-	#undef P
-	static int F[20][3] =
-	{
-		{ 0, 4, 1}, { 0, 9, 4}, { 9, 5, 4}, { 4, 5, 8}, { 4, 8, 1},
-		{ 8,10, 1}, { 8, 3,10}, { 5, 3, 8}, { 5, 2, 3}, { 2, 7, 3},
-		{ 7,10, 3}, { 7, 6,10}, { 7,11, 6}, {11, 0, 6}, { 0, 1, 6},
-		{ 6, 1,10}, { 9, 0,11}, { 9,11, 2}, { 9, 2, 5}, { 7, 2,11}
-	};
-	
 	double q0 = graph.options.quality;
 	const size_t max_faces = (size_t)(quality*q0*1e6)+20;
 	// we start with an icosahedron that has 20 faces. Each edge can be subdivided into k pieces, which
 	// gives k^2 subtriangles. So we want 20*k^2 <= max_faces.
 	const int k = std::max(1, (int)floor(sqrt(max_faces/20.0)));
 	
-	// So we will have k^2 triangles on (k+1)(k+2)/2 vertices in each face.
-	// For vertex normals we pack them tightly, for face normals we would need 3*k^2 vertices ((5k^2-3k-2)/2 more).
+	// So we will have 20k^2 triangles on 10k^2+2 vertices (every vertex is shared by all faces that touch it).
 	
-	size_t nvertexes = (size_t)(k+1)*(k+2)*10;
+	size_t nvertexes = (size_t)k*k*10 + 2;
 	size_t nfaces    = (size_t)k*k*20;
 	mesh.resize(nvertexes, nfaces, GL_Mesh::NormalMode::Vertex, true);
 	std::vector<size_t> skipped_faces(20, 0);
+
+	std::vector<GLuint> idx;
+	build_grid(k, mesh, idx);
+	std::unique_ptr<bool[]> def(new bool[nvertexes]);
 	
 	double th = (double)graph.options.texture.h() / graph.options.texture.w();
+	TextureProjection tp = graph.options.texture_projection;
 	
 	Task task(&info);
 	WorkLayer *layer = new WorkLayer("calculate", &task, NULL);
+	size_t chunk = std::max((size_t)64, (nvertexes + 2*nthreads-1) / (2*nthreads));
+	for (size_t g0 = 0; g0 < nvertexes; g0 += chunk)
+	{
+		size_t g1 = std::min(g0 + chunk, nvertexes);
+		layer->add_unit([=,&def](void *ti)
+		{
+			calc(*(ThreadInfo*)ti, mesh, g0, g1, th, tp, def.get());
+		});
+	}
+
+	// edge supersampling, not during animation
+	int samples = quality >= 1.0 ? Preferences::colorSamples() : 1;
+	std::vector<Refinement> refinements;
+	if (samples > 1)
+	{
+		const GL_Image &im = graph.options.texture;
+		Refinement r;
+		r.levels = (samples >= 8 ? 2 : 1);
+		r.th     = th;
+		r.tp     = tp;
+		r.tex    = (const uint32_t*)im.data().data();
+		r.tex_w  = im.w();
+		r.tex_h  = im.h();
+		r.wrap   = (tp == TP_Repeat);
+		r.base   = (GLuint)nvertexes;
+		r.gp     = mesh.points();
+		r.gt     = mesh.texture();
+		r.gdef   = def.get();
+		r.offset = 0;
+		refinements.resize(20, r);
+	}
+
+	layer = new WorkLayer("faces", &task, layer, 0, -1);
 	for (int i = 0; i < 20; ++i)
 	{
-		layer->add_unit([=,&skipped_faces](void *ti)
+		Refinement *r = refinements.empty() ? NULL : &refinements[i];
+		layer->add_unit([=,&idx,&def,&skipped_faces](void *ti)
 		{
-			::update(*(ThreadInfo*)ti, i, mesh, th, V[F[i][0]], V[F[i][1]], V[F[i][2]],
-					 k, graph.options.texture_projection, skipped_faces[i]);
+			faces(*(ThreadInfo*)ti, mesh, i, k, idx.data(), def.get(), skipped_faces[i], r);
 		});
 	}
 	task.run(nthreads);
 	
 	mesh.close_gaps(nfaces/20, skipped_faces, NULL);
+	
+	// append the points and faces of the split triangles
+	if (refinements.empty()) return;
+	size_t np = nvertexes, nf0 = mesh.num_faces(), nf = nf0;
+	for (Refinement &r : refinements)
+	{
+		r.offset = np;
+		np += r.p.size();
+		nf += r.f.size() / 3;
+	}
+	if (np == nvertexes && nf == nf0) return;
+	mesh.grow(np, nf);
+	
+	GLuint *f = mesh.faces() + 3*nf0;
+	for (const Refinement &r : refinements)
+	{
+		std::copy(r.p.begin(), r.p.end(), mesh.points () + r.offset);
+		std::copy(r.n.begin(), r.n.end(), mesh.normals() + r.offset);
+		std::copy(r.t.begin(), r.t.end(), mesh.texture() + r.offset);
+		for (GLuint i : r.f) *f++ = (i < r.base ? i : (GLuint)(i - r.base + r.offset));
+	}
+	assert(f == mesh.faces() + 3*nf);
+}
+
+void GL_RiemannColorGraph::export_geometry(GL_Export &e) const
+{
+	e.add(mesh, mesh.texture() ? &graph.options.texture : NULL);
 }
@@ -7,8 +7,10 @@ public:
 	GL_RiemannColorGraph(Graph &graph) : GL_AreaGraph(graph){ }
 	
 	virtual void update(int n_threads, double quality);
+	virtual bool sample_grid(double, DI_Grid &, bool &) const{ return false; } // has its own update
 
 	virtual bool has_unit_normals() const{ return true; }
+	virtual void export_geometry(GL_Export &e) const; // with texture coordinates and the texture
 
 private:
 	void update(int n_threads, std::vector<void *> &info);
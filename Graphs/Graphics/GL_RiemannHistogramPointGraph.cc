@@ -72,7 +72,7 @@ void GL_RiemannHistogramPointGraph::update(int nthreads, double quality)
 	assert(graph.type() == C_C);
 	assert(graph.isHistogram());
 	
-	DI_Calc ic(graph);
+	DI_Calc ic(graph, quality);
 	if (!ic.e0 || ic.dim != 1)
 	{
 		nvertexes = 0;
@@ -1,10 +1,15 @@
 #include "Info.h"
 #include "../Graph.h"
 #include "../../Engine/Namespace/Variable.h"
+#include "../../Utility/Preferences.h"
+#include "../../Engine/Parser/FloatContext.h"
+#include <cfloat>
 
-DI_Calc::DI_Calc(Graph &graph) : embed_XZ(false)
+DI_Calc::DI_Calc(Graph &graph, double quality)
+: profile(NULL), draft(quality < 1.0 && Preferences::draftPrecision()), single(false), jet(0), embed_XZ(false), shared(NULL), shared_stride(0)
 {
 	e0 = graph.evaluator(); if (!e0) return;
+	profile = graph.profile();
 	dim = e0->image_dimension();
 	polar = spherical = false;
 	switch (graph.coords())
@@ -29,6 +34,46 @@ DI_Calc::DI_Calc(Graph &graph) : embed_XZ(false)
 	projection   = graph.mode();
 }
 
+void DI_Calc::choose_precision(const DI_Axis &ia)
+{
+	// Every float operation has a relative error of FLT_EPSILON (1.2e-7), so the inputs and the visible outputs
+	// must be small compared to their range. Allow a hundredth of a pixel for the rounding of a value.
+	// That says nothing about the intermediate values (cancellation, large arguments of sin, ...), so this is part
+	// of the draft tier and never used for the final image.
+	single = false;
+	if (!draft || !e0 || complex || vector_field || implicit || profile) return;
+	
+	const double px = 0.01 * ia.pixel / ia.range[0]; // relative to the axis range
+	auto fine = [px](double a, double b, double r){ return std::max(fabs(a), fabs(b)) * FLT_EPSILON <= px * r; };
+	
+	const int vi[2] = {xi, yi};
+	for (int i = 0; i < 2; ++i)
+	{
+		if (vi[i] >= 0 && !fine(ia.in_min[i], ia.in_max[i], ia.in_range[i])) return;
+	}
+	for (int i = 0; i < (ia.is2D ? 2 : 3); ++i)
+	{
+		if (!fine(ia.min[i], ia.max[i], ia.range[i])) return;
+	}
+	
+	single = FloatContext::supports(*e0);
+}
+
+void DI_Calc::use_derivatives(const Graph &graph)
+{
+	// not while profiling the plain evaluator (shared grids have the derivatives too, @see SharedGrid::jet)
+	if (!e0 || jet || profile) return;
+	Evaluator *e = graph.jet_evaluator();
+	std::vector<const Variable *> pvars = graph.plotvars();
+	if (!e || e->image_dimension() != dim * (1 + (int)pvars.size())) return;
+	
+	e0  = e;
+	jet = dim;
+	xi  = e0->var_index(pvars[0]); // the indexes can differ from the plain evaluator's
+	yi  = pvars.size() > 1 ? e0->var_index(pvars[1]) : -1;
+	zi  = pvars.size() > 2 ? e0->var_index(pvars[2]) : -1;
+}
+
 DI_Axis::DI_Axis(Graph &graph, bool is_graph, bool S1) : S1(S1)
 {
 	const Axis &axis = graph.plot.axis;
@@ -48,6 +93,8 @@ DI_Axis::DI_Axis(Graph &graph, bool is_graph, bool S1) : S1(S1)
 	center[0] += M_PI*1e-6*range[0];
 	center[1] -= M_E*1e-7*range[1];
 	center[2] += 1e-8*range[2];
+	center_lo[0] = axis.center_lo(0) + (axis.center(0) - center[0]) + M_PI*1e-6*range[0];
+	center_lo[1] = axis.center_lo(1) + (axis.center(1) - center[1]) - M_E*1e-7*range[1];
 	
 	for (int i = 0; i < 3; ++i)
 	{
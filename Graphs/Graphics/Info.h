@@ -15,6 +15,7 @@ struct DI_Axis
 	
 	double center[3], range[3], min[3], max[3]; // for 2D-axis <all>[2] = 0, for Riemann: [-1,1] in every dimension
 	double in_center[3], in_range[3], in_min[3], in_max[3]; // for graphs this is copied from min/max
+	double center_lo[2]; // the exact center is center + center_lo (@see DeepZoom)
 	double yh, zh;  // y- and z-range in axis coordinates
 	double pixel;
 	bool   S1;         // in_range is S1 or S1^2
@@ -86,11 +87,22 @@ struct DI_Subdivision
 };
 
 class Graph;
+class EvalProfile;
 struct DI_Calc
 {
-	DI_Calc(Graph &graph);
+	DI_Calc(Graph &graph, double quality = 1.0);
+	
+	/// Sets single for draft quality if the graph is real and float resolves the axis ranges well below a pixel
+	void choose_precision(const DI_Axis &ia);
+	
+	/// Switches e0 to graph's jet evaluator and sets jet if it has one. Call before choose_precision.
+	void use_derivatives(const Graph &graph);
 	
 	Evaluator *e0;         // use bound context instead!
+	EvalProfile *profile;  // NULL unless profiling is on
+	bool draft;            // evaluate with approximate functions (only for quality < 1)
+	bool single;           // evaluate with a FloatContext (@see choose_precision)
+	int  jet;              // if > 0, output jet + k*dim + i is the derivative of output i by plotvar k
 	int     xi, yi, zi;    // variable indexes
 	
 	int  dim;              // output dimensions
@@ -104,6 +116,9 @@ struct DI_Calc
 	bool texture;          // calculate texture coordinates?
 	bool do_grid;
 	GraphMode projection;
+	
+	const cnum *shared;    // precomputed outputs for the grid points or NULL (@see SharedGrid)
+	int  shared_stride;    // outputs of grid point (i,j) are at shared + (i*nx+j)*shared_stride
 };
 
 
@@ -133,6 +148,12 @@ struct DI_Grid
 		inline bool visible(int i) const{ CHK(i); return (!b0 || --i >= 0) && ((i + vis0) % dvis == 0) && (!b1 || i < n); }
 		#undef CHK
 		
+		bool operator==(const Grid &g) const // same grid lines?
+		{
+			return N == g.N && n == g.n && b0 == g.b0 && b1 == g.b1 &&
+			       x0 == g.x0 && dx == g.dx && x00 == g.x00 && x11 == g.x11;
+		}
+
 		double     delta() const{ return dx; }
 		double vis_delta() const{ return dvis*dx; }
 		double first_vis() const{ return operator[](dvis-vis0+(b0 ? 1 : 0)); }
@@ -164,6 +185,8 @@ struct DI_Grid
 	// min_gridlines is for the larger of the x/y ranges only
 	DI_Grid(DI_Axis &a, double density, int min_gridlines, bool is_3d); // min_gridlines must be 0 for point graphs
 	DI_Grid(){} // dummy grid for point, line and image graphs
+	
+	bool operator==(const DI_Grid &g) const{ return x == g.x && y == g.y && z == g.z; }
 
 	Grid x, y, z;
 };
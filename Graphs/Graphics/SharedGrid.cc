@@ -0,0 +1,150 @@
+#include "SharedGrid.h"
+#include "GL_Graph.h"
+#include "../Graph.h"
+#include "../Threading/ThreadMap.h"
+#include "../../Engine/Namespace/Expression.h"
+#include "../../Engine/Namespace/Variable.h"
+#include "../../Engine/Parser/BoundContext.h"
+#include "../../Utility/Preferences.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+// Grouping
+//----------------------------------------------------------------------------------------------------------------------
+
+void SharedGrid::create(const std::vector<Graph*> &graphs, double quality, int n_threads,
+                        std::vector<std::unique_ptr<SharedGrid>> &dst)
+{
+	struct Candidate
+	{
+		Graph    *graph;
+		GL_Graph *gl;
+		DI_Grid   ig;
+		bool      complex, jet, used;
+	};
+	std::vector<Candidate> cs;
+
+	for (Graph *g : graphs)
+	{
+		if (g->options.hidden || !g->needs_update()) continue;
+		GL_Graph *gl = g->gl_graph();
+		if (!gl) continue;
+		Candidate c{g, gl, DI_Grid(), g->type() == C_C, false, false};
+		if (gl->sample_grid(quality, c.ig, c.jet)) cs.push_back(c);
+	}
+
+	for (size_t i = 0; i < cs.size(); ++i)
+	{
+		if (cs[i].used) continue;
+		std::unique_ptr<SharedGrid> sg(new SharedGrid(cs[i].ig, cs[i].complex));
+		for (size_t j = i; j < cs.size(); ++j)
+		{
+			Candidate &c = cs[j];
+			if (c.used || !sg->matches(c.ig, c.complex)) continue;
+			c.used = true;
+			sg->graphs.push_back(c.graph);
+			sg->members.push_back(c.gl);
+			sg->jets.push_back(c.jet);
+		}
+		if (sg->members.size() < 2 || !sg->evaluate(n_threads, quality < 1.0 && Preferences::draftPrecision())) continue;
+
+		for (size_t k = 0; k < sg->members.size(); ++k) sg->members[k]->share(sg.get(), (int)k);
+		dst.push_back(std::move(sg));
+	}
+}
+
+SharedGrid::~SharedGrid()
+{
+	for (GL_Graph *gl : members) gl->share(NULL, 0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Evaluation
+//----------------------------------------------------------------------------------------------------------------------
+
+struct SetupInfo
+{
+	const Evaluator *e;
+	bool             draft;
+};
+static void thread_setup(const void *info_, void *&data)
+{
+	const SetupInfo &info = *(const SetupInfo*)info_;
+	data = new BoundContext(*info.e, info.draft);
+}
+static void thread_finish(void *data)
+{
+	delete (BoundContext*)data;
+}
+
+bool SharedGrid::evaluate(int n_threads, bool draft)
+{
+	std::vector<Expression*> exs;
+	std::vector<std::vector<const Variable*>> vars;
+	std::set<Parameter*> params;
+	for (Graph *g : graphs)
+	{
+		Expression *x = g->expression();
+		if (!x) return false;
+		exs.push_back(x);
+		vars.push_back(g->plotvars());
+		std::set<Parameter*> ps = g->used_parameters();
+		params.insert(ps.begin(), ps.end());
+	}
+
+	std::unique_ptr<Evaluator> e(Expression::fused_evaluator(exs, vars, offsets, jets));
+	if (!e) return false;
+	e->set_parameters(params);
+	nout = e->image_dimension();
+
+	const std::vector<const Variable*> &pvars = vars[0];
+	int xi = (pvars.size() > 0 ? e->var_index(pvars[0]) : -1); // = z for complex functions
+	int yi = (pvars.size() > 1 ? e->var_index(pvars[1]) : -1);
+
+	int nx = ig.x.nlines(), ny = ig.y.nlines();
+	if (nx <= 0 || ny <= 0 || nout <= 0) return false;
+	try
+	{
+		data.reset(new cnum[(size_t)nx * ny * nout]);
+	}
+	catch (const std::bad_alloc &)
+	{
+		return false;
+	}
+
+	SetupInfo info{e.get(), draft};
+	Task task(&info, thread_setup, thread_finish);
+	WorkLayer *layer = new WorkLayer("shared grid", &task, NULL);
+
+	int chunk = (ny+2*n_threads-1) / (2*n_threads);
+	if (chunk < 1) chunk = 1;
+	for (int i1 = 0; i1 < ny; i1 += chunk)
+	{
+		int i2 = std::min(i1 + chunk, ny);
+		layer->add_unit([=](void *ec_)
+		{
+			BoundContext &ec = *(BoundContext*)ec_;
+			for (int i = i1; i < i2; ++i)
+			{
+				double v = ig.y[i];
+				if (!complex && yi >= 0) ec.set_input(yi, v);
+
+				cnum *dst = data.get() + (size_t)i*nx*nout;
+				for (int j = 0; j < nx; ++j, dst += nout)
+				{
+					double u = ig.x[j];
+					if (xi >= 0)
+					{
+						if (complex)
+							ec.set_input(xi, cnum(u, v));
+						else
+							ec.set_input(xi, u);
+					}
+					ec.eval();
+					for (int k = 0; k < nout; ++k) dst[k] = ec.output(k);
+				}
+			}
+		});
+	}
+	task.run(n_threads);
+	return true;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "Info.h"
+#include <vector>
+#include <memory>
+
+class Graph;
+class GL_Graph;
+
+/**
+ * Evaluates several graphs that sample the same grid in one pass.
+ *
+ * Their expressions are compiled into a single Evaluator (@see Expression::fused_evaluator), so subexpressions
+ * they have in common (like the same UserFunction applied to the plot variables) are calculated only once per
+ * grid point. Every GL_Graph of the group then reads its own outputs in its update method. Those that want
+ * the exact normals also get their derivatives (@see Expression::jet_evaluator).
+ */
+
+class SharedGrid
+{
+public:
+	/**
+	 * Finds all groups of (at least two) graphs that need updating and sample the same grid and evaluates them.
+	 * The GL_Graphs of every group use their SharedGrid until it is deleted.
+	 */
+	static void create(const std::vector<Graph*> &graphs, double quality, int n_threads,
+	                   std::vector<std::unique_ptr<SharedGrid>> &dst);
+
+	~SharedGrid();
+
+	bool matches(const DI_Grid &g, bool c) const{ return c == complex && g == ig; }
+
+	/// Outputs of members[k] for grid point (i,j) are at values(k) + (i*nx+j)*stride()
+	const cnum *values(int k) const{ return data.get() + offsets[k]; }
+	int stride() const{ return nout; }
+	bool jet(int k) const{ return jets[k]; } ///< values(k) are followed by the derivatives by the plotvars
+
+private:
+	SharedGrid(const DI_Grid &ig, bool complex) : ig(ig), complex(complex), nout(0){ }
+
+	bool evaluate(int n_threads, bool draft);
+
+	DI_Grid                 ig;
+	bool                    complex; // input is x+iy instead of (x,y)?
+	std::vector<Graph*>     graphs;
+	std::vector<GL_Graph*>  members;
+	std::vector<int>        offsets; // index of every member's first output
+	std::vector<bool>       jets;    // members with derivatives
+	int                     nout;    // total number of outputs
+	std::unique_ptr<cnum[]> data;
+};
@@ -21,6 +21,7 @@ public:
 	
 	P3f       *points()       { return p.get(); }
 	const P3f *points () const{ return p.get(); }
+	size_t num_points () const{ return n_points; }
 	
 private:
 	std::unique_ptr<P3f[]> p;
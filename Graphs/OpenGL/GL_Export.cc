@@ -0,0 +1,293 @@
+#include "GL_Export.h"
+#include "GL_Mesh.h"
+#include "GL_Lines.h"
+#include "GL_Dots.h"
+#include "GL_Image.h"
+#include <cassert>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+
+//----------------------------------------------------------------------------------------------------------------------
+// collecting
+//----------------------------------------------------------------------------------------------------------------------
+
+bool GL_Export::format(const std::string &path, Format &f)
+{
+	size_t i = path.rfind('.');
+	if (i == std::string::npos) return false;
+	std::string ext = path.substr(i + 1);
+	for (char &c : ext) c = (char)tolower((unsigned char)c);
+	if      (ext == "ply") f = PLY;
+	else if (ext == "obj") f = OBJ;
+	else if (ext == "stl") f = STL;
+	else if (ext == "png") f = PNG;
+	else return false;
+	return true;
+}
+
+void GL_Export::add(const GL_Mesh &m, const GL_Image *texture)
+{
+	size_t np = m.num_points(), nf = m.num_faces();
+	if (!np || !nf) return;
+
+	GLuint i0 = (GLuint)vertexes.size();
+	vertexes.insert(vertexes.end(), m.points(), m.points() + np);
+	if (m.normal_mode() == GL_Mesh::NormalMode::Vertex && m.normals())
+	{
+		normals.resize(i0); // pad with zeros for anything that came before
+		normals.insert(normals.end(), m.normals(), m.normals() + np);
+		has_normals = true;
+	}
+	if (texture && !texture->empty())
+	{
+		assert(m.texture());
+		texcoords.resize(i0);
+		texcoords.insert(texcoords.end(), m.texture(), m.texture() + np);
+		has_texcoords = true;
+		textured.push_back({num_triangles(), num_triangles() + nf, images.size()});
+		images.push_back(texture);
+	}
+
+	const GLuint *f = m.faces();
+	triangles.reserve(triangles.size() + 3*nf);
+	for (size_t i = 0; i < 3*nf; ++i) triangles.push_back(i0 + f[i]);
+}
+
+void GL_Export::add(const GL_Lines &l)
+{
+	size_t np = l.num_points();
+	if (!np) return;
+
+	GLuint i0 = (GLuint)vertexes.size();
+	const P3f *p = l.points();
+	vertexes.insert(vertexes.end(), p, p + np);
+
+	const std::vector<size_t> &s = l.segments();
+	if (s.empty())
+	{
+		for (GLuint i = 0; i+1 < np; i += 2){ segments.push_back(i0+i); segments.push_back(i0+i+1); }
+	}
+	else
+	{
+		GLuint j = i0;
+		for (size_t n : s)
+		{
+			for (size_t k = 1; k < n; ++k){ segments.push_back(j+(GLuint)k-1); segments.push_back(j+(GLuint)k); }
+			j += (GLuint)n;
+		}
+	}
+}
+
+void GL_Export::add(const GL_Dots &d)
+{
+	add_dots(d.points(), d.num_points());
+}
+
+void GL_Export::add_dots(const P3f *p, size_t n)
+{
+	if (!n) return;
+	GLuint i0 = (GLuint)vertexes.size();
+	vertexes.insert(vertexes.end(), p, p + n);
+	for (size_t i = 0; i < n; ++i) dots.push_back(i0 + (GLuint)i);
+}
+
+void GL_Export::add_vectors(const P3f *p, const P3f *v, float scale, size_t n)
+{
+	GLuint i0 = (GLuint)vertexes.size();
+	for (size_t i = 0; i < n; ++i)
+	{
+		vertexes.push_back(p[i]);
+		vertexes.push_back(p[i] + v[i]*scale);
+		segments.push_back(i0 + 2*(GLuint)i);
+		segments.push_back(i0 + 2*(GLuint)i + 1);
+	}
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// writing
+//----------------------------------------------------------------------------------------------------------------------
+
+void GL_Export::write(const std::string &path, Format f) const
+{
+	if (f != PNG && !vertexes.empty())
+	{
+		FILE *F = fopen(path.c_str(), "wb");
+		if (!F) throw std::runtime_error(std::string("can't open file for writing: ") + path);
+		switch (f)
+		{
+			case PLY: write_ply(F, path); break;
+			case OBJ: write_obj(F, path); break;
+			case STL: write_stl(F); break;
+			default: assert(false); break;
+		}
+		bool ok = !ferror(F);
+		if (fclose(F) != 0) ok = false;
+		if (!ok) throw std::runtime_error(std::string("error writing ") + path);
+	}
+
+	write_images(path);
+}
+
+// file name without the directory
+static std::string file_name(const std::string &path)
+{
+	size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// path without the extension
+static std::string base_path(const std::string &path)
+{
+	size_t dot = path.rfind('.'), slash = path.find_last_of("/\\");
+	return (dot == std::string::npos || (slash != std::string::npos && dot < slash)) ? path : path.substr(0, dot);
+}
+
+std::string GL_Export::image_path(const std::string &path, size_t i) const
+{
+	return base_path(path) + (images.size() > 1 ? "-" + std::to_string(i+1) : std::string()) + ".png";
+}
+
+// binary PLY with vertex normals and texture coordinates if there are any, faces, edges for the lines (dots are
+// just vertexes)
+void GL_Export::write_ply(FILE *F, const std::string &path) const
+{
+	bool nrm = has_normals, tex = has_texcoords;
+	size_t nv = vertexes.size();
+
+	fprintf(F, "ply\nformat binary_little_endian 1.0\ncomment CPlot export\n");
+	for (const Textured &t : textured) fprintf(F, "comment TextureFile %s\n", file_name(image_path(path, t.image)).c_str());
+	fprintf(F, "element vertex %zu\nproperty float x\nproperty float y\nproperty float z\n", nv);
+	if (nrm) fprintf(F, "property float nx\nproperty float ny\nproperty float nz\n");
+	if (tex) fprintf(F, "property float s\nproperty float t\n");
+	fprintf(F, "element face %zu\nproperty list uchar uint vertex_indices\n", num_triangles());
+	fprintf(F, "element edge %zu\nproperty uint vertex1\nproperty uint vertex2\n", num_segments());
+	fprintf(F, "end_header\n");
+
+	static const P3f zero(0.0f, 0.0f, 0.0f);
+	static const P2f zero2(0.0f, 0.0f);
+	for (size_t i = 0; i < nv; ++i)
+	{
+		fwrite((const float*)vertexes[i], sizeof(float), 3, F);
+		if (nrm) fwrite((const float*)(i < normals.size() ? normals[i] : zero), sizeof(float), 3, F);
+		if (tex) fwrite((const float*)(i < texcoords.size() ? texcoords[i] : zero2), sizeof(float), 2, F);
+	}
+	const unsigned char three = 3;
+	for (size_t i = 0; i < triangles.size(); i += 3)
+	{
+		fwrite(&three, 1, 1, F);
+		fwrite(&triangles[i], sizeof(GLuint), 3, F);
+	}
+	if (!segments.empty()) fwrite(segments.data(), sizeof(GLuint), segments.size(), F);
+}
+
+// with a material file next to it that maps the textures
+void GL_Export::write_obj(FILE *F, const std::string &path) const
+{
+	fprintf(F, "# CPlot export\n");
+	if (!textured.empty())
+	{
+		std::string mtl = base_path(path) + ".mtl";
+		FILE *M = fopen(mtl.c_str(), "wb");
+		if (!M) throw std::runtime_error(std::string("can't open file for writing: ") + mtl);
+		fprintf(M, "newmtl default\nKd 0.8 0.8 0.8\n");
+		for (const Textured &t : textured)
+		{
+			fprintf(M, "newmtl texture%zu\nKd 1 1 1\nmap_Kd %s\n", t.image+1, file_name(image_path(path, t.image)).c_str());
+		}
+		bool ok = !ferror(M);
+		if (fclose(M) != 0 || !ok) throw std::runtime_error(std::string("error writing ") + mtl);
+		fprintf(F, "mtllib %s\n", file_name(mtl).c_str());
+	}
+	for (const P3f &v : vertexes) fprintf(F, "v %g %g %g\n", v.x, v.y, v.z);
+
+	bool nrm = has_normals, tex = has_texcoords;
+	if (nrm) for (size_t i = 0; i < vertexes.size(); ++i)
+	{
+		const P3f n = (i < normals.size() ? normals[i] : P3f(0.0f, 0.0f, 0.0f));
+		fprintf(F, "vn %g %g %g\n", n.x, n.y, n.z);
+	}
+	if (tex) for (size_t i = 0; i < vertexes.size(); ++i)
+	{
+		const P2f t = (i < texcoords.size() ? texcoords[i] : P2f(0.0f, 0.0f));
+		fprintf(F, "vt %g %g\n", t.x, t.y);
+	}
+
+	// indexes are 1-based
+	size_t m = 0; // next entry of textured
+	for (size_t i = 0; i < triangles.size(); i += 3)
+	{
+		if (m < textured.size() && 3*textured[m].t0 == i) fprintf(F, "usemtl texture%zu\n", textured[m].image+1);
+		GLuint a = triangles[i]+1, b = triangles[i+1]+1, c = triangles[i+2]+1;
+		if (nrm && tex)
+			fprintf(F, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c);
+		else if (nrm)
+			fprintf(F, "f %u//%u %u//%u %u//%u\n", a, a, b, b, c, c);
+		else if (tex)
+			fprintf(F, "f %u/%u %u/%u %u/%u\n", a, a, b, b, c, c);
+		else
+			fprintf(F, "f %u %u %u\n", a, b, c);
+		if (m < textured.size() && 3*textured[m].t1 == i+3)
+		{
+			if (i+3 < triangles.size()) fprintf(F, "usemtl default\n");
+			++m;
+		}
+	}
+	for (size_t i = 0; i < segments.size(); i += 2) fprintf(F, "l %u %u\n", segments[i]+1, segments[i+1]+1);
+	for (GLuint i : dots) fprintf(F, "p %u\n", i+1);
+}
+
+// binary STL, triangles only
+void GL_Export::write_stl(FILE *F) const
+{
+	char header[80];
+	memset(header, 0, sizeof(header));
+	strcpy(header, "CPlot export");
+	fwrite(header, 1, 80, F);
+
+	uint32_t n = (uint32_t)num_triangles();
+	fwrite(&n, 4, 1, F);
+
+	for (size_t i = 0; i < triangles.size(); i += 3)
+	{
+		const P3f &a = vertexes[triangles[i]], &b = vertexes[triangles[i+1]], &c = vertexes[triangles[i+2]];
+		P3f u = b-a, v = c-a;
+		P3f nrm(u.y*v.z - u.z*v.y, u.z*v.x - u.x*v.z, u.x*v.y - u.y*v.x);
+		float l = nrm.abs();
+		if (l > 0.0f) nrm /= l;
+
+		fwrite((const float*)nrm, sizeof(float), 3, F);
+		fwrite((const float*)a,   sizeof(float), 3, F);
+		fwrite((const float*)b,   sizeof(float), 3, F);
+		fwrite((const float*)c,   sizeof(float), 3, F);
+		uint16_t attr = 0;
+		fwrite(&attr, 2, 1, F);
+	}
+}
+
+#ifdef __linux__
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "../../Linux/stb/stb_image_write.h"
+
+void GL_Export::write_images(const std::string &path) const
+{
+	if (images.empty()) return;
+
+	stbi_flip_vertically_on_write(1); // rows are stored bottom to top, as OpenGL wants them
+	for (size_t i = 0; i < images.size(); ++i)
+	{
+		const GL_Image &im = *images[i];
+		if (im.empty()) continue;
+		std::string p = image_path(path, i);
+		if (!stbi_write_png(p.c_str(), (int)im.w(), (int)im.h(), 4, im.data().data(), 4*(int)im.w()))
+		{
+			throw std::runtime_error(std::string("error writing ") + p);
+		}
+	}
+}
+#else
+void GL_Export::write_images(const std::string &) const
+{
+	if (!images.empty()) throw std::runtime_error("PNG export is not supported on this platform");
+}
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+#include "../Geometry/Vector.h"
+#include <GL/gl.h>
+#include <string>
+#include <vector>
+
+class GL_Mesh;
+class GL_Lines;
+class GL_Dots;
+struct GL_Image;
+
+/**
+ * Collects the geometry of updated GL_Graphs and writes it to files (no OpenGL context needed).
+ *
+ * Triangles, line segments and points of all graphs go into one PLY, OBJ or STL file (STL only stores the
+ * triangles). The images of color graphs are written as PNG files. Meshes that are colored by a texture also
+ * get their texture coordinates, and the PLY or OBJ file references the texture's PNG.
+ * All coordinates are in GL space, as the graphs draw them.
+ */
+
+class GL_Export
+{
+public:
+	GL_Export() : has_normals(false), has_texcoords(false){ }
+
+	enum Format
+	{
+		PLY,
+		OBJ,
+		STL,
+		PNG  ///< only the images
+	};
+
+	/// Format from the extension of path
+	static bool format(const std::string &path, Format &f);
+
+	void add(const GL_Mesh  &m, const GL_Image *texture = NULL); ///< m must have texture coordinates if texture is set
+	void add(const GL_Lines &l);
+	void add(const GL_Dots  &d);
+	void add_dots(const P3f *p, size_t n);
+	void add_vectors(const P3f *p, const P3f *v, float scale, size_t n); ///< line from p[i] to p[i]+v[i]*scale
+	void add(const GL_Image &im){ images.push_back(&im); }
+
+	size_t num_triangles() const{ return triangles.size() / 3; }
+	size_t num_segments () const{ return segments.size()  / 2; }
+	size_t num_vertexes () const{ return vertexes.size(); }
+	size_t num_images   () const{ return images.size(); }
+	bool   empty() const{ return vertexes.empty() && images.empty(); }
+
+	/**
+	 * Writes the geometry to path (unless f is PNG) and every image to path with its extension replaced by
+	 * ".png" (or "-1.png", "-2.png", ... if there is more than one).
+	 * @throw std::runtime_error
+	 */
+	void write(const std::string &path, Format f) const;
+
+private:
+	std::vector<P3f>    vertexes;
+	std::vector<P3f>    normals;   ///< one per vertex, zero where there is none
+	std::vector<GLuint> triangles; ///< three indexes into vertexes per triangle
+	std::vector<GLuint> segments;  ///< two per line segment
+	std::vector<GLuint> dots;
+	std::vector<P2f>    texcoords; ///< one per vertex, zero where there is none
+	std::vector<const GL_Image*> images;
+	bool                has_normals;   ///< any vertex normals at all?
+	bool                has_texcoords; ///< any texture coordinates at all?
+	
+	struct Textured{ size_t t0, t1, image; }; ///< triangles [t0,t1) are colored by images[image]
+	std::vector<Textured> textured;
+	
+	std::string image_path(const std::string &path, size_t i) const;
+
+	void write_ply(FILE *F, const std::string &path) const;
+	void write_obj(FILE *F, const std::string &path) const;
+	void write_stl(FILE *F) const;
+	void write_images(const std::string &path) const;
+};
@@ -1,5 +1,7 @@
 #include "GL_Image.h"
 #include "../../Utility/Mutex.h"
+#include "../../Utility/Preferences.h"
+#include "../Threading/ThreadMap.h"
 #include <cassert>
 #include <random>
 #include <map>
@@ -142,6 +144,7 @@ GL_Image &GL_Image::pattern(GL_ImagePattern p)
 				break;}
 		}
 		im._opacity = pattern_opacity(p);
+		im.build_levels();
 		return im;
 	}
 	
@@ -175,6 +178,7 @@ bool GL_Image::load(const std::string &path)
 	if (!d2) return false;
 	memcpy(d2, d1, x*y*4);
 	stbi_image_free(d1);
+	build_levels();
 	return true;
 }
 #endif
@@ -259,6 +263,7 @@ void GL_Image::load(Deserializer &s)
 		
 		_opacity = -1;
 		check_data();
+		build_levels();
 	}
 	else
 	{
@@ -266,6 +271,7 @@ void GL_Image::load(Deserializer &s)
 		pattern_dim(_pattern, _w, _h);
 		_data.clear();
 		_opacity = pattern_opacity(_pattern);
+		clear_levels();
 	}
 	++_state;
 	modify();
@@ -286,6 +292,7 @@ GL_Image &GL_Image::operator=(GL_ImagePattern p)
 	pattern_dim(p, _w, _h);
 	_data.clear();
 	_opacity = pattern_opacity(_pattern);
+	clear_levels();
 	++_state;
 	modify();
 
@@ -297,10 +304,10 @@ const std::vector<unsigned char> &GL_Image::data() const
 	return (_pattern == IP_CUSTOM ? _data : GL_Image::pattern(_pattern)._data);
 }
 
-void GL_Image::mix(const GL_Color &base, float alpha, std::vector<unsigned char> &dst) const
+static inline unsigned div255(unsigned x){ return (x * 0x8081) >> 23; } // exact for x <= 255*255
+
+void GL_Image::mix(const std::vector<unsigned char> &d, const GL_Color &base, float alpha, std::vector<unsigned char> &dst)
 {
-	check_data();
-	const std::vector<unsigned char> &d = data();
 	dst.resize(d.size());
 	
 	unsigned br = (base.r <= 0.0f ? 0 : base.r >= 1.0f ? 255 : (unsigned char)(255.0f * base.r));
@@ -311,17 +318,15 @@ void GL_Image::mix(const GL_Color &base, float alpha, std::vector<unsigned char>
 
 	for (size_t i = 0, n = d.size(); i < n; i += 4)
 	{
-		unsigned a = (a1*d[i+3])/255;
-		dst[i  ] = (unsigned char)((d[i  ]*a + br*(255-a))/255);
-		dst[i+1] = (unsigned char)((d[i+1]*a + bg*(255-a))/255);
-		dst[i+2] = (unsigned char)((d[i+2]*a + bb*(255-a))/255);
+		unsigned a = div255(a1*d[i+3]);
+		dst[i  ] = (unsigned char)div255(d[i  ]*a + br*(255-a));
+		dst[i+1] = (unsigned char)div255(d[i+1]*a + bg*(255-a));
+		dst[i+2] = (unsigned char)div255(d[i+2]*a + bb*(255-a));
 		dst[i+3] = (unsigned char)ba;
 	}
 }
-void GL_Image::mix(float alpha, std::vector<unsigned char> &dst) const
+void GL_Image::mix(const std::vector<unsigned char> &d, float alpha, std::vector<unsigned char> &dst)
 {
-	check_data();
-	const std::vector<unsigned char> &d = data();
 	dst = d;
 
 	if (alpha < 1.0-1e-5)
@@ -329,7 +334,7 @@ void GL_Image::mix(float alpha, std::vector<unsigned char> &dst) const
 		unsigned a1 = (alpha <= 0.0f ? 0 : alpha >= 1.0f ? 255 : (unsigned char)(255.0f*alpha));
 		for (size_t i = 3; i < d.size(); i += 4)
 		{
-			dst[i] = (unsigned char)(a1 * dst[i] / 255);
+			dst[i] = (unsigned char)div255(a1 * dst[i]);
 		}
 	}
 }
@@ -361,4 +366,92 @@ void GL_Image::prettify(bool circle)
 			d += 4;
 		}
 	}
+	if (!_levels.empty()) build_levels();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// mip pyramid
+//----------------------------------------------------------------------------------------------------------------------
+
+static void no_setup(const void *, void *&){ }
+static void no_finish(void *){ }
+
+void GL_Image::downsample(const GL_Image &src)
+{
+	const unsigned sw = src._w, sh = src._h, w = std::max(1u, sw/2), h = std::max(1u, sh/2);
+	unsigned char *dst = redim(w, h);
+	const unsigned char *s = src._data.data();
+	assert(src._data.size() == (size_t)sw * sh * 4);
+	
+	// average 2x2 texels (or 2x1, 1x2 if src is only one texel wide or high) and weight the colors by alpha, so
+	// transparent texels do not bleed into their neighbours. Odd last rows and columns are dropped like in GL.
+	const size_t dx = sw > 1 ? 4 : 0, dy = sh > 1 ? (size_t)sw * 4 : 0;
+	auto rows = [=](unsigned i0, unsigned i1)
+	{
+		for (unsigned i = i0; i < i1; ++i)
+		{
+			unsigned char *d = dst + (size_t)w * i * 4;
+			for (unsigned j = 0; j < w; ++j, d += 4)
+			{
+				const unsigned char *p = s + ((size_t)sw * (dy ? 2*i : i) + (dx ? 2*j : j)) * 4, *q = p + dx, *r = p + dy, *t = r + dx;
+				unsigned a = p[3] + q[3] + r[3] + t[3];
+				for (int c = 0; c < 3; ++c)
+				{
+					d[c] = (unsigned char)(a ? (p[c]*p[3] + q[c]*q[3] + r[c]*r[3] + t[c]*t[3] + a/2) / a
+					                         : (p[c] + q[c] + r[c] + t[c] + 2) / 4);
+				}
+				d[3] = (unsigned char)((a + 2) / 4);
+			}
+		}
+	};
+	
+	if ((size_t)w * h < 65536 || n_cores <= 1){ rows(0, h); return; }
+
+	Task task(NULL, no_setup, no_finish);
+	WorkLayer *layer = new WorkLayer("downsample", &task, NULL);
+	unsigned chunk = std::max(16u, (h + 2*n_cores - 1) / (2*n_cores));
+	for (unsigned i = 0; i < h; i += chunk)
+	{
+		unsigned i1 = std::min(h, i + chunk);
+		layer->add_unit([=](void *){ rows(i, i1); });
+	}
+	task.run(n_cores);
+}
+
+void GL_Image::build_levels()
+{
+	clear_levels();
+	if (_data.empty()) return; // patterns have theirs in GL_Image::pattern
+	
+	const GL_Image *src = this;
+	while (src->_w > 1 || src->_h > 1)
+	{
+		GL_Image *L = new GL_Image;
+		L->downsample(*src);
+		_levels.push_back(L);
+		src = L;
+	}
+}
+
+const GL_Image &GL_Image::level_for(unsigned w, unsigned h) const
+{
+	const std::vector<GL_Image*> &L = pyramid();
+	for (size_t k = L.size(); k > 0; --k)
+	{
+		if (L[k-1]->_w >= w && L[k-1]->_h >= h) return *L[k-1];
+	}
+	return *this;
+}
+
+void GL_Image::copy_levels(const GL_Image &x)
+{
+	if (&x == this) return;
+	clear_levels();
+	for (const GL_Image *L : x._levels) _levels.push_back(new GL_Image(*L));
+}
+
+void GL_Image::clear_levels()
+{
+	for (GL_Image *L : _levels) delete L;
+	_levels.clear();
 }
@@ -27,7 +27,9 @@ struct GL_Image : public Serializable, public GL_Resource
 	, _w(i._w), _h(i._h), _data(i._data), _pattern(i._pattern), _opacity(i._opacity)
 	{
 		check_data();
+		copy_levels(i);
 	}
+	virtual ~GL_Image(){ clear_levels(); }
 	
 	#ifdef __linux__
 	bool load(const std::string &path);
@@ -41,6 +43,7 @@ struct GL_Image : public Serializable, public GL_Resource
 		_pattern = x._pattern;
 		_opacity = x._opacity;
 		check_data();
+		copy_levels(x);
 		++_state;
 		modify();
 		return *this;
@@ -54,6 +57,7 @@ struct GL_Image : public Serializable, public GL_Resource
 		std::swap(_data, x._data);
 		std::swap(_pattern, x._pattern);
 		std::swap(_opacity, x._opacity);
+		std::swap(_levels, x._levels);
 		++_state; ++x._state;
 		modify(); x.modify();
 		return *this;
@@ -77,6 +81,7 @@ struct GL_Image : public Serializable, public GL_Resource
 		_data.resize(_w * _h * 4);
 		_pattern = IP_CUSTOM;
 		_opacity = -1;
+		clear_levels();
 		++_state;
 		modify(); // even if w==w_ and h==h_ !
 		return _data.data();
@@ -111,8 +116,17 @@ struct GL_Image : public Serializable, public GL_Resource
 	
 	void prettify(bool circle=false);
 	
-	void mix(const GL_Color &base, float alpha, std::vector<unsigned char> &dst) const;
-	void mix(float alpha, std::vector<unsigned char> &dst) const;
+	void mix(const GL_Color &base, float alpha, std::vector<unsigned char> &dst) const{ check_data(); mix(data(), base, alpha, dst); }
+	void mix(float alpha, std::vector<unsigned char> &dst) const{ check_data(); mix(data(), alpha, dst); }
+	static void mix(const std::vector<unsigned char> &src, const GL_Color &base, float alpha, std::vector<unsigned char> &dst);
+	static void mix(const std::vector<unsigned char> &src, float alpha, std::vector<unsigned char> &dst); ///< src = some data()
+	
+	// Mip pyramid: every level is the previous one averaged down to half its size, down to 1x1. It is built when
+	// loading an image, all other changes drop it.
+	void build_levels();
+	unsigned levels() const{ return 1 + (unsigned)pyramid().size(); } ///< including this one
+	const GL_Image &level(unsigned k) const{ assert(k < levels()); return k ? *pyramid()[k-1] : *this; }
+	const GL_Image &level_for(unsigned w, unsigned h) const; ///< smallest level of at least w x h
 	
 private:
 	unsigned                   _w, _h;   // width and height
@@ -120,6 +134,7 @@ private:
 	std::vector<unsigned char> _data;    // rgba, size = 4*w*h or empty for patterns
 	mutable short              _opacity; // -1 = unknown, 0 = transparent, 1 = opaque
 	size_t                     _state;   // incremented on every modification
+	std::vector<GL_Image*>     _levels;  // level(1), level(2), ... for custom images
 
 	inline void check_data() const
 	{
@@ -127,4 +142,8 @@ private:
 	}
 	
 	static GL_Image &pattern(GL_ImagePattern p);
+	const std::vector<GL_Image*> &pyramid() const{ return _pattern == IP_CUSTOM ? _levels : pattern(_pattern)._levels; }
+	void downsample(const GL_Image &src);
+	void copy_levels(const GL_Image &x);
+	void clear_levels();
 };
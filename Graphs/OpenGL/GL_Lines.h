@@ -24,6 +24,8 @@ public:
 	
 	P3f       *points()       { return p.get(); }
 	const P3f *points () const{ return p.get(); }
+	size_t num_points () const{ return n_points; }
+	const std::vector<size_t> &segments() const{ return s; } ///< lengths of the line strips or empty for GL_LINES
 	
 private:
 	// p[0..s0-1], p[s0..s1-1], ... p[s[n-2], s[n-1]-1] are the line segments unless
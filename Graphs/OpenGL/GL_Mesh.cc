@@ -10,6 +10,8 @@ void GL_Mesh::resize(size_t np, size_t nf, NormalMode nm, bool textured)
 	max_index = 0;
 	e.reset(nullptr);
 	n_gridlines = 0;
+	lods.clear();
+	lod_step = 0.0f;
 	
 	if (n_points != np)
 	{
@@ -46,6 +48,51 @@ void GL_Mesh::resize(size_t np, size_t nf, NormalMode nm, bool textured)
 		memset(n.get(), 0, nn*sizeof(P3f));
 	}
 }
+void GL_Mesh::grow(size_t np, size_t nf)
+{
+	assert(np >= n_points && nf >= n_faces);
+	e.reset(nullptr);
+	n_gridlines = 0;
+	lods.clear();
+	lod_step = 0.0f;
+	
+	if (np > n_points)
+	{
+		P3f *p1 = new P3f[np];
+		memcpy(p1, p.get(), n_points*sizeof(P3f));
+		p.reset(p1);
+		if (t)
+		{
+			P2f *t1 = new P2f[np];
+			memcpy(t1, t.get(), n_points*sizeof(P2f));
+			t.reset(t1);
+		}
+		if (nmode == NormalMode::Vertex)
+		{
+			P3f *n1 = new P3f[np];
+			memcpy(n1, n.get(), n_normals*sizeof(P3f));
+			memset(n1 + n_normals, 0, (np-n_normals)*sizeof(P3f));
+			n.reset(n1);
+			n_normals = np;
+		}
+		n_points = np;
+	}
+	if (nf > n_faces)
+	{
+		GLuint *f1 = new GLuint[3*nf];
+		memcpy(f1, f.get(), 3*n_faces*sizeof(GLuint));
+		f.reset(f1);
+		if (nmode == NormalMode::Face)
+		{
+			P3f *n1 = new P3f[nf];
+			memcpy(n1, n.get(), n_normals*sizeof(P3f));
+			memset(n1 + n_normals, 0, (nf-n_normals)*sizeof(P3f));
+			n.reset(n1);
+			n_normals = nf;
+		}
+		n_faces = nf;
+	}
+}
 void GL_Mesh::clear()
 {
 	n_points = n_faces = n_normals = n_gridlines = max_index = 0;
@@ -55,6 +102,8 @@ void GL_Mesh::clear()
 	t.reset(nullptr);
 	f.reset(nullptr);
 	e.reset(nullptr);
+	lods.clear();
+	lod_step = 0.0f;
 }
 
 // edge_flags must have same size as faces and only be called after faces are set
@@ -142,12 +191,14 @@ void GL_Mesh::close_gaps(size_t total_per_chunk, const std::vector<size_t> &skip
 	#endif
 }
 
-void GL_Mesh::draw(bool unit_normals) const
+void GL_Mesh::draw(bool unit_normals, int lod) const
 {
 	if (!n_points) return;
 	
-	const P3f    *na = normals();
-	const GLuint *fa = faces();
+	const LOD    *L  = (lod > 0 && lod <= (int)lods.size() ? &lods[lod-1] : NULL);
+	const P3f    *na = (L && nmode == NormalMode::Face ? L->n.data() : normals());
+	const GLuint *fa = (L ? L->f.data() : faces());
+	const size_t  nf = (L ? L->f.size() / 3 : n_faces);
 	
 	//------------------------------------------------------------------------------------------------------------------
 	// draw triangles
@@ -160,7 +211,7 @@ void GL_Mesh::draw(bool unit_normals) const
 	{
 		if (!unit_normals) glEnable(GL_NORMALIZE);
 		glBegin(GL_TRIANGLES);
-		for (size_t i = 0; i < n_faces; ++i)
+		for (size_t i = 0; i < nf; ++i)
 		{
 			glNormal3fv(na[i]);
 			glArrayElement(fa[3*i+1]);
@@ -175,13 +226,13 @@ void GL_Mesh::draw(bool unit_normals) const
 		if (!unit_normals) glEnable(GL_NORMALIZE);
 		glEnableClientState(GL_NORMAL_ARRAY);
 		glNormalPointer(GL_FLOAT, 0, na);
-		glDrawRangeElements(GL_TRIANGLES, 0,(GLuint)n_points, 3*(GLuint)n_faces, GL_UNSIGNED_INT, fa);
+		glDrawRangeElements(GL_TRIANGLES, 0,(GLuint)n_points, 3*(GLuint)nf, GL_UNSIGNED_INT, fa);
 		glDisableClientState(GL_NORMAL_ARRAY);
 		glDisable(GL_NORMALIZE);
 	}
 	else
 	{
-		glDrawRangeElements(GL_TRIANGLES, 0,(GLuint)n_points, 3*(GLuint)n_faces, GL_UNSIGNED_INT, fa);
+		glDrawRangeElements(GL_TRIANGLES, 0,(GLuint)n_points, 3*(GLuint)nf, GL_UNSIGNED_INT, fa);
 	}
 	
 	glDisableClientState(GL_VERTEX_ARRAY);
@@ -317,23 +368,32 @@ struct FaceCmp
 	inline bool operator() (const Iter::Val &a, const Iter::Ref &b){ return p[a.first.A]*view > p[b.face. A]*view; }
 };
 
+static void sort_faces(Face *fs, P3f *ns, size_t n_faces, P3f *points, const P3f &view)
+{
+	if (!ns)
+	{
+		std::sort(fs, fs + n_faces, FaceCmp{points,view});
+	}
+	else
+	{
+		// normals must be sorted with the faces.
+		Iter begin(fs,ns), end(fs + n_faces, ns + n_faces);
+		FaceCmp cmp{ points,view };
+		std::sort(begin, end, cmp);
+		//std::sort(Iter{fs,ns}, Iter{fs + n_faces, ns + n_faces}, FaceCmp{points(),view});
+	}
+}
+
 void GL_Mesh::depth_sort(const P3f &view)
 {
+	bool fn = (nmode == NormalMode::Face);
 	if (n_faces)
 	{
-		Face *fs = (Face*)faces();
-		if (nmode != NormalMode::Face)
-		{
-			std::sort(fs, fs + n_faces, FaceCmp{points(),view});
-		}
-		else
-		{
-			P3f *ns = normals(); // normals must be sorted with the faces.
-			Iter begin(fs,ns), end(fs + n_faces, ns + n_faces);
-			FaceCmp cmp{ points(),view };
-			std::sort(begin, end, cmp);
-			//std::sort(Iter{fs,ns}, Iter{fs + n_faces, ns + n_faces}, FaceCmp{points(),view});
-		}
+		sort_faces((Face*)faces(), fn ? normals() : NULL, n_faces, points(), view);
+	}
+	for (LOD &L : lods)
+	{
+		sort_faces((Face*)L.f.data(), fn ? L.n.data() : NULL, L.f.size() / 3, points(), view);
 	}
 	
 	if (n_gridlines)
@@ -343,3 +403,164 @@ void GL_Mesh::depth_sort(const P3f &view)
 	}
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+// Levels of detail
+//----------------------------------------------------------------------------------------------------------------------
+
+void GL_Mesh::set_lod(int nx, int ny, int max_levels)
+{
+	lods.clear();
+	lod_step = 0.0f;
+	
+	const int qx = nx-1, qy = ny-1; // number of quads, each one split into two faces
+	if (qx < 2 || qy < 2 || !n_faces || n_points != (size_t)nx * ny) return;
+	
+	const GLuint *fa = faces();
+	const P3f    *pa = points();
+	const P3f    *na = (nmode == NormalMode::Face ? normals() : NULL);
+	
+	// find the quad of every face, which quads have both faces, bounds and the average length of the grid edges
+	// (the first two edges of every face)
+	std::vector<size_t> quad(n_faces);
+	std::vector<unsigned char> n_quad((size_t)qx * qy, 0);
+	double len = 0.0;
+	lod_min = pa[fa[0]]; lod_max = lod_min;
+	for (size_t k = 0; k < n_faces; ++k)
+	{
+		const GLuint *F = fa + 3*k;
+		int i = ny, j = nx;
+		for (int c = 0; c < 3; ++c)
+		{
+			i = std::min(i, (int)(F[c] / nx));
+			j = std::min(j, (int)(F[c] % nx));
+			const P3f &p = pa[F[c]];
+			lod_min.x = std::min(lod_min.x, p.x); lod_max.x = std::max(lod_max.x, p.x);
+			lod_min.y = std::min(lod_min.y, p.y); lod_max.y = std::max(lod_max.y, p.y);
+			lod_min.z = std::min(lod_min.z, p.z); lod_max.z = std::max(lod_max.z, p.z);
+		}
+		assert(i < qy && j < qx);
+		quad[k] = (size_t)qx * i + j;
+		++n_quad[quad[k]];
+		len += (pa[F[1]] - pa[F[0]]).abs() + (pa[F[2]] - pa[F[1]]).abs();
+	}
+	lod_step = (float)(len / (2*n_faces));
+	
+	// complete[l] tells for every block of 2^l x 2^l quads (only whole ones) if all of its faces are there
+	std::vector<std::vector<bool>> complete(1);
+	std::vector<int> bx(1, qx), by(1, qy);
+	complete[0].resize(n_quad.size());
+	for (size_t q = 0; q < n_quad.size(); ++q) complete[0][q] = (n_quad[q] == 2);
+	auto is_complete = [&](int l, int i, int j) // block l containing quad (i,j)
+	{
+		i >>= l; j >>= l;
+		return i < by[l] && j < bx[l] && complete[l][(size_t)bx[l] * i + j];
+	};
+	
+	size_t nf_prev = n_faces;
+	for (int L = 1; L <= max_levels; ++L)
+	{
+		bx.push_back(bx[L-1] / 2); by.push_back(by[L-1] / 2);
+		complete.emplace_back((size_t)bx[L] * by[L]);
+		size_t nc = 0;
+		for (int i = 0; i < by[L]; ++i)
+		for (int j = 0; j < bx[L]; ++j)
+		{
+			const int s = 1 << L;
+			bool c = is_complete(L-1, i*s, j*s) && is_complete(L-1, i*s, j*s + s/2) &&
+			         is_complete(L-1, i*s + s/2, j*s) && is_complete(L-1, i*s + s/2, j*s + s/2);
+			complete[L][(size_t)bx[L] * i + j] = c;
+			if (c) ++nc;
+		}
+		if (!nc) break;
+		
+		LOD lod;
+		
+		// finer faces where no block is complete
+		for (size_t k = 0; k < n_faces; ++k)
+		{
+			if (is_complete(1, (int)(quad[k] / qx), (int)(quad[k] % qx))) continue;
+			lod.f.insert(lod.f.end(), fa + 3*k, fa + 3*k + 3);
+			if (na) lod.n.push_back(na[k]);
+		}
+		
+		// size of the block that covers quad (i,j) on this level (1 for the finer faces, 0 if there are none)
+		auto size_at = [&](int i, int j)
+		{
+			if (i < 0 || j < 0 || i >= qy || j >= qx) return 0;
+			for (int l = L; l >= 1; --l) if (is_complete(l, i, j)) return 1 << l;
+			return n_quad[(size_t)qx * i + j] ? 1 : 0;
+		};
+		auto add_face = [&](GLuint a, GLuint b, GLuint c)
+		{
+			lod.f.push_back(a); lod.f.push_back(b); lod.f.push_back(c);
+			if (!na) return;
+			P3f d1, d2, n;
+			sub(d1, pa[b], pa[a]);
+			sub(d2, pa[c], pa[a]);
+			cross(n, d1, d2);
+			n.to_unit();
+			lod.n.push_back(n);
+		};
+		
+		// the largest complete block everywhere else. Its sides also get the corners of smaller neighbours, so
+		// there are no T-junctions (and cracks) between them.
+		std::vector<GLuint> rim;
+		std::vector<bool> mark;
+		for (int l = 1; l <= L; ++l)
+		{
+			const int s = 1 << l;
+			mark.resize(s+1);
+			for (int i = 0; i < by[l]; ++i)
+			for (int j = 0; j < bx[l]; ++j)
+			{
+				if (!complete[l][(size_t)bx[l] * i + j] || l < L && is_complete(l+1, i*s, j*s)) continue;
+				
+				// counterclockwise in grid coordinates, starting at the corner with the smallest index
+				const int r0 = i*s, c0 = j*s, r1 = r0 + s, c1 = c0 + s;
+				rim.clear();
+				auto side = [&](int r, int c, int dr, int dc, int nr, int nc) // start, direction, neighbour quad offset
+				{
+					std::fill(mark.begin(), mark.end(), false);
+					for (int k = 0; k < s; ++k)
+					{
+						int t = size_at(r + k*dr + nr, c + k*dc + nc);
+						if (t <= 0 || t >= s) continue;
+						int k0 = k - k % t;
+						mark[k0] = mark[k0 + t] = true;
+					}
+					for (int k = 0; k < s; ++k) if (k == 0 || mark[k]) rim.push_back((GLuint)(nx*(r + k*dr) + c + k*dc));
+				};
+				side(r0, c0,  0,  1, -1,  0);
+				side(r0, c1,  1,  0,  0,  0);
+				side(r1, c1,  0, -1,  0, -1);
+				side(r1, c0, -1,  0, -1, -1);
+				
+				if (rim.size() == 4)
+				{
+					// split like the quads (@see gridWorker)
+					GLuint C = rim[0], D = rim[1], B = rim[2], A = rim[3];
+					add_face(B, A, C);
+					add_face(C, D, B);
+				}
+				else
+				{
+					GLuint M = (GLuint)(nx*(r0 + s/2) + c0 + s/2);
+					for (size_t k = 0, n = rim.size(); k < n; ++k) add_face(M, rim[k], rim[(k+1) % n]);
+				}
+			}
+		}
+		
+		size_t nf = lod.f.size() / 3;
+		if (nf > nf_prev * 3 / 4) break; // not worth it
+		nf_prev = nf;
+		lods.push_back(std::move(lod));
+	}
+}
+
+int GL_Mesh::lod(double pixels_per_unit) const
+{
+	double px = lod_step * pixels_per_unit; // edge length of level 0 on screen
+	int k = 0;
+	while (k < (int)lods.size() && px * (2 << k) <= 1.0) ++k;
+	return k;
+}
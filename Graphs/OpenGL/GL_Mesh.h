@@ -16,16 +16,17 @@ public:
 		None
 	};
 
-	GL_Mesh() : n_points(0), n_faces(0), n_normals(0), n_gridlines(0), max_index(0)
+	GL_Mesh() : n_points(0), n_faces(0), n_normals(0), n_gridlines(0), max_index(0), lod_step(0.0f)
 	{ }
 	
 	GL_Mesh(const GL_Mesh &m) = delete;
 	GL_Mesh &operator=(const GL_Mesh &) = delete;
 
 	void resize(size_t n_points, size_t n_faces, NormalMode n, bool textured);
+	void grow(size_t n_points, size_t n_faces); //!< keeps points, normals, texture and faces, drops grid and LODs
 	void clear();
 	
-	void draw(bool normals_are_unit) const; //!< caller must set up the texture arrays if needed!
+	void draw(bool normals_are_unit, int lod = 0) const; //!< caller must set up the texture arrays if needed!
 	void draw_grid(bool full=false) const;
 	void draw_normals() const; // for debugging
 	
@@ -43,9 +44,24 @@ public:
 	const P2f    *texture() const{ return t.get(); }
 	const GLuint *edges  () const{ return e.get(); }
 
+	size_t     num_points () const{ return n_points; }
+	size_t     num_faces  () const{ return n_faces; }
+	NormalMode normal_mode() const{ return nmode; }
+
 	void set_grid(bool *edge_flags, bool remove_duplicates = true);
 	void close_gaps(size_t total_per_chunk, const std::vector<size_t> &skipped, bool *edge_flags);
 	
+	/**
+	 * Levels of detail for meshes on a regular nx x ny grid (point index nx*i+j): every level merges blocks of 2x2
+	 * faces of the one before wherever all of them are there and keeps the finer faces elsewhere. They share the
+	 * points, normals and texture coordinates.
+	 */
+	void set_lod(int nx, int ny, int max_levels = 3);
+	int  num_lods() const{ return 1 + (int)lods.size(); }
+	int  lod(double pixels_per_unit) const; //!< coarsest level with faces of at most about a pixel
+	
+	void bounds(P3f &min, P3f &max) const{ min = lod_min; max = lod_max; } //!< of the points, if set_lod was called
+
 private:
 	std::unique_ptr<P3f   []> p; //!< vertex coordinates
 	std::unique_ptr<P3f   []> n; //!< normals; NULL, one per point, or one per face, depending on NormalMode
@@ -57,6 +73,15 @@ private:
 	size_t max_index; // in faces/grid index array
 	NormalMode nmode;
 	
+	struct LOD
+	{
+		std::vector<GLuint> f; //!< faces
+		std::vector<P3f>    n; //!< face normals for NormalMode::Face
+	};
+	std::vector<LOD> lods;     //!< level 1, 2, ...
+	float lod_step;            //!< average edge length of level 0
+	P3f   lod_min, lod_max;
+	
 	void gen_vertex_normals(); // turn face- into vertex-normals
 	void gen_normals(bool per_vertex = true, int n_threads = -1); // -1 = n_cores
 };
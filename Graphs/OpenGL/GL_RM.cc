@@ -2,6 +2,8 @@
 #include "GL_Image.h"
 #include "GL_Mask.h"
 #include "../Geometry/Camera.h"
+#include <memory>
+#include <chrono>
 
 #ifdef TXDEBUG
 #define DEBUG_TEXTURES(x) std::cerr << x << std::endl
@@ -113,6 +115,7 @@ void GL_RM::modified(const GL_Resource *r)
 	{
 		j.modified = true;
 	}
+	forget_mixes(r);
 }
 
 void GL_RM::deleted(const GL_Resource *r)
@@ -122,6 +125,7 @@ void GL_RM::deleted(const GL_Resource *r)
 	
 	orphans.insert(orphans.end(), i->second.begin(), i->second.end());
 	resources.erase(const_cast<GL_Resource*>(r));
+	forget_mixes(r);
 }
 
 void GL_RM::clear_unused()
@@ -146,6 +150,7 @@ void GL_RM::clear_unused()
 		if (i->second.empty())
 		{
 			i->first->managers.erase(this);
+			forget_mixes(i->first); // it would not tell us about its deletion anymore
 			i = resources.erase(i);
 		}
 		else
@@ -167,6 +172,59 @@ void GL_RM::clear_unused()
 	orphans.clear();
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+// Textures
+//----------------------------------------------------------------------------------------------------------------------
+
+static const size_t MAX_MIXES = 3;
+
+const std::vector<unsigned char> &GL_RM::mix(const GL_Image &im, const Mix &key)
+{
+	for (auto m = mixes.begin(); m != mixes.end(); ++m)
+	{
+		if (!m->matches(key)) continue;
+		mixes.splice(mixes.begin(), mixes, m);
+		return mixes.front().data;
+	}
+	
+	mixes.push_front(key);
+	Mix &m = mixes.front();
+	if (key.baseUsed) im.mix(key.base, key.alpha, m.data); else im.mix(key.alpha, m.data);
+	assert(m.data.size() == (size_t)im.w() * im.h() * 4);
+	while (mixes.size() > MAX_MIXES) mixes.pop_back();
+	return m.data;
+}
+
+void GL_RM::start_mix(const GL_Image &im, const Mix &key)
+{
+	assert(!mixing.valid());
+	job = key;
+	job.data.clear();
+	
+	// im can change while we are mixing (and only its data is needed, not the mip levels)
+	auto copy = std::make_shared<std::vector<unsigned char>>(im.data());
+	mixing = std::async(std::launch::async, [this, copy]
+	{
+		if (job.baseUsed) GL_Image::mix(*copy, job.base, job.alpha, job.data); else GL_Image::mix(*copy, job.alpha, job.data);
+	});
+}
+
+void GL_RM::collect_mix()
+{
+	if (!mixing.valid() || mixing.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+	mixing.get();
+	if (!job.im) return;
+	
+	mixes.push_front(std::move(job));
+	while (mixes.size() > MAX_MIXES) mixes.pop_back();
+}
+
+void GL_RM::forget_mixes(const GL_Resource *r)
+{
+	mixes.remove_if([r](const Mix &m){ return m.im == r; });
+	if (mixing.valid() && job.im == r) job.im = NULL; // the worker does not look at it
+}
+
 GL_Handle GL_RM::upload_texture(const GL_Image &im, float alpha, const GL_Color *base, bool temporary)
 {
 	assert(alpha >= 0.0f || !base);
@@ -174,6 +232,10 @@ GL_Handle GL_RM::upload_texture(const GL_Image &im, float alpha, const GL_Color
 	
 	GL_CHECK;
 	
+	Mix key;
+	key.im = &im; key.state = im.state_counter();
+	key.alpha = alpha; if (base) key.base = *base; key.baseUsed = base;
+	
 	auto i = resources.find((GL_Resource*)(&im));
 	if (i != resources.end())
 	{
@@ -194,15 +256,52 @@ GL_Handle GL_RM::upload_texture(const GL_Image &im, float alpha, const GL_Color
 			}
 		}
 		
-		// (2) check for modified entries with the same size
+		// (2) draw an older mix of the unmodified image until the new one is ready
+		
+		if (alpha >= 0.0f && !temporary)
+		{
+			// finished jobs are only collected in start_drawing, so all subframes of a frame use the same texture
+			bool cached = false;
+			for (auto &m : mixes) if (m.matches(key)){ cached = true; break; }
+			
+			if (!cached) for (auto &j : i->second)
+			{
+				if (j.type == ResourceInfo::Texture && !j.modified && j.alpha >= 0.0f)
+				{
+					if (!mixing.valid()) start_mix(im, key); // else the next frame will start it
+					j.unused = false;
+					glBindTexture(GL_TEXTURE_2D, j.handle);
+
+					// show the newest finished mix (like while dragging the opacity slider, where every frame
+					// has a new alpha and the job never matches), so the texture lags by at most one mix
+					for (auto &m : mixes)
+					{
+						if (m.im != key.im || m.state != key.state) continue;
+						if (j.w == im.w() && j.h == im.h() &&
+							(m.alpha != j.alpha || m.baseUsed != j.baseUsed || (m.baseUsed && !(m.base == j.base))))
+						{
+							assert(m.data.size() == (size_t)im.w() * im.h() * 4);
+							j.alpha = m.alpha; j.base = m.base; j.baseUsed = m.baseUsed;
+							glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+							glTexSubImage2D(GL_TEXTURE_2D, 0, 0,0, im.w(), im.h(), GL_RGBA, GL_UNSIGNED_BYTE, m.data.data());
+						}
+						break;
+					}
+
+					GL_CHECK;
+					return j.handle;
+				}
+			}
+		}
+		
+		// (3) check for modified or (so far) unused entries with the same size
 		
 		for (auto &j : i->second)
 		{
-			if (j.type == ResourceInfo::Texture && j.modified && j.w == im.w() && j.h == im.h())
+			if (j.type == ResourceInfo::Texture && (j.modified || j.unused) && j.w == im.w() && j.h == im.h())
 			{
 				//DEBUG_TEXTURES("Texture (" << im.w() << " x " << im.h() << ") reused: " << j.handle);
 				
-				assert(j.unused);
 				j.alpha = alpha; if (base) j.base = *base;
 				j.baseUsed = base;
 				j.unused = temporary;
@@ -210,20 +309,10 @@ GL_Handle GL_RM::upload_texture(const GL_Image &im, float alpha, const GL_Color
 				j.type = ResourceInfo::Texture;
 				
 				// upload new data
+				const std::vector<unsigned char> &data = alpha < 0.0f ? im.data() : mix(im, key);
 				glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 				glBindTexture(GL_TEXTURE_2D, j.handle);
-				if (alpha < 0.0f)
-				{
-					glTexSubImage2D(GL_TEXTURE_2D, 0, 0,0, im.w(), im.h(), GL_RGBA, GL_UNSIGNED_BYTE, im.data().data());
-				}
-				else
-				{
-					std::vector<unsigned char> data;
-					if (base) im.mix(*base, alpha, data); else im.mix(alpha, data);
-					assert(data.size() == (size_t)im.w() * im.h() * 4);
-					
-					glTexSubImage2D(GL_TEXTURE_2D, 0, 0,0, im.w(), im.h(), GL_RGBA, GL_UNSIGNED_BYTE, data.data());
-				}
+				glTexSubImage2D(GL_TEXTURE_2D, 0, 0,0, im.w(), im.h(), GL_RGBA, GL_UNSIGNED_BYTE, data.data());
 				
 				GL_CHECK;
 				return j.handle;
@@ -231,7 +320,7 @@ GL_Handle GL_RM::upload_texture(const GL_Image &im, float alpha, const GL_Color
 		}
 	}
 
-	// (3) add new item
+	// (4) add new item
 
 	auto &v = resources[(GL_Resource*)(&im)];
 	v.emplace_back();
@@ -247,20 +336,10 @@ GL_Handle GL_RM::upload_texture(const GL_Image &im, float alpha, const GL_Color
 	j.modified = false;
 	j.type = ResourceInfo::Texture;
 
+	const std::vector<unsigned char> &data = alpha < 0.0f ? im.data() : mix(im, key);
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 	glBindTexture(GL_TEXTURE_2D, j.handle);
-	if (alpha < 0.0f)
-	{
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, im.w(), im.h(), 0, GL_RGBA, GL_UNSIGNED_BYTE, im.data().data());
-	}
-	else
-	{
-		std::vector<unsigned char> data;
-		if (base) im.mix(*base, alpha, data); else im.mix(alpha, data);
-		assert(data.size() == (size_t)im.w() * im.h() * 4);
-		
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, im.w(), im.h(), 0, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
-	}
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, im.w(), im.h(), 0, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
 	
 	GL_CHECK;
 	return j.handle;
@@ -1,7 +1,9 @@
 #pragma once
 #include <GL/gl.h>
 #include <set>
+#include <list>
 #include <vector>
+#include <future>
 #include <cassert>
 #include "GL_Color.h"
 #include "GL_AAMode.h"
@@ -67,6 +69,8 @@ public:
 	{
 		assert(!drawing);
 		
+		collect_mix();
+
 		for (auto &i : resources)
 		{
 			for (auto &j : i.second)
@@ -118,6 +122,8 @@ public:
 	void modified(const GL_Resource *r);
 	void deleted(const GL_Resource *r);
 
+	bool pending() const{ return mixing.valid(); } ///< Is some texture still drawn with outdated alpha/base?
+
 private:
 	void clear_unused();
 	GL_Handle upload_texture(const GL_Image &im, float alpha, const GL_Color *base, bool temporary);
@@ -147,6 +153,34 @@ private:
 	};
 	std::map<GL_Resource*, std::vector<ResourceInfo>> resources;
 	std::vector<ResourceInfo> orphans;
+
+	/*------------------------------------------------------------------------------------------------------------------
+	 Mixing images with alpha and base color (GL_Image::mix) is done on a worker thread if there is an older mix of
+	 the image to draw until it finishes. The last few mixes are kept, so going back and forth (like dragging the
+	 opacity slider) does not redo them.
+	 -----------------------------------------------------------------------------------------------------------------*/
+	struct Mix
+	{
+		const GL_Resource *im; // NULL if deleted or modified while mixing
+		size_t   state;        // im.state_counter()
+		float    alpha;
+		GL_Color base;
+		bool     baseUsed;
+		std::vector<unsigned char> data;
+		
+		bool matches(const Mix &m) const
+		{
+			return im == m.im && state == m.state && alpha == m.alpha && baseUsed == m.baseUsed && (!baseUsed || base == m.base);
+		}
+	};
+	std::list<Mix>    mixes;  // most recently used first
+	Mix               job;    // what mixing works on
+	std::future<void> mixing;
+	
+	const std::vector<unsigned char> &mix(const GL_Image &im, const Mix &key); // cached or done right away
+	void start_mix(const GL_Image &im, const Mix &key);
+	void collect_mix(); // moves a finished job to mixes
+	void forget_mixes(const GL_Resource *r);
 	
 	void end_subframe(); // called by draw_subframe to end the previous subframe
 };
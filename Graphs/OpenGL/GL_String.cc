@@ -12,7 +12,7 @@
 #endif
 
 #define GT GL_TEXTURE_RECTANGLE
-GL_String::GL_String(const std::string &text, const GL_Font &f) : texName(0), context(NULL), tex_w(-1)
+GL_String::GL_String(const std::string &text, const GL_Font &f) : texName(0), context(NULL), tex_w(-1), atlas(NULL)
 {
 	#ifdef _WINDOWS
 	
@@ -112,9 +112,23 @@ GL_String::GL_String(const std::string &text, const GL_Font &f) : texName(0), co
 	#endif
 }
 
+GL_String::GL_String(const std::string &text, const GL_GlyphAtlas &a)
+: texName(a.texName), context(NULL), tex_w(-1), tex_h(a.tex_h), frame_w(0.0f), frame_h(a.tex_h), atlas(&a), text(text)
+{
+	assert(a.covers(text));
+	int w = 0;
+	for (size_t i = 0, n = text.size(); i < n; ++i)
+	{
+		int c = text[i] - GL_GlyphAtlas::FIRST;
+		w += a.adv[c];
+		if (i+1 < n) w += a.kern[c][text[i+1] - GL_GlyphAtlas::FIRST];
+	}
+	frame_w = (float)(w / GL_GlyphAtlas::SCALE); // whole pixels, as in the pango-rendered strings
+}
+
 GL_String::~GL_String()
 {
-	if (texName) context.delete_texture(texName);
+	if (texName && !atlas) context.delete_texture(texName);
 }
 
 static inline void start_drawing(GLuint texName)
@@ -140,41 +154,59 @@ static inline void finish_drawing()
 	glPopAttrib();
 }
 
+void GL_String::draw_quad(const P3f &a, const P3f &b, const P3f &c, const P3f &d)
+{
+	if (!atlas)
+	{
+		start_drawing(texName);
+		glBegin(GL_QUADS);
+		glTexCoord2f( 0.0f,  0.0f); glVertex3fv(a);
+		glTexCoord2f( 0.0f, tex_h); glVertex3fv(b);
+		glTexCoord2f(tex_w, tex_h); glVertex3fv(c);
+		glTexCoord2f(tex_w,  0.0f); glVertex3fv(d);
+		glEnd();
+		finish_drawing();
+		return;
+	}
+	
+	// split the quad into one per glyph
+	if (frame_w <= 0.0f) return;
+	auto &V = atlas->vertexes;
+	auto &T = atlas->texcoords;
+	const float iw = 1.0f / frame_w, is = 1.0f / GL_GlyphAtlas::SCALE;
+	int x = 0;
+	for (size_t k = 0, n = text.size(); k < n; ++k)
+	{
+		int i = text[k] - GL_GlyphAtlas::FIRST;
+		float w = atlas->adv[i] * is;
+		if (text[k] != ' ')
+		{
+			float u0 = x*is*iw, u1 = u0 + w*iw, t0 = atlas->x[i], t1 = t0 + w;
+			P3f q[4] = { a + (d-a)*u0, b + (c-b)*u0, b + (c-b)*u1, a + (d-a)*u1 };
+			GLfloat t[8] = { t0, 0.0f, t0, tex_h, t1, tex_h, t1, 0.0f };
+			for (int k = 0; k < 4; ++k) V.insert(V.end(), (const float*)q[k], (const float*)q[k] + 3);
+			T.insert(T.end(), t, t + 8);
+		}
+		x += atlas->adv[i];
+		if (k+1 < n) x += atlas->kern[i][text[k+1] - GL_GlyphAtlas::FIRST];
+	}
+	if (!atlas->batching) atlas->flush();
+}
+
 void GL_String::draw(float x, float y, float w, float h)
 {
 	if (!texName) return;
-	start_drawing(texName);
-	glBegin(GL_QUADS);
-	glTexCoord2f( 0.0f,  0.0f); glVertex3f(x,     0.0f, y + h);
-	glTexCoord2f( 0.0f, tex_h); glVertex3f(x,     0.0f, y);
-	glTexCoord2f(tex_w, tex_h); glVertex3f(x + w, 0.0f, y);
-	glTexCoord2f(tex_w,  0.0f); glVertex3f(x + w, 0.0f, y + h);
-	glEnd();
-	finish_drawing();
+	draw_quad(P3f(x, 0.0f, y + h), P3f(x, 0.0f, y), P3f(x + w, 0.0f, y), P3f(x + w, 0.0f, y + h));
 }
 void GL_String::draw2d(float x, float y, float w, float h)
 {
 	if (!texName) return;
-	start_drawing(texName);
-	glBegin(GL_QUADS);
-	glTexCoord2f( 0.0f,  0.0f); glVertex2f(x,     y);
-	glTexCoord2f( 0.0f, tex_h); glVertex2f(x,     y + h);
-	glTexCoord2f(tex_w, tex_h); glVertex2f(x + w, y + h);
-	glTexCoord2f(tex_w,  0.0f); glVertex2f(x + w, y);
-	glEnd();
-	finish_drawing();
+	draw_quad(P3f(x, y, 0.0f), P3f(x, y + h, 0.0f), P3f(x + w, y + h, 0.0f), P3f(x + w, y, 0.0f));
 }
 void GL_String::draw(const P3f &p, const P3f &dx, const P3f &dy) // p is topleft
 {
 	if (!texName) return;
-	start_drawing(texName);
-	glBegin(GL_QUADS);
-	glTexCoord2f( 0.0f,  0.0f); glVertex3fv(p+dy);
-	glTexCoord2f( 0.0f, tex_h); glVertex3fv(p   );
-	glTexCoord2f(tex_w, tex_h); glVertex3fv(p+dx);
-	glTexCoord2f(tex_w,  0.0f); glVertex3fv(p+dx+dy);
-	glEnd();
-	finish_drawing();
+	draw_quad(p+dy, p, p+dx, p+dx+dy);
 }
 
 void GL_String::draw(const P3d &p_, HorizontalPosition hp, VerticalPosition vp, const Axis &axis, double scale)
@@ -201,14 +233,7 @@ void GL_String::draw(const P3d &p_, HorizontalPosition hp, VerticalPosition vp,
 	axis.map(p, pp);
 	axis.map(q, qq); // pp.z = qq.z = 0
 
-	start_drawing(texName);
-	glBegin(GL_QUADS);
-	glTexCoord2f( 0.0f,  0.0f); glVertex3f (pp.x, qq.y, 0.0f);
-	glTexCoord2f( 0.0f, tex_h); glVertex3fv(pp);
-	glTexCoord2f(tex_w, tex_h); glVertex3f (qq.x, pp.y, 0.0f);
-	glTexCoord2f(tex_w,  0.0f); glVertex3fv(qq);
-	glEnd();
-	finish_drawing();
+	draw_quad(P3f(pp.x, qq.y, 0.0f), pp, P3f(qq.x, pp.y, 0.0f), qq);
 }
 void GL_String::draw(const P3d &p_, const P3d &dx, const P3d &dy, HorizontalPosition hp, VerticalPosition vp, const Axis &axis, double scale)
 {
@@ -229,15 +254,12 @@ void GL_String::draw(const P3d &p_, const P3d &dx, const P3d &dy, HorizontalPosi
 		case TOP:     p -= dy*th; break;
 	}
 	
-	start_drawing(texName);
-	glBegin(GL_QUADS);
-	glTexCoord2f( 0.0f,  0.0f); vertex(p+dy*th, axis);
-	glTexCoord2f( 0.0f, tex_h); vertex(p, axis);
-	glTexCoord2f(tex_w, tex_h); vertex(p+dx*tw, axis);
-	glTexCoord2f(tex_w,  0.0f); vertex(p+dx*tw+dy*th, axis);
-	glEnd();
-	finish_drawing();
-
+	P3f a, b, c, d;
+	axis.map(p+dy*th, a);
+	axis.map(p, b);
+	axis.map(p+dx*tw, c);
+	axis.map(p+dx*tw+dy*th, d);
+	draw_quad(a, b, c, d);
 }
 void GL_String::draw_fixed(const P3d &p_, const P3d &dx, const P3d &dy, HorizontalPosition hp, VerticalPosition vp, double scale)
 {
@@ -258,14 +280,161 @@ void GL_String::draw_fixed(const P3d &p_, const P3d &dx, const P3d &dy, Horizont
 		case TOP:     p -= dy*th; break;
 	}
 	
+	draw_quad((P3f)(p+dy*th), (P3f)p, (P3f)(p+dx*tw), (P3f)(p+dx*tw+dy*th));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// GL_GlyphAtlas
+//----------------------------------------------------------------------------------------------------------------------
+
+#ifndef _WINDOWS
+/**
+ * Lays out text (ASCII only) and gets the advance of every glyph, which includes the kerning with the next one.
+ * @return false if pango did not make exactly one glyph of every character.
+ */
+static bool advances(PangoLayout *layout, const char *text, int n, std::vector<int> &adv)
+{
+	pango_layout_set_text(layout, text, n);
+	adv.assign(n, -1);
+	PangoLayoutLine *line = pango_layout_get_line_readonly(layout, 0);
+	if (!line || pango_layout_get_line_count(layout) != 1) return false;
+	for (GSList *r = line->runs; r; r = r->next)
+	{
+		const PangoGlyphItem *run = (const PangoGlyphItem*)r->data;
+		const PangoGlyphString *g = run->glyphs;
+		for (int i = 0; i < g->num_glyphs; ++i)
+		{
+			int c = run->item->offset + g->log_clusters[i];
+			if (c < 0 || c >= n || adv[c] >= 0) return false;
+			adv[c] = g->glyphs[i].geometry.width;
+		}
+	}
+	for (int a : adv) if (a < 0) return false;
+	return true;
+}
+#endif
+
+GL_GlyphAtlas *GL_GlyphAtlas::create(const GL_Font &f)
+{
+	#ifdef _WINDOWS
+	(void)f;
+	return NULL; // GL_String renders everything by itself there
+	#else
+	static_assert(SCALE == PANGO_SCALE, "GL_GlyphAtlas::SCALE");
+	cairo_surface_t *tmp = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 0, 0);
+	cairo_t *layout_context = cairo_create(tmp); cairo_surface_destroy(tmp);
+
+	PangoLayout *layout = pango_cairo_create_layout(layout_context);
+	std::string pf = format("%s %d", f.name.c_str(), (int)round(f.size));
+	PangoFontDescription *desc = pango_font_description_from_string(pf.c_str());
+	pango_layout_set_font_description(layout, desc); pango_font_description_free(desc);
+
+	// measure the glyphs and put them next to each other, with a free pixel in between
+	GL_GlyphAtlas *a = new GL_GlyphAtlas;
+	std::vector<int> adv, pair;
+	std::string s;
+	int W = 0, H = 0;
+	bool ok = true;
+	for (int c = FIRST; c <= LAST && ok; ++c)
+	{
+		s = (char)c;
+		ok = advances(layout, s.c_str(), 1, adv);
+		a->x[c-FIRST]   = (float)W;
+		a->adv[c-FIRST] = adv[0];
+		W += (adv[0] + SCALE-1) / SCALE + 1;
+	}
+
+	// kerning: in "c d0 c d1 c d2 ..." (without the spaces) every c has the advance it has before that d
+	for (int c = FIRST; c <= LAST && ok; ++c)
+	{
+		s.clear();
+		for (int d = FIRST; d <= LAST; ++d){ s += (char)c; s += (char)d; }
+		bool all = advances(layout, s.data(), (int)s.size(), adv);
+		for (int d = FIRST; d <= LAST; ++d)
+		{
+			// if some pair was merged, every pair of this row needs a layout of its own
+			int i = c-FIRST, j = d-FIRST;
+			char p[2] = { (char)c, (char)d };
+			bool m = !all && !advances(layout, p, 2, pair);
+			a->merged[i][j] = m;
+			a->kern[i][j] = m ? 0 : (all ? adv[2*j] : pair[0]) - a->adv[i];
+		}
+	}
+
+	// same height (and baseline) as every GL_String of this font
+	s.clear();
+	for (int c = FIRST; c <= LAST; ++c) s += (char)c;
+	pango_layout_set_text(layout, s.data(), (int)s.size());
+	pango_layout_get_size(layout, NULL, &H);
+	H /= PANGO_SCALE;
+	if (!ok || W <= 0 || H <= 0)
+	{
+		g_object_unref(layout);
+		cairo_destroy(layout_context);
+		delete a;
+		return NULL;
+	}
+	a->tex_h = (GLfloat)H;
+
+	unsigned char *bmp = new unsigned char[4*W*H];
+	memset(bmp, 0, 4*W*H);
+
+	cairo_surface_t *surface = cairo_image_surface_create_for_data(bmp, CAIRO_FORMAT_ARGB32, W, H, 4*W);
+	cairo_t *render_context  = cairo_create(surface);
+
+	auto &c = f.color;
+	cairo_set_source_rgba(render_context, c.r, c.g, c.b, 1.0);
+	for (int k = FIRST; k <= LAST; ++k)
+	{
+		char t[2] = { (char)k, 0 };
+		pango_layout_set_text(layout, t, 1);
+		cairo_move_to(render_context, a->x[k-FIRST], 0.0);
+		pango_cairo_show_layout(render_context, layout);
+	}
+	cairo_surface_flush(surface);
+
+	glPushAttrib(GL_TEXTURE_BIT);
+	glGenTextures(1, &a->texName);
+	glBindTexture(GT, a->texName);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexImage2D(GT, 0, GL_RGBA, W, H, 0, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, bmp);
+	glPopAttrib();
+
+	g_object_unref(layout);
+	cairo_destroy(layout_context);
+	cairo_destroy(render_context);
+	cairo_surface_destroy(surface);
+	delete[] bmp;
+	return a;
+	#endif
+}
+
+GL_GlyphAtlas::~GL_GlyphAtlas()
+{
+	if (texName) context.delete_texture(texName);
+}
+
+bool GL_GlyphAtlas::covers(const std::string &s) const
+{
+	if (s.empty()) return false;
+	for (char c : s) if (c < FIRST || c > LAST) return false; // this includes all of UTF-8's multibyte chars
+	for (size_t i = 1, n = s.size(); i < n; ++i) if (merged[s[i-1]-FIRST][s[i]-FIRST]) return false;
+	return true;
+}
+
+void GL_GlyphAtlas::flush() const
+{
+	if (vertexes.empty()) return;
 	start_drawing(texName);
-	glBegin(GL_QUADS);
-	glTexCoord2f( 0.0f,  0.0f); glVertex3dv(p+dy*th);
-	glTexCoord2f( 0.0f, tex_h); glVertex3dv(p);
-	glTexCoord2f(tex_w, tex_h); glVertex3dv(p+dx*tw);
-	glTexCoord2f(tex_w,  0.0f); glVertex3dv(p+dx*tw+dy*th);
-	glEnd();
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, vertexes.data());
+	glTexCoordPointer(2, GL_FLOAT, 0, texcoords.data());
+	glDrawArrays(GL_QUADS, 0, (GLsizei)(vertexes.size() / 3));
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
 	finish_drawing();
-	
+	vertexes.clear();
+	texcoords.clear();
 }
-
@@ -3,15 +3,52 @@
 #include "GL_Context.h"
 #include "../Geometry/Axis.h"
 #include <string>
+#include <vector>
 #include <GL/gl.h>
 
 enum VerticalPosition  { TOP  = -1, VCENTER = 0, BOTTOM = 1 };
 enum HorizontalPosition{ LEFT = -1, HCENTER = 0, RIGHT  = 1 };
 
+/**
+ * The printable ASCII characters of one font, rendered once into a shared texture. Strings that use nothing
+ * else are drawn from it glyph by glyph, so new labels need no text layout and no texture upload.
+ */
+class GL_GlyphAtlas
+{
+public:
+	static GL_GlyphAtlas *create(const GL_Font &f); ///< NULL if not supported on this platform
+	~GL_GlyphAtlas();
+
+	GL_GlyphAtlas(const GL_GlyphAtlas &) = delete;
+	GL_GlyphAtlas &operator=(const GL_GlyphAtlas &) = delete;
+
+	bool covers(const std::string &s) const; ///< Can s be drawn from the atlas?
+
+	/// While batching, quads are collected and only drawn by flush (with the GL state at that time).
+	void batch(bool b){ if (!b) flush(); batching = b; }
+	void flush() const;
+
+private:
+	friend class GL_String;
+	enum { FIRST = 32, LAST = 126, N = LAST-FIRST+1, SCALE = 1024 }; // advances are in 1/SCALE pixels, like pango's
+	GL_GlyphAtlas() : context(NULL), texName(0), batching(false){ }
+
+	GL_Context context; // context that contains the texture
+	GLuint     texName;
+	GLfloat    tex_h;   // height of every string, same as for the pango-rendered ones
+	float      x[N];    // position in the texture
+	int        adv[N];  // advance of every glyph
+	int        kern[N][N];   // correction of adv[i] if followed by j
+	bool       merged[N][N]; // i followed by j does not give two glyphs (ligatures, ...)
+	bool       batching;
+	mutable std::vector<GLfloat> vertexes, texcoords; // quads to draw
+};
+
 class GL_String
 {
 public:
 	GL_String(const std::string &s, const GL_Font &f);
+	GL_String(const std::string &s, const GL_GlyphAtlas &atlas); // s must be covered by atlas
 	~GL_String();
 
 	GL_String(const GL_String &) = delete;
@@ -33,4 +70,9 @@ private:
 	GLuint     texName;
 	GLfloat    tex_w, tex_h;     // size of the texture
 	float      frame_w, frame_h; // size of the string
+	
+	const GL_GlyphAtlas *atlas; // draw from there instead of texName if not NULL
+	std::string          text;
+
+	void draw_quad(const P3f &top_left, const P3f &bottom_left, const P3f &bottom_right, const P3f &top_right);
 };
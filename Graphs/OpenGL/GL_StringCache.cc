@@ -5,6 +5,8 @@ void GL_StringCache::clear()
 	for (auto &i : cache) delete i.second;
 	cache.clear();
 	unused.clear();
+	for (GL_GlyphAtlas *a : atlases) if (a){ a->flush(); delete a; }
+	atlases.clear();
 }
 
 void GL_StringCache::fonts(std::vector<GL_Font> &&F)
@@ -24,9 +26,11 @@ void GL_StringCache::font(const GL_Font &F)
 	cf = 0;
 }
 
-void GL_StringCache::start()
+void GL_StringCache::start(bool batch)
 {
 	for (auto &i : cache) unused.insert(i.first);
+	batching = batch;
+	for (GL_GlyphAtlas *a : atlases) if (a) a->batch(batch);
 }
 GL_String *GL_StringCache::get(const std::string &s)
 {
@@ -37,12 +41,24 @@ GL_String *GL_StringCache::get(const std::string &s)
 		unused.erase(k);
 		return cache[k];
 	}
-	GL_String *gls = new GL_String(s, _fonts[cf]);
+	if (atlases.empty())
+	{
+		for (auto &f : _fonts)
+		{
+			atlases.push_back(GL_GlyphAtlas::create(f));
+			if (atlases.back()) atlases.back()->batch(batching);
+		}
+	}
+	GL_GlyphAtlas *a = atlases[cf];
+	GL_String *gls = a && a->covers(s) ? new GL_String(s, *a) : new GL_String(s, _fonts[cf]);
 	cache[k] = gls;
 	return gls;
 }
 void GL_StringCache::finish()
 {
+	for (GL_GlyphAtlas *a : atlases) if (a) a->batch(false);
+	batching = false;
+
 	for (auto &k : unused)
 	{
 		delete cache[k];
@@ -53,5 +69,6 @@ void GL_StringCache::finish()
 GL_StringCache::~GL_StringCache()
 {
 	for (auto &i : cache) delete i.second;
+	for (GL_GlyphAtlas *a : atlases) delete a;
 }
 
@@ -7,13 +7,15 @@
 class GL_StringCache
 {
 public:
-	GL_StringCache() : cf(-1){ }
+	GL_StringCache() : cf(-1), batching(false){ }
 	~GL_StringCache();
 	
 	GL_StringCache(const GL_StringCache &) = delete;
 	GL_StringCache &operator=(const GL_StringCache &) = delete;
 
-	void start();
+	/// With batch set, strings that come from a glyph atlas are only drawn by finish, all at once. Everything
+	/// that affects their drawing (transformation, blending, ...) must then stay the same until then.
+	void start(bool batch = false);
 	void finish();
 	GL_String *get(const std::string &s);
 
@@ -27,6 +29,8 @@ private:
 	std::set<Key> unused;
 	int cf; // current_font
 	std::vector<GL_Font> _fonts;
+	std::vector<GL_GlyphAtlas*> atlases; // for every font, created on demand, can be NULL
+	bool batching;
 
 	void clear();
 };
@@ -5,6 +5,8 @@
 #include "../Utility/Preferences.h"
 #include "../Engine/Namespace/RootNamespace.h"
 #include "OpenGL/GL_Context.h"
+#include "Graphics/SharedGrid.h"
+#include "../Engine/Parser/EvalProfile.h"
 #include <GL/gl.h>
 #include <cassert>
 #include <algorithm>
@@ -175,26 +177,30 @@ void Plot::update_axis()
 	camera.orthogonal(axis.type() == Axis::Rect || axis.type() == Axis::Invalid);
 }
 
-void Plot::draw(GL_RM &rm, int n_threads, bool accum_ok, bool for_animation) const
+size_t Plot::update_graphs(int n_threads, double q) const
 {
-	double t0 = now();
-	size_t updated = 0, visible = 0;
-	
-	if (anim_qf < 0.0) anim_qf = 0.0; else if (anim_qf > 0.999) anim_qf = 0.999;
-	double q = (for_animation ? anim_qf : 1.0);
+	size_t updated = 0;
+
+	// graphs that sample the same grid are evaluated together and use that until shared goes out of scope
+	// (not while profiling, where every graph needs its own counters)
+	std::vector<std::unique_ptr<SharedGrid>> shared;
+	if (Preferences::fuseGraphs() && !Preferences::profileExpressions())
+	{
+		try
+		{
+			SharedGrid::create(graphs, q, n_threads, shared);
+		}
+		catch(const std::bad_alloc &)
+		{
+			shared.clear(); // ignore, update every graph on its own
+		}
+	}
 	
-	std::vector<GL_Graph*> area_graphs, line_graphs, image_graphs, all_graphs;
 	for (const Graph *g : graphs)
 	{
 		if (g->options.hidden) continue;
 		GL_Graph *gl = g->gl_graph();
 		if (!gl) continue;
-		all_graphs.push_back(gl);
-		(g->isColor() ? image_graphs :
-		 g->isArea()  ? area_graphs  :
-		 line_graphs).push_back(gl);
-		
-		++visible;
 		
 		if (g->needs_update())
 		{
@@ -213,6 +219,43 @@ void Plot::draw(GL_RM &rm, int n_threads, bool accum_ok, bool for_animation) con
 			}
 		}
 	}
+	return updated;
+}
+
+void Plot::print_profile(std::ostream &o) const
+{
+	for (size_t i = 0; i < graphs.size(); ++i)
+	{
+		const EvalProfile *p = graphs[i]->last_profile();
+		if (!p) continue;
+		o << "Graph " << i+1 << ": " << graphs[i]->description_line() << "\n";
+		p->print(o);
+		o << "\n";
+	}
+}
+
+void Plot::draw(GL_RM &rm, int n_threads, bool accum_ok, bool for_animation) const
+{
+	double t0 = now();
+	
+	if (anim_qf < 0.0) anim_qf = 0.0; else if (anim_qf > 0.999) anim_qf = 0.999;
+	double q = (for_animation ? anim_qf : 1.0);
+	
+	size_t updated = update_graphs(n_threads, q), visible = 0;
+	
+	std::vector<GL_Graph*> area_graphs, line_graphs, image_graphs, all_graphs;
+	for (const Graph *g : graphs)
+	{
+		if (g->options.hidden) continue;
+		GL_Graph *gl = g->gl_graph();
+		if (!gl) continue;
+		all_graphs.push_back(gl);
+		(g->isColor() ? image_graphs :
+		 g->isArea()  ? area_graphs  :
+		 line_graphs).push_back(gl);
+		
+		++visible;
+	}
 	
 	if (axis.type() == Axis::Box || axis.type() == Axis::Sphere)
 	{
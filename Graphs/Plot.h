@@ -70,6 +70,8 @@ struct Plot : public Serializable
 	void   set_current_graph(int    i);
 	
 	void draw(GL_RM &rm, int n_threads, bool accum_ok, bool for_animation) const;
+	size_t update_graphs(int n_threads, double quality) const; // recalc visible graphs that need it (no GL calls)
+	void print_profile(std::ostream &o) const; // EvalProfiles of all graphs that have one
 	void update_axis(); // sync axis to current plot settings
 	void update(ChangeType t){ for (Graph *g : graphs) g->update(t); }
 	void recalc(){ update(CH_UNKNOWN); }
@@ -98,6 +100,16 @@ struct Plot : public Serializable
 	}
 	bool needs_update() const{ for (Graph *g : graphs) if (!g->options.hidden && g->needs_update()) return true; return false; }
 	bool at_full_quality() const{ return last_update_was_full_quality; }
+	bool deep_zoom() const // can axis.zoom go below double precision? (@see Axis::zoom)
+	{
+		for (Graph *g : graphs)
+		{
+			if (g->options.hidden) continue;
+			GL_Graph *gl = g->gl_graph();
+			if (gl && gl->deep_zoom()) return true;
+		}
+		return false;
+	}
 
 private:
 	std::vector<Graph*> graphs;
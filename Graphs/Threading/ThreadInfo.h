@@ -1,6 +1,7 @@
 #pragma once
 #include "../Graphics/Info.h"
 #include "../../Engine/Parser/BoundContext.h"
+#include "../../Engine/Parser/FloatContext.h"
 
 //----------------------------------------------------------------------------------------------------------------------
 // ThreadInfo
@@ -26,22 +27,43 @@ struct ThreadInfo
 
 	
 	ThreadInfo(const DI_Calc &ic, const DI_Axis &ia, const DI_Subdivision &is, const DI_Grid &ig)
-	: ic(ic), ia(ia), is(is), ig(ig), ec(*ic.e0){}
+	: ic(ic), ia(ia), is(is), ig(ig), ec(*ic.e0, ic.draft), fc(ic.single ? new FloatContext(*ic.e0) : NULL)
+	, values(NULL)
+	{
+		if (ic.profile) ec.profile(ic.profile);
+	}
+	~ThreadInfo(){ delete fc; }
 	
 	BoundContext          ec;
 	const DI_Calc        &ic;
 	const DI_Axis        &ia;
 	const DI_Subdivision &is;
 	const DI_Grid        &ig;
-	char  padding[128-sizeof(EvalContext)-4*8];
+	FloatContext         *fc;     // replaces ec in the eval methods if set (@see DI_Calc::single)
+	const cnum           *values; // if set, the extract methods read from here instead of ec (fc's outputs or precomputed)
+	char  padding[128-sizeof(EvalContext)-6*8];
 
 	//------------------------------------------------------------------------------------------------------------------
 	// computation
 	//------------------------------------------------------------------------------------------------------------------
 
+	inline const cnum &output(int i) const{ return values ? values[i] : ec.output(i); }
+	
+	// ec always gets the inputs too, for the points where fc goes out of range
+	inline void set_input(int i, double x){ if (fc) fc->set_input(i, x); ec.set_input(i, x); }
+	inline void run()
+	{
+		if (fc && fc->eval()){ values = fc->outputs(); return; }
+		values = NULL;
+		ec.eval();
+	}
+	#ifdef DEBUG
+	inline bool holds(int i, double x) const{ return ec.input(i).real() == x && (!fc || fc->input(i) == (float)x); }
+	#endif
+
 	inline void extract_complex(double u, double v, P3f &p, bool &exists)
 	{
-		const cnum &z = ec.output(0);
+		const cnum &z = output(0);
 		if ((exists = defined(z)))
 		{
 			P3d dp;
@@ -67,7 +89,7 @@ struct ThreadInfo
 		{
 			case 1: // (u,0,f(u)) or (u,f(u),0)
 			{
-				const cnum &xc = ec.output(0);
+				const cnum &xc = output(0);
 				if ((exists = is_real(xc)))
 				{
 					if (ic.embed_XZ)
@@ -86,8 +108,8 @@ struct ThreadInfo
 				
 			case 2: // (fx, 0, fy) or (fx, fy, 0)
 			{
-				const cnum &xc = ec.output(0);
-				const cnum &yc = ec.output(1);
+				const cnum &xc = output(0);
+				const cnum &yc = output(1);
 				if ((exists = (is_real(xc) && is_real(yc))))
 				{
 					P3d dp;
@@ -130,9 +152,9 @@ struct ThreadInfo
 				
 			case 3: // (fx, fy, fz)
 			{
-				const cnum &xc = ec.output(0);
-				const cnum &yc = ec.output(1);
-				const cnum &zc = ec.output(2);
+				const cnum &xc = output(0);
+				const cnum &yc = output(1);
+				const cnum &zc = output(2);
 				if ((exists = (is_real(xc) && is_real(yc) && is_real(zc))))
 				{
 					P3d dp;
@@ -178,7 +200,7 @@ struct ThreadInfo
 		{
 			case 1: // (u,v,f(u,v)) - embed_XZ must be handled by caller!
 			{
-				const cnum &xc = ec.output(0);
+				const cnum &xc = output(0);
 				if ((exists = is_real(xc)))
 				{
 					P3d dp(u, v, xc.real());
@@ -189,8 +211,8 @@ struct ThreadInfo
 				
 			case 2: // (fx, 0, fy) or (fx, fy, 0)
 			{
-				const cnum &xc = ec.output(0);
-				const cnum &yc = ec.output(1);
+				const cnum &xc = output(0);
+				const cnum &yc = output(1);
 				if ((exists = (is_real(xc) && is_real(yc))))
 				{
 					P3d dp;
@@ -233,9 +255,9 @@ struct ThreadInfo
 				
 			case 3: // (fx, fy, fz)
 			{
-				const cnum &xc = ec.output(0);
-				const cnum &yc = ec.output(1);
-				const cnum &zc = ec.output(2);
+				const cnum &xc = output(0);
+				const cnum &yc = output(1);
+				const cnum &zc = output(2);
 				if ((exists = (is_real(xc) && is_real(yc) && is_real(zc))))
 				{
 					P3d dp;
@@ -281,8 +303,8 @@ struct ThreadInfo
 		{
 			case 2: // (fx, 0, fy) or (fx, fy, 0)
 			{
-				const cnum &xc = ec.output(0);
-				const cnum &yc = ec.output(1);
+				const cnum &xc = output(0);
+				const cnum &yc = output(1);
 				if ((exists = (is_real(xc) && is_real(yc))))
 				{
 					P3d dp;
@@ -325,9 +347,9 @@ struct ThreadInfo
 				
 			case 3: // (fx, fy, fz)
 			{
-				const cnum &xc = ec.output(0);
-				const cnum &yc = ec.output(1);
-				const cnum &zc = ec.output(2);
+				const cnum &xc = output(0);
+				const cnum &yc = output(1);
+				const cnum &zc = output(2);
 				if ((exists = (is_real(xc) && is_real(yc) && is_real(zc))))
 				{
 					P3d dp;
@@ -367,13 +389,75 @@ struct ThreadInfo
 		}
 	}
 	
+	// derivative of the point with coordinates q when they change by d
+	inline void tangent(const double *q, const double *d, P3d &t) const
+	{
+		if (ic.polar) // (r cos(phi), r sin(phi), z)
+		{
+			double s, c; sincos(q[1], s, c);
+			t.set(d[0]*c - q[0]*s*d[1], d[0]*s + q[0]*c*d[1], d[2]);
+		}
+		else if (ic.spherical) // r (sin(theta) cos(phi), sin(theta) sin(phi), cos(theta))
+		{
+			double sp, cp, st, ct;
+			sincos(q[1], sp, cp);
+			sincos(q[2], st, ct);
+			double a = d[0]*st + q[0]*ct*d[2], b = q[0]*st*d[1]; // (r sin(theta))' and r sin(theta) phi'
+			t.set(a*cp - b*sp, a*sp + b*cp, d[0]*ct - q[0]*st*d[2]);
+		}
+		else
+		{
+			t.set(d[0], d[1], d[2]);
+		}
+	}
+	
+	/// Exact normal at the point of the last eval from the derivatives (@see DI_Calc::jet). Oriented like
+	/// the faces of the grid, i.e. (dp/du) x (dp/dv). Returns false if it is undefined or the surface is
+	/// singular there.
+	inline bool extract_normal(P3f &n) const
+	{
+		assert(ic.jet > 0 && !ic.complex);
+		const int d = ic.dim;
+		if (d != 1 && d != 3) return false;
+		
+		double q[3], du[3], dv[3];
+		for (int i = 0; i < d; ++i)
+		{
+			const cnum &a = output(i), &b = output(ic.jet + i), &c = output(ic.jet + d + i);
+			if (!is_real(a) || !is_real(b) || !is_real(c)) return false;
+			q[i] = a.real(); du[i] = b.real(); dv[i] = c.real();
+		}
+		
+		// the axis mapping is a uniform scaling, so it does not change the direction
+		P3d nd;
+		double l;
+		if (d == 1) // (u, v, f(u,v))
+		{
+			nd.set(-du[0], -dv[0], 1.0);
+			l = nd.abs();
+			if (!(l < INFINITY)) return false;
+		}
+		else
+		{
+			P3d tu, tv;
+			tangent(q, du, tu);
+			tangent(q, dv, tv);
+			cross(nd, tu, tv);
+			l = nd.abs();
+			if (!(l > 1e-9 * tu.abs() * tv.abs() && l < INFINITY)) return false;
+		}
+		nd /= l;
+		n = (P3f)nd;
+		return true;
+	}
+	
 	inline void eval(double t, P3f &p, bool &exists)
 	{
 		assert(!ic.complex && !ic.vector_field && (ic.dim == 1 || !ic.embed_XZ));
 		
-		if (ic.xi >= 0) ec.set_input(ic.xi, t);
+		if (ic.xi >= 0) set_input(ic.xi, t);
 		
-		ec.eval();
+		run();
 		extract_real(t, p, exists);
 	}
 	
@@ -389,17 +473,40 @@ struct ThreadInfo
 		}
 		else
 		{
-			if (!same_u && ic.xi >= 0) ec.set_input(ic.xi, u);
-			if (!same_v && ic.yi >= 0) ec.set_input(ic.yi, v);
+			if (!same_u && ic.xi >= 0) set_input(ic.xi, u);
+			if (!same_v && ic.yi >= 0) set_input(ic.yi, v);
 			#ifdef DEBUG
-			if (same_u && ic.xi >= 0) assert(ec.input(ic.xi).real() == u);
-			if (same_v && ic.yi >= 0) assert(ec.input(ic.yi).real() == v);
+			if (same_u && ic.xi >= 0) assert(holds(ic.xi, u));
+			if (same_v && ic.yi >= 0) assert(holds(ic.yi, v));
 			#endif
-			ec.eval();
+			run();
 			extract_real(u, v, p, exists);
 		}
 	}
 	
+	inline void extract(double u, double v, const cnum *precomputed, P3f &p, bool &exists)
+	{
+		// like eval, but for outputs that were already calculated (@see SharedGrid)
+		assert(!ic.vector_field);
+		const cnum *v0 = values;
+		values = precomputed;
+		if (ic.complex)
+			extract_complex(u, v, p, exists);
+		else
+			extract_real(u, v, p, exists);
+		values = v0;
+	}
+	
+	inline bool extract_normal(const cnum *precomputed, P3f &n)
+	{
+		// like extract_normal, for outputs that were already calculated (@see SharedGrid::jet)
+		const cnum *v0 = values;
+		values = precomputed;
+		bool ok = extract_normal(n);
+		values = v0;
+		return ok;
+	}
+	
 	inline void eval_vector(double u, double v, P3f &p, bool &exists, bool same_u = false, bool same_v = false)
 	{
 		assert(ic.vector_field && !ic.complex);
@@ -434,15 +541,15 @@ struct ThreadInfo
 	{
 		assert(ic.dim == 1 && !ic.complex);
 		
-		if (!same_u && ic.xi >= 0) ec.set_input(ic.xi, u);
-		if (!same_v && ic.yi >= 0) ec.set_input(ic.yi, v);
+		if (!same_u && ic.xi >= 0) set_input(ic.xi, u);
+		if (!same_v && ic.yi >= 0) set_input(ic.yi, v);
 		#ifdef DEBUG
-		if (same_u && ic.xi >= 0) assert(ec.input(ic.xi).real() == u);
-		if (same_v && ic.yi >= 0) assert(ec.input(ic.yi).real() == v);
+		if (same_u && ic.xi >= 0) assert(holds(ic.xi, u));
+		if (same_v && ic.yi >= 0) assert(holds(ic.yi, v));
 		#endif
-		ec.eval();
+		run();
 		
-		const cnum &xc = ec.output(0);
+		const cnum &xc = output(0);
 		return is_real(xc) ? xc.real() : UNDEFINED;
 	}
 
@@ -450,17 +557,17 @@ struct ThreadInfo
 	{
 		assert(ic.dim == 1 && !ic.complex);
 		
-		if (!same_u && ic.xi >= 0) ec.set_input(ic.xi, u);
-		if (!same_v && ic.yi >= 0) ec.set_input(ic.yi, v);
-		if (!same_w && ic.zi >= 0) ec.set_input(ic.zi, w);
+		if (!same_u && ic.xi >= 0) set_input(ic.xi, u);
+		if (!same_v && ic.yi >= 0) set_input(ic.yi, v);
+		if (!same_w && ic.zi >= 0) set_input(ic.zi, w);
 		#ifdef DEBUG
-		if (same_u && ic.xi >= 0) assert(ec.input(ic.xi).real() == u);
-		if (same_v && ic.yi >= 0) assert(ec.input(ic.yi).real() == v);
-		if (same_w && ic.zi >= 0) assert(ec.input(ic.zi).real() == w);
+		if (same_u && ic.xi >= 0) assert(holds(ic.xi, u));
+		if (same_v && ic.yi >= 0) assert(holds(ic.yi, v));
+		if (same_w && ic.zi >= 0) assert(holds(ic.zi, w));
 		#endif
-		ec.eval();
+		run();
 		
-		const cnum &xc = ec.output(0);
+		const cnum &xc = output(0);
 		return is_real(xc) ? xc.real() : UNDEFINED;
 	}
 
@@ -1,4 +1,5 @@
 #include "ThreadMap.h"
+#include "../../Utility/Timer.h"
 
 #include <cassert>
 #include <iostream>
@@ -126,6 +127,7 @@ void WorkUnit::start(int i)
 WorkLayer::WorkLayer(const std::string &name, Task *t, WorkLayer *down, int space_, int range_below_, int offset_)
 : name(name), task(t), below(down), above(NULL), space(space_), range_below(range_below_), offset(offset_)
 , next_todo(0), unfinished(0), cyclic(false)
+, t_first(0.0), t_last(0.0), busy(0.0)
 {
 	assert(range_below == 0 || below != NULL);
 	if (space < 0) space = 0;
@@ -155,6 +157,15 @@ void WorkLayer::finish(WorkUnit *u)
 	release();
 }
 
+void WorkLayer::record(double t0, double t1)
+{
+	if (!acquire(true)){ assert(false); return; }
+	if (t_first == 0.0 || t0 < t_first) t_first = t0;
+	if (t1 > t_last) t_last = t1;
+	busy += t1 - t0;
+	release();
+}
+
 WorkUnit *WorkLayer::get(int &i)
 {
 	int n = (int)units.size();
@@ -184,6 +195,8 @@ WorkUnit *WorkLayer::get(int &i)
 // Task
 //----------------------------------------------------------------------------------------------------------------------
 
+void (*Task::profiler)(const LayerTiming &t) = NULL;
+
 WorkUnit *Task::get(int &i)
 {
 	WorkLayer *a = active;
@@ -214,7 +227,16 @@ void *Task::run_thread(void *task_)
 		while (u = task->get(i))
 		{
 			u->start(i);
-			u->work(data);
+			if (profiler)
+			{
+				double t0 = now();
+				u->work(data);
+				u->layer->record(t0, now());
+			}
+			else
+			{
+				u->work(data);
+			}
 			u->finish();
 			#ifdef USE_PTHREADS
 			sched_yield();
@@ -19,6 +19,17 @@ class Task;
 // Task class handles the thread_data 
 typedef std::function<void(void *thread_data)> Work;
 
+/**
+ * Timing of one WorkLayer, reported to Task::profiler (if it is set) when the layer's Task is deleted.
+ */
+struct LayerTiming
+{
+	const std::string &name;
+	size_t units;
+	double wall; ///< seconds from the start of the first unit until the last one finished
+	double busy; ///< sum of the work times of all units (excluding waiting for dependencies)
+};
+
 /**
  * Part of a WorkLayer. Distinguished from its siblings in the same layer by the data in its work lambda.
  * If the WorkLayer plows through some loop then one WorkUnit is typically some part of the loop where
@@ -146,6 +157,11 @@ private:
 	 */
 	void finish(WorkUnit *u);
 	
+	/**
+	 * Add the time unit u worked from t0 to t1 (only if Task::profiler is set).
+	 */
+	void record(double t0, double t1);
+	
 	WorkLayer *above, *below;     ///< Doubly linked list.
 	Task      *task;              ///< Task that this belongs to.
 	Mutex      lock;              ///< Lock for all state updates.
@@ -158,6 +174,7 @@ private:
 	int space;                    ///< Every unit blocks the next and previous space units
 	int range_below, offset;      ///< For getting blocked by the lower Layer
 	std::string name;             ///< For printing/debugging
+	double t_first, t_last, busy; ///< For Task::profiler
 
 	
 	/* Some work order examples:
@@ -238,12 +255,19 @@ public:
 		{
 			WorkLayer *tmp = w;
 			w = w->above;
+			if (profiler) profiler(LayerTiming{tmp->name, tmp->units.size(), tmp->t_last - tmp->t_first, tmp->busy});
 			delete tmp;
 		}
 	}
 	
 	void run(int n_threads); ///< Creates worker threads and runs the entire task.
 	
+	/**
+	 * If set, all units of all tasks are timed and this is called for every layer when its task is deleted
+	 * (from the thread that deletes it). Only meant for benchmarking, set it before running any tasks.
+	 */
+	static void (*profiler)(const LayerTiming &t);
+	
 private:
 	WorkUnit *get(int &its_index); ///< @return The next work unit in State::TODO or NULL if the task is done.
 	
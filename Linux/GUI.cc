@@ -106,6 +106,7 @@ void GUI::update()
 	confirmation_panel();
 	prefs_panel();
 	help_panel();
+	profile_panel();
 
 	#ifdef DEBUG
 	if (show_demo_window) ImGui::ShowDemoWindow(&show_demo_window);
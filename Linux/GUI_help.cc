@@ -259,8 +259,8 @@ void GUI::help_panel()
 				ROW2("cblend", "Similar to blend, but uses s = (1 + cos(pi t))/2, which gives cblend(z,w,2k) = z and cblend(z,w,2k+1) = w. Tends to look better in animation. If t is complex, its imaginary part is ignored.");
 				ROW2("mix", "mix(z,w,t) = (1-t)z + tw. Unlike blend and cblend, does not ignore t's imaginary part.");
 				ROW2("fowler", "Returns the Fowler angle of a complex number. Result is in the range [0,8).");
-				ROW2("julia", "julia(z,c) = 1 if z is in the Julia set for c (the numbers for which the iteration z >> z²+c stays finite), otherwise closer to 0, depending on how quickly it diverges.");
-				ROW2("mandel", "mandel(c) = 1 if c is in the Mandelbrot set (the numbers for which the iteration z >> z²+c stays finite when starting with z = 0), otherwise closer to 0, depending on how quickly it diverges.");
+				ROW2("julia", "julia(z,c) = 1 if z is in the Julia set for c (the numbers for which the iteration z >> z²+c stays finite), otherwise closer to 0, depending on how quickly it diverges. julia(z,c,n) iterates at most n times instead of 150.");
+				ROW2("mandel", "mandel(c) = 1 if c is in the Mandelbrot set (the numbers for which the iteration z >> z²+c stays finite when starting with z = 0), otherwise closer to 0, depending on how quickly it diverges. mandel(c,n) iterates at most n times instead of 150. Color graphs of f(z) = mandel(z) or julia(z,c) can be zoomed in much further than other graphs.");
 
 				ImGui::EndTable();
 				#undef HEADING
@@ -1,5 +1,6 @@
 #include "GUI.h"
 #include "imgui/imgui.h"
+#include "PlotWindow.h"
 #include "../Utility/Preferences.h"
 
 void GUI::prefs_panel()
@@ -35,10 +36,32 @@ void GUI::prefs_panel()
 	ImGui::Checkbox("Reduce Quality During Animation", &b);
 	if (b != b0) { Preferences::dynamic(b); redraw(); }
 
+	b0 = Preferences::draftPrecision(); b = b0;
+	ImGui::Checkbox("Fast Approximate Math During Animation", &b);
+	if (b != b0) { Preferences::draftPrecision(b); redraw(); }
+
 	b0 = Preferences::depthSort(); b = b0;
 	ImGui::Checkbox("Depth Sorting", &b);
 	if (b != b0) { Preferences::depthSort(b); redraw(); }
 
+	b0 = Preferences::textureFiltering(); b = b0;
+	ImGui::Checkbox("Smooth Color Graph Textures", &b);
+	if (b != b0) { Preferences::textureFiltering(b); w.recalc(w.plot); }
+
+	ImGui::Text("Color Graph Antialiasing");
+	{
+		static const char *items[] = { "Off", "4x Edges", "8x Edges" };
+		i0 = Preferences::colorSamples(); i = i0;
+		int k = (i == 8 ? 2 : i == 4 ? 1 : 0);
+		ImGui::Combo("##colorAA", &k, items, IM_ARRAYSIZE(items));
+		i = (k == 2 ? 8 : k == 1 ? 4 : 1);
+		if (i != i0) { Preferences::colorSamples(i); w.recalc(w.plot); }
+	}
+
+	b0 = Preferences::fuseGraphs(); b = b0;
+	ImGui::Checkbox("Evaluate Graphs on Same Grid Together", &b);
+	if (b != b0) { Preferences::fuseGraphs(b); w.recalc(w.plot); }
+
 	ImGui::Spacing();
 	ImGui::Spacing();
 	ImGui::Spacing();
@@ -0,0 +1,73 @@
+#include "GUI.h"
+#include "imgui/imgui.h"
+#include "PlotWindow.h"
+#include "../Engine/Parser/EvalProfile.h"
+#include "../Utility/Preferences.h"
+#include <fstream>
+
+static constexpr ImGuiTableFlags table_flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg;
+
+void GUI::profile_panel()
+{
+	if (!show_profile_panel) return;
+	ImGui::SetNextWindowBgAlpha(0.85f);
+	if (!ImGui::Begin("Profile", &show_profile_panel)) { ImGui::End(); return; }
+
+	Plot &plot = w.plot;
+
+	bool b0 = Preferences::profileExpressions(), b = b0;
+	ImGui::Checkbox("Collect Profile", &b);
+	if (b != b0) { Preferences::profileExpressions(b); w.recalc(plot); }
+	ImGui::SameLine();
+	if (ImGui::Button("Reset"))
+	{
+		for (int i = 0, n = plot.number_of_graphs(); i < n; ++i)
+		{
+			EvalProfile *p = plot.graph(i)->last_profile();
+			if (p) p->clear();
+		}
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Save"))
+	{
+		std::string path = (Preferences::directory() / "profile.txt").string();
+		std::ofstream f(path);
+		plot.print_profile(f);
+		if (!f) error("Error writing " + path);
+	}
+	if (!b) ImGui::TextWrapped("Counts the calls and clock ticks of every step of the compiled expressions while the graphs are calculated. This makes the calculation slower and disables the shared evaluation of graphs on the same grid.");
+
+	for (int i = 0, n = plot.number_of_graphs(); i < n; ++i)
+	{
+		const Graph *g = plot.graph(i);
+		const EvalProfile *p = g->last_profile();
+		if (!p || g->options.hidden) continue;
+
+		ImGui::PushID(i);
+		if (ImGui::CollapsingHeader(g->description_line().c_str(), ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			uint64_t total = p->ticks(), evals = p->evaluations();
+			ImGui::Text("%llu evaluations, %.1f ticks each", (unsigned long long)evals, evals ? (double)total / evals : 0.0);
+			if (ImGui::BeginTable("Profile Table", 4, table_flags))
+			{
+				ImGui::TableSetupColumn("Time", ImGuiTableColumnFlags_WidthFixed);
+				ImGui::TableSetupColumn("Calls", ImGuiTableColumnFlags_WidthFixed);
+				ImGui::TableSetupColumn("Ticks/Call", ImGuiTableColumnFlags_WidthFixed);
+				ImGui::TableSetupColumn("Subexpression", ImGuiTableColumnFlags_WidthStretch);
+				ImGui::TableHeadersRow();
+				for (const EvalProfile::Row &r : p->rows())
+				{
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn(); ImGui::Text("%.2f%%", total ? 100.0 * r.ticks / total : 0.0);
+					ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)r.count);
+					ImGui::TableNextColumn(); ImGui::Text("%.1f", (double)r.ticks / r.count);
+					ImGui::TableNextColumn(); ImGui::TextWrapped("%s", r.text.c_str());
+				}
+				ImGui::EndTable();
+			}
+		}
+		ImGui::PopID();
+	}
+
+	ImGui::End();
+}
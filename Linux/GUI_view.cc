@@ -28,6 +28,7 @@ struct GUI_ViewMenu : public GUI_Menu
 		ImGui::MenuItem("Show Top Panel",  "CTRL-F1", &gui.show_top_panel);
 		ImGui::MenuItem("Show Side Panel", "CTRL-F2", &gui.show_side_panel);
 		ImGui::MenuItem("Show Help",       "CTRL-F3", &gui.show_help_panel);
+		ImGui::MenuItem("Show Profile",    NULL,      &gui.show_profile_panel);
 
 		#ifdef DEBUG
 		ImGui::MenuItem("Show Demo Window", NULL, &gui.show_demo_window);
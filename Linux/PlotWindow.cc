@@ -451,7 +451,7 @@ void PlotWindow::draw()
 	status();
 	GL_CHECK;
 
-	need_redraw = !plot.at_full_quality();
+	need_redraw = !plot.at_full_quality() || rm.pending();
 }
 
 void PlotWindow::translate(double dx, double dy, double dz, PlotWindow::Zoom what, int mx, int my)
@@ -483,16 +483,16 @@ void PlotWindow::translate(double dx, double dy, double dz, PlotWindow::Zoom wha
 			undoForAxis();
 			axis.move(-dx, dy, 0.0);
  
-			// zoom with dz, but keep (mx,my) where it is
+			// zoom with dz, but keep (mx,my) where it is (relative to the center, which would be lost in deep zooms)
 			double x0 = 2.0 * mx / (w-1) - 1.0; // [-1,1]
 			double y0 = 2.0 * (h-1-my) / (h-1) - 1.0;
-			double x1 = (x0 * axis.range(0)) + axis.center(0);
-			double y1 = (y0 * axis.range(1)) + axis.center(1);
-			axis.zoom(f);
+			double x1 = x0 * axis.range(0);
+			double y1 = y0 * axis.range(1);
+			axis.zoom(f, plot.deep_zoom());
 			if (w > 1 && h > 1 && mx >= 0 && my >= 0 && mx < w && my < h)
 			{
-				double x2 = (x0 * axis.range(0)) + axis.center(0);
-				double y2 = (y0 * axis.range(1)) + axis.center(1);
+				double x2 = x0 * axis.range(0);
+				double y2 = y0 * axis.range(1);
 				axis.move(x1-x2, y1-y2, 0.0);
 			}
 
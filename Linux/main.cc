@@ -2,6 +2,9 @@
 #include "PlotWindow.h"
 #include "../Utility/Preferences.h"
 #include "GUI.h"
+#include "Document.h"
+#include "../Graphs/OpenGL/GL_Export.h"
+#include <fstream>
 #include <SDL.h>
 #include <SDL_opengl.h>
 
@@ -16,15 +19,137 @@ static void signalHandler(int)
 	SDL_PushEvent(&e);
 }
 
+static void usage(const char *arg0)
+{
+	printf("Usage: %s [FILE]\n"
+	       "       %s --export OUTPUT [--quality Q] [--threads N] [--size WxH] [--profile TXT] FILE\n"
+	       "\n"
+	       "--export writes the graphs of FILE without opening a window. The extension of OUTPUT\n"
+	       "selects the format: .ply, .obj or .stl for the geometry of all visible graphs, plus\n"
+	       "OUTPUT.png for the images of color graphs (.png to write only those). Riemann color\n"
+	       "graphs get texture coordinates, and .obj files an OUTPUT.mtl that maps their texture.\n"
+	       "The preferences are the built-in defaults, not the ones of the interactive mode.\n"
+	       "  --quality Q  0 < Q <= 1, scales every graph's quality setting (default 1)\n"
+	       "  --threads N  number of threads (default: one per core)\n"
+	       "  --size WxH   size of the virtual window in pixels (default 1280x720)\n"
+	       "  --profile TXT  write the time spent in every part of the graphs' expressions to TXT\n", arg0, arg0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// headless mode: load, update, export
+//----------------------------------------------------------------------------------------------------------------------
+
+static int export_main(const char *arg0, int argc, char *argv[])
+{
+	const char *out = NULL, *file = NULL, *profile = NULL;
+	double quality = 1.0;
+	int threads = -1, W = 1280, H = 720;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const char *a = argv[i];
+		bool arg = (i+1 < argc);
+		if      (arg && !strcmp(a, "--export"))  out = argv[++i];
+		else if (arg && !strcmp(a, "--quality")) quality = atof(argv[++i]);
+		else if (arg && !strcmp(a, "--threads")) threads = atoi(argv[++i]);
+		else if (arg && !strcmp(a, "--profile")) profile = argv[++i];
+		else if (arg && !strcmp(a, "--size") && sscanf(argv[++i], "%dx%d", &W, &H) == 2){ }
+		else if (*a != '-' && !file) file = a;
+		else
+		{
+			fprintf(stderr, "%s: invalid argument: %s\n", arg0, a);
+			return 1;
+		}
+	}
+
+	GL_Export::Format format;
+	if (!out || !file || W <= 0 || H <= 0 || !(quality > 0.0 && quality <= 1.0))
+	{
+		usage(arg0);
+		return 1;
+	}
+	if (!GL_Export::format(out, format))
+	{
+		fprintf(stderr, "%s: unknown output format: %s\n", arg0, out);
+		return 1;
+	}
+	if (threads < 1 || threads > 256) threads = n_cores;
+
+	// exports must not change with the interactive settings, so cplot.ini is not loaded (or written)
+	Preferences::dynamic(true);
+	Preferences::draftPrecision(false);
+	Preferences::drawNormals(false);
+	Preferences::depthSort(true);
+	Preferences::textureFiltering(false);
+	Preferences::colorSamples(1);
+	Preferences::fuseGraphs(true);
+	Preferences::profileExpressions(profile != NULL);
+	Preferences::threads(-1);
+
+	try
+	{
+		Document doc;
+		Plot &plot = doc.plot;
+		doc.load(file);
+		plot.camera.viewport(W, H, plot.axis);
+		plot.update_axis();
+		plot.update(CH_UNKNOWN);
+
+		double t0 = now();
+		size_t updated = plot.update_graphs(threads, quality);
+		double dt = now() - t0;
+
+		GL_Export e;
+		for (int i = 0, n = plot.number_of_graphs(); i < n; ++i)
+		{
+			const Graph *g = plot.graph(i);
+			if (g->options.hidden) continue;
+			const GL_Graph *gl = g->gl_graph();
+			if (gl) gl->export_geometry(e);
+		}
+		if (e.empty() || (format == GL_Export::PNG && !e.num_images()))
+		{
+			fprintf(stderr, "%s: nothing to export\n", arg0);
+			return 2;
+		}
+		e.write(out, format);
+		if (profile)
+		{
+			std::ofstream f(profile);
+			plot.print_profile(f);
+			if (!f) throw std::runtime_error(std::string("error writing ") + profile);
+		}
+
+		printf("%zu graphs updated in %.3f s: %zu vertexes, %zu triangles, %zu line segments, %zu images\n",
+		       updated, dt, e.num_vertexes(), e.num_triangles(), e.num_segments(), e.num_images());
+	}
+	catch(std::exception &ex)
+	{
+		fprintf(stderr, "%s: %s\n", arg0, ex.what());
+		return 2;
+	}
+	return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// interactive mode
+//----------------------------------------------------------------------------------------------------------------------
+
 int main(int argc, char *argv[])
 {
 	const char *arg0 = argv[0]; // program name without path
 	for (const char *s = arg0; *s; ++s) if (*s == '/') arg0 = s+1;
 	const char *file_arg = NULL;
 	
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--export")) continue;
+		return export_main(arg0, argc, argv);
+	}
+
 	if (argc > 2 || (argc == 2 && (!strcasecmp(argv[1], "--help") || !strcmp(argv[1], "-h"))))
 	{
-		printf("Usage: %s [FILE]\n", arg0);
+		usage(arg0);
 		return 1;
 	}
 	if (argc == 2 && (!strcmp(argv[1], "--version") || !strcmp(argv[1], "-v")))
@@ -13,7 +13,7 @@
 #define FILE_VERSION_1_9  0x00010009U
 #define FILE_VERSION_1_10 0x0001000AU
 #define FILE_VERSION_1_11 0x0001000BU
-#define CURRENT_VERSION  FILE_VERSION_1_10
+#define CURRENT_VERSION  FILE_VERSION_1_11 // axis center in double-double precision
 
 inline const char *version_string(unsigned v)
 {
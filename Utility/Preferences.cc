@@ -9,11 +9,16 @@ static bool have_changes = false; // were any defaults changed?
 
 static bool normals_   = false;
 static bool dynamic_   = true;
+static bool draft_     = false;
 static bool depthSort_ = true;
+static bool texFilter_ = false;
+static int  colorAA_   = 1;
+static bool fuse_      = true;
 static bool showFPS_   = false;
 static bool vsync_     = true;
 static int  fps_       = 60;
 static int  threads_   = -1;
+static bool profile_   = false; // not stored
 const int n_cores = (int)std::thread::hardware_concurrency();
 
 namespace Preferences
@@ -43,11 +48,16 @@ namespace Preferences
 	{
 		normals_   = false;
 		dynamic_   = true;
+		draft_     = false;
 		depthSort_ = true;
+		texFilter_ = false;
+		colorAA_   = 1;
+		fuse_      = true;
 		showFPS_   = false;
 		vsync_     = true;
 		fps_       = 60;
 		threads_   = -1;
+		profile_   = false;
 		load(); have_changes = false;
 		return true;
 	}
@@ -58,6 +68,9 @@ namespace Preferences
 	bool dynamic() { return dynamic_; }
 	void dynamic(bool value) { SET(dynamic_); }
 
+	bool draftPrecision() { return draft_; }
+	void draftPrecision(bool value) { SET(draft_); }
+
 	bool drawNormals() { return normals_; }
 	void drawNormals(bool value) { SET(normals_); }
 
@@ -73,6 +86,18 @@ namespace Preferences
 	bool depthSort() { return depthSort_; }
 	void depthSort(bool value) { SET(depthSort_); }
 
+	bool textureFiltering() { return texFilter_; }
+	void textureFiltering(bool value) { SET(texFilter_); }
+
+	int  colorSamples() { return colorAA_ == 4 || colorAA_ == 8 ? colorAA_ : 1; }
+	void colorSamples(int value) { SET(colorAA_); }
+
+	bool fuseGraphs() { return fuse_; }
+	void fuseGraphs(bool value) { SET(fuse_); }
+
+	bool profileExpressions() { return profile_; }
+	void profileExpressions(bool value) { profile_ = value; }
+
 	int  threads(bool effective)
 	{
 		if (!effective) return threads_;
@@ -171,7 +196,11 @@ static bool load()
 		const char *v = value.c_str();
 		if      (key == "normals"  ) parse(v, normals_);
 		else if (key == "dynamic"  ) parse(v, dynamic_);
+		else if (key == "draft"    ) parse(v, draft_);
 		else if (key == "depthSort") parse(v, depthSort_);
+		else if (key == "texFilter") parse(v, texFilter_);
+		else if (key == "colorAA"  ) parse(v, colorAA_);
+		else if (key == "fuse"     ) parse(v, fuse_);
 		else if (key == "threads"  ) parse(v, threads_);
 		else if (key == "showFPS"  ) parse(v, showFPS_);
 		else if (key == "vsync"    ) parse(v, vsync_);
@@ -199,7 +228,11 @@ static bool save()
 	fprintf(file, "# auto-generated - file will be overwritten by preference dialog!\n");
 	fprintf(file, "normals=%s\n", normals_ ? "on" : "off");
 	fprintf(file, "dynamic=%s\n", dynamic_ ? "on" : "off");
+	fprintf(file, "draft=%s\n", draft_ ? "on" : "off");
 	fprintf(file, "depthSort=%s\n", depthSort_ ? "on" : "off");
+	fprintf(file, "texFilter=%s\n", texFilter_ ? "on" : "off");
+	fprintf(file, "colorAA=%d\n", colorAA_);
+	fprintf(file, "fuse=%s\n", fuse_ ? "on" : "off");
 	fprintf(file, "showFPS=%s\n", showFPS_ ? "on" : "off");
 	fprintf(file, "fps=%d\n", fps_);
 	fprintf(file, "vsync=%s\n", vsync_ ? "on" : "off");
@@ -61,9 +61,13 @@ enum
 	PREF_SLIDEBACK,
 	PREF_NORMALS,
 	PREF_DSORT,
-	PREF_THREADS
+	PREF_THREADS,
+	PREF_TEXFILTER,
+	PREF_COLORAA,
+	PREF_FUSE,
+	PREF_DRAFT
 };
-#define NPREFS 5
+#define NPREFS 9
 
 struct Prefs
 {
@@ -77,6 +81,10 @@ struct Prefs
 		cache.emplace_back(key, "normals",    false);
 		cache.emplace_back(key, "depth_sort", false);
 		cache.emplace_back(key, "threads",    -1);
+		cache.emplace_back(key, "tex_filter", false);
+		cache.emplace_back(key, "color_aa",   1);
+		cache.emplace_back(key, "fuse",       true);
+		cache.emplace_back(key, "draft",      false);
 		RegCloseKey(key);
 	}
 
@@ -120,6 +128,9 @@ namespace Preferences
 	bool dynamic() { return prefs[PREF_DYNAMIC].int_value; }
 	void dynamic(bool value) { prefs[PREF_DYNAMIC].set(!!value); }
 
+	bool draftPrecision() { return prefs[PREF_DRAFT].int_value; }
+	void draftPrecision(bool value) { prefs[PREF_DRAFT].set(!!value); }
+
 	bool slideback() { return prefs[PREF_SLIDEBACK].int_value; }
 	void slideback(bool value) { prefs[PREF_SLIDEBACK].set(!!value); }
 
@@ -128,6 +139,23 @@ namespace Preferences
 
 	bool depthSort() { return prefs[PREF_DSORT].int_value; }
 	void depthSort(bool value) { prefs[PREF_DSORT].set(!!value); }
+
+	bool textureFiltering() { return prefs[PREF_TEXFILTER].int_value; }
+	void textureFiltering(bool value) { prefs[PREF_TEXFILTER].set(!!value); }
+
+	int  colorSamples()
+	{
+		int n = prefs[PREF_COLORAA].int_value;
+		return n == 4 || n == 8 ? n : 1;
+	}
+	void colorSamples(int n) { prefs[PREF_COLORAA].set(n); }
+
+	bool fuseGraphs() { return prefs[PREF_FUSE].int_value; }
+	void fuseGraphs(bool value) { prefs[PREF_FUSE].set(!!value); }
+	
+	static bool profile_ = false; // not stored
+	bool profileExpressions() { return profile_; }
+	void profileExpressions(bool value) { profile_ = value; }
 	
 	int  threads(int effective)
 	{
@@ -17,6 +17,9 @@ namespace Preferences
 	bool dynamic(); // reduce quality during animation? 
 	void dynamic(bool value);
 
+	bool draftPrecision(); // use fast approximations of the elementary functions during animation?
+	void draftPrecision(bool value);
+
 	#ifdef _WIN32
 	bool slideback(); // delta sliders animate their return to center?
 	void slideback(bool value);
@@ -41,6 +44,18 @@ namespace Preferences
 	bool depthSort();
 	void depthSort(bool value);
 
+	bool textureFiltering(); // bilinear texture lookup for color graphs?
+	void textureFiltering(bool value);
+
+	int  colorSamples(); // samples per edge pixel for color graph antialiasing (1 = off, 4 or 8)
+	void colorSamples(int n);
+
+	bool fuseGraphs(); // evaluate graphs on identical grids together?
+	void fuseGraphs(bool value);
+
+	bool profileExpressions(); // collect EvalProfiles for all graphs? (not persistent)
+	void profileExpressions(bool value);
+
 	int  threads(bool effective = true); // number of threads, -1 for num threads = num cores
 	void threads(int n);
 };
@@ -271,6 +271,7 @@ void PlotView::OnPaint()
 
 	glFinish();
 	SwapBuffers(wglGetCurrentDC());
+	if (rm->pending()) Invalidate();
 }
 
 void PlotView::OnSize(UINT nType, int w, int h)
@@ -418,13 +419,13 @@ void PlotView::zoom(double dy, int flags)
 				CPoint p; GetCursorPos(&p); ScreenToClient(&p);
 				double x0 = 2.0 * (p.x - bounds.left) / bounds.Width() - 1.0; // [-1,1]
 				double y0 = 2.0 * (p.y - bounds.top) / bounds.Height() - 1.0;
-				double x1 = (x0 * axis.range(0)) + axis.center(0);
-				double y1 = (y0 * axis.range(1)) + axis.center(1);
-				axis.zoom(f);
+				double x1 = x0 * axis.range(0); // relative to the center, for deep zooms
+				double y1 = y0 * axis.range(1);
+				axis.zoom(f, plot.deep_zoom());
 				if (fabs(x0) < 0.9 && fabs(y0) < 0.9 * bounds.Height() / bounds.Width())
 				{
-					double x2 = (x0 * axis.range(0)) + axis.center(0);
-					double y2 = (y0 * axis.range(1)) + axis.center(1);
+					double x2 = x0 * axis.range(0);
+					double y2 = y0 * axis.range(1);
 					axis.move(x1 - x2, y1 - y2, 0.0);
 				}
 				plot.update(CH_AXIS_RANGE);